@@ -1,5 +1,5 @@
 # FindFFmpeg.cmake
-# Find FFmpeg libraries (avcodec, avutil, swscale)
+# Find FFmpeg libraries (avcodec, avformat, avutil, swscale)
 
 include(FindPackageHandleStandardArgs)
 
@@ -25,6 +25,13 @@ if(WIN32)
     PATH_SUFFIXES lib bin
   )
 
+  find_library(
+    AVFORMAT_LIBRARY
+    NAMES avformat avformat-61 avformat-60 avformat-59 avformat-58
+    PATHS ${_FFMPEG_SEARCH_PATHS}
+    PATH_SUFFIXES lib bin
+  )
+
   find_library(
     AVUTIL_LIBRARY
     NAMES avutil avutil-59 avutil-58 avutil-57 avutil-56
@@ -53,6 +60,8 @@ elseif(APPLE)
 
   find_library(AVCODEC_LIBRARY NAMES avcodec PATHS ${_FFMPEG_SEARCH_PATHS} PATH_SUFFIXES lib)
 
+  find_library(AVFORMAT_LIBRARY NAMES avformat PATHS ${_FFMPEG_SEARCH_PATHS} PATH_SUFFIXES lib)
+
   find_library(AVUTIL_LIBRARY NAMES avutil PATHS ${_FFMPEG_SEARCH_PATHS} PATH_SUFFIXES lib)
 
   find_library(SWSCALE_LIBRARY NAMES swscale PATHS ${_FFMPEG_SEARCH_PATHS} PATH_SUFFIXES lib)
@@ -61,6 +70,7 @@ else()
   find_package(PkgConfig QUIET)
   if(PkgConfig_FOUND)
     pkg_check_modules(PC_AVCODEC QUIET libavcodec)
+    pkg_check_modules(PC_AVFORMAT QUIET libavformat)
     pkg_check_modules(PC_AVUTIL QUIET libavutil)
     pkg_check_modules(PC_SWSCALE QUIET libswscale)
   endif()
@@ -79,6 +89,13 @@ else()
     PATHS /usr/lib /usr/lib/x86_64-linux-gnu /usr/local/lib
   )
 
+  find_library(
+    AVFORMAT_LIBRARY
+    NAMES avformat
+    HINTS ${PC_AVFORMAT_LIBDIR} ${PC_AVFORMAT_LIBRARY_DIRS}
+    PATHS /usr/lib /usr/lib/x86_64-linux-gnu /usr/local/lib
+  )
+
   find_library(
     AVUTIL_LIBRARY
     NAMES avutil
@@ -98,17 +115,18 @@ endif()
 message(STATUS "FFmpeg search paths: ${_FFMPEG_SEARCH_PATHS}")
 message(STATUS "AVCODEC_INCLUDE_DIR: ${AVCODEC_INCLUDE_DIR}")
 message(STATUS "AVCODEC_LIBRARY: ${AVCODEC_LIBRARY}")
+message(STATUS "AVFORMAT_LIBRARY: ${AVFORMAT_LIBRARY}")
 message(STATUS "AVUTIL_LIBRARY: ${AVUTIL_LIBRARY}")
 message(STATUS "SWSCALE_LIBRARY: ${SWSCALE_LIBRARY}")
 
 find_package_handle_standard_args(
   FFmpeg
-  REQUIRED_VARS AVCODEC_LIBRARY AVUTIL_LIBRARY SWSCALE_LIBRARY AVCODEC_INCLUDE_DIR
+  REQUIRED_VARS AVCODEC_LIBRARY AVFORMAT_LIBRARY AVUTIL_LIBRARY SWSCALE_LIBRARY AVCODEC_INCLUDE_DIR
 )
 
 if(FFmpeg_FOUND)
   set(FFmpeg_INCLUDE_DIRS ${AVCODEC_INCLUDE_DIR})
-  set(FFmpeg_LIBRARIES ${AVCODEC_LIBRARY} ${AVUTIL_LIBRARY} ${SWSCALE_LIBRARY})
+  set(FFmpeg_LIBRARIES ${AVCODEC_LIBRARY} ${AVFORMAT_LIBRARY} ${AVUTIL_LIBRARY} ${SWSCALE_LIBRARY})
 
   if(NOT TARGET FFmpeg::avcodec)
     add_library(FFmpeg::avcodec UNKNOWN IMPORTED)
@@ -118,6 +136,14 @@ if(FFmpeg_FOUND)
     )
   endif()
 
+  if(NOT TARGET FFmpeg::avformat)
+    add_library(FFmpeg::avformat UNKNOWN IMPORTED)
+    set_target_properties(
+      FFmpeg::avformat
+      PROPERTIES IMPORTED_LOCATION "${AVFORMAT_LIBRARY}" INTERFACE_INCLUDE_DIRECTORIES "${AVCODEC_INCLUDE_DIR}"
+    )
+  endif()
+
   if(NOT TARGET FFmpeg::avutil)
     add_library(FFmpeg::avutil UNKNOWN IMPORTED)
     set_target_properties(
@@ -135,4 +161,4 @@ if(FFmpeg_FOUND)
   endif()
 endif()
 
-mark_as_advanced(AVCODEC_INCLUDE_DIR AVCODEC_LIBRARY AVUTIL_LIBRARY SWSCALE_LIBRARY)
+mark_as_advanced(AVCODEC_INCLUDE_DIR AVCODEC_LIBRARY AVFORMAT_LIBRARY AVUTIL_LIBRARY SWSCALE_LIBRARY)
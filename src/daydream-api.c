@@ -3,6 +3,7 @@
 #include <curl/curl.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stddef.h>
 
 #define DAYDREAM_API_BASE "https://api.daydream.live/v1"
 
@@ -132,6 +133,85 @@ void daydream_api_cleanup(void)
 	curl_global_cleanup();
 }
 
+// ControlNets each model family accepts, in the order the pipeline expects them. Scales are read from
+// struct daydream_controlnet_params at scale_offset.
+struct controlnet_def {
+	const char *model_id;
+	const char *preprocessor;
+	size_t scale_offset;
+};
+
+#define CONTROLNET(model_id, preprocessor, field) \
+	{model_id, preprocessor, offsetof(struct daydream_controlnet_params, field)}
+
+// SD Turbo (SD2.1): openpose, hed, canny, depth, color
+static const struct controlnet_def sd21_controlnets[] = {
+	CONTROLNET("thibaud/controlnet-sd21-depth-diffusers", "depth_tensorrt", depth_scale),
+	CONTROLNET("thibaud/controlnet-sd21-canny-diffusers", "canny", canny_scale),
+	CONTROLNET("thibaud/controlnet-sd21-hed-diffusers", "hed", hed_scale),
+	CONTROLNET("thibaud/controlnet-sd21-openpose-diffusers", "openpose", openpose_scale),
+	CONTROLNET("thibaud/controlnet-sd21-color-diffusers", "passthrough", color_scale),
+};
+
+// SDXL Turbo: depth, canny, tile
+static const struct controlnet_def sdxl_controlnets[] = {
+	CONTROLNET("xinsir/controlnet-depth-sdxl-1.0", "depth_tensorrt", depth_scale),
+	CONTROLNET("xinsir/controlnet-canny-sdxl-1.0", "canny", canny_scale),
+	CONTROLNET("xinsir/controlnet-tile-sdxl-1.0", "feedback", tile_scale),
+};
+
+// SD1.5 models (Dreamshaper 8, Openjourney v4): depth, canny, tile
+static const struct controlnet_def sd15_controlnets[] = {
+	CONTROLNET("lllyasviel/control_v11f1p_sd15_depth", "depth_tensorrt", depth_scale),
+	CONTROLNET("lllyasviel/control_v11p_sd15_canny", "canny", canny_scale),
+	CONTROLNET("lllyasviel/control_v11f1e_sd15_tile", "feedback", tile_scale),
+};
+
+// DAYDREAM_CONTROLNET_MIN_SCALE is the smallest scale that prints as 0.01. ControlNets below it stay in
+// the list, so the list keeps the same shape across live updates, but are sent disabled.
+
+static const struct controlnet_def *find_controlnets(const char *model_id, size_t *count)
+{
+	const char *model = model_id ? model_id : "";
+	if (strcmp(model, "stabilityai/sd-turbo") == 0) {
+		*count = sizeof(sd21_controlnets) / sizeof(sd21_controlnets[0]);
+		return sd21_controlnets;
+	}
+	if (strcmp(model, "stabilityai/sdxl-turbo") == 0) {
+		*count = sizeof(sdxl_controlnets) / sizeof(sdxl_controlnets[0]);
+		return sdxl_controlnets;
+	}
+	*count = sizeof(sd15_controlnets) / sizeof(sd15_controlnets[0]);
+	return sd15_controlnets;
+}
+
+size_t daydream_api_controlnet_fields(const char *model_id, size_t offsets[], size_t max)
+{
+	size_t count;
+	const struct controlnet_def *defs = find_controlnets(model_id, &count);
+	for (size_t i = 0; i < count && i < max; i++)
+		offsets[i] = defs[i].scale_offset;
+	return count < max ? count : max;
+}
+
+static void format_controlnets(char *buf, size_t size, const struct daydream_stream_params *params)
+{
+	size_t count;
+	const struct controlnet_def *defs = find_controlnets(params->model_id, &count);
+
+	size_t len = (size_t)snprintf(buf, size, "[");
+	for (size_t i = 0; i < count && len < size; i++) {
+		float scale = *(const float *)((const char *)&params->controlnets + defs[i].scale_offset);
+		len += (size_t)snprintf(buf + len, size - len,
+					"%s{\"model_id\":\"%s\",\"conditioning_scale\":%.2f,\"preprocessor\":\"%s\","
+					"\"preprocessor_params\":{},\"enabled\":%s}",
+					i > 0 ? "," : "", defs[i].model_id, scale, defs[i].preprocessor,
+					scale >= DAYDREAM_CONTROLNET_MIN_SCALE ? "true" : "false");
+	}
+	if (len < size)
+		snprintf(buf + len, size - len, "]");
+}
+
 struct daydream_stream_result daydream_api_create_stream(const char *api_key,
 							 const struct daydream_stream_params *params)
 {
@@ -161,55 +241,8 @@ struct daydream_stream_result daydream_api_create_stream(const char *api_key,
 		goto cleanup;
 	}
 
-	// Build ControlNets array based on model
 	char controlnets_json[2048];
-	const char *model = params->model_id ? params->model_id : "";
-
-	if (strcmp(model, "stabilityai/sd-turbo") == 0) {
-		// SD Turbo (SD2.1): openpose, hed, canny, depth, color
-		snprintf(controlnets_json, sizeof(controlnets_json),
-			 "["
-			 "{\"model_id\":\"thibaud/controlnet-sd21-depth-diffusers\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"depth_tensorrt\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"thibaud/controlnet-sd21-canny-diffusers\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"canny\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"thibaud/controlnet-sd21-hed-diffusers\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"hed\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"thibaud/controlnet-sd21-openpose-diffusers\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"openpose\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"thibaud/controlnet-sd21-color-diffusers\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"passthrough\",\"preprocessor_params\":{},\"enabled\":true}"
-			 "]",
-			 params->controlnets.depth_scale, params->controlnets.canny_scale,
-			 params->controlnets.hed_scale, params->controlnets.openpose_scale,
-			 params->controlnets.color_scale);
-	} else if (strcmp(model, "stabilityai/sdxl-turbo") == 0) {
-		// SDXL Turbo: depth, canny, tile
-		snprintf(controlnets_json, sizeof(controlnets_json),
-			 "["
-			 "{\"model_id\":\"xinsir/controlnet-depth-sdxl-1.0\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"depth_tensorrt\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"xinsir/controlnet-canny-sdxl-1.0\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"canny\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"xinsir/controlnet-tile-sdxl-1.0\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"feedback\",\"preprocessor_params\":{},\"enabled\":true}"
-			 "]",
-			 params->controlnets.depth_scale, params->controlnets.canny_scale,
-			 params->controlnets.tile_scale);
-	} else {
-		// SD1.5 models (Dreamshaper 8, Openjourney v4): depth, canny, tile
-		snprintf(controlnets_json, sizeof(controlnets_json),
-			 "["
-			 "{\"model_id\":\"lllyasviel/control_v11f1p_sd15_depth\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"depth_tensorrt\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"lllyasviel/control_v11p_sd15_canny\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"canny\",\"preprocessor_params\":{},\"enabled\":true},"
-			 "{\"model_id\":\"lllyasviel/control_v11f1e_sd15_tile\",\"conditioning_scale\":%.2f,"
-			 "\"preprocessor\":\"feedback\",\"preprocessor_params\":{},\"enabled\":true}"
-			 "]",
-			 params->controlnets.depth_scale, params->controlnets.canny_scale,
-			 params->controlnets.tile_scale);
-	}
+	format_controlnets(controlnets_json, sizeof(controlnets_json), params);
 
 	// Build IP Adapter JSON
 	char ip_adapter_json[512];
@@ -380,36 +413,16 @@ cleanup:
 	return result;
 }
 
-bool daydream_api_update_stream(const char *api_key, const char *stream_id, const struct daydream_stream_params *params,
-				uint64_t update_flags)
+char *daydream_api_build_update(const struct daydream_stream_params *params, uint64_t update_flags)
 {
-	if (!api_key || !stream_id || !params || update_flags == 0)
-		return false;
-
-	CURL *curl = NULL;
-	struct curl_slist *headers = NULL;
-	struct response_buffer response = {0};
-	char *json_body = NULL;
-	bool success = false;
-
-	curl = curl_easy_init();
-	if (!curl) {
-		blog(LOG_ERROR, "[Daydream] Failed to initialize curl for update");
-		return false;
-	}
-
-	char auth_header[512];
-	snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", api_key);
-
-	headers = curl_slist_append(headers, auth_header);
-	headers = curl_slist_append(headers, "Content-Type: application/json");
-	headers = curl_slist_append(headers, "x-client-source: obs");
+	if (!params || update_flags == 0)
+		return NULL;
 
 	size_t json_size = 8192;
-	json_body = malloc(json_size);
+	char *json_body = malloc(json_size);
 	if (!json_body) {
 		blog(LOG_ERROR, "[Daydream] Failed to allocate memory for update");
-		goto cleanup;
+		return NULL;
 	}
 
 	// Build JSON body with only changed parameters
@@ -494,53 +507,9 @@ bool daydream_api_update_stream(const char *api_key, const char *stream_id, cons
 
 	// ControlNets
 	if (update_flags & UPDATE_FLAG_CONTROLNETS) {
-		const char *model = params->model_id ? params->model_id : "";
-
-		if (strcmp(model, "stabilityai/sd-turbo") == 0) {
-			ptr += sprintf(
-				ptr,
-				",\"controlnets\":["
-				"{\"model_id\":\"thibaud/controlnet-sd21-depth-diffusers\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"depth_tensorrt\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"thibaud/controlnet-sd21-canny-diffusers\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"canny\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"thibaud/controlnet-sd21-hed-diffusers\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"hed\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"thibaud/controlnet-sd21-openpose-diffusers\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"openpose\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"thibaud/controlnet-sd21-color-diffusers\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"passthrough\",\"preprocessor_params\":{},\"enabled\":true}"
-				"]",
-				params->controlnets.depth_scale, params->controlnets.canny_scale,
-				params->controlnets.hed_scale, params->controlnets.openpose_scale,
-				params->controlnets.color_scale);
-		} else if (strcmp(model, "stabilityai/sdxl-turbo") == 0) {
-			ptr += sprintf(
-				ptr,
-				",\"controlnets\":["
-				"{\"model_id\":\"xinsir/controlnet-depth-sdxl-1.0\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"depth_tensorrt\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"xinsir/controlnet-canny-sdxl-1.0\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"canny\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"xinsir/controlnet-tile-sdxl-1.0\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"feedback\",\"preprocessor_params\":{},\"enabled\":true}"
-				"]",
-				params->controlnets.depth_scale, params->controlnets.canny_scale,
-				params->controlnets.tile_scale);
-		} else {
-			ptr += sprintf(
-				ptr,
-				",\"controlnets\":["
-				"{\"model_id\":\"lllyasviel/control_v11f1p_sd15_depth\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"depth_tensorrt\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"lllyasviel/control_v11p_sd15_canny\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"canny\",\"preprocessor_params\":{},\"enabled\":true},"
-				"{\"model_id\":\"lllyasviel/control_v11f1e_sd15_tile\",\"conditioning_scale\":%.2f,"
-				"\"preprocessor\":\"feedback\",\"preprocessor_params\":{},\"enabled\":true}"
-				"]",
-				params->controlnets.depth_scale, params->controlnets.canny_scale,
-				params->controlnets.tile_scale);
-		}
+		char controlnets_json[2048];
+		format_controlnets(controlnets_json, sizeof(controlnets_json), params);
+		ptr += sprintf(ptr, ",\"controlnets\":%s", controlnets_json);
 	}
 
 	// IP Adapter
@@ -574,6 +543,37 @@ bool daydream_api_update_stream(const char *api_key, const char *stream_id, cons
 
 	ptr += sprintf(ptr, "}}");
 
+	return json_body;
+}
+
+void daydream_api_free_payload(char *payload)
+{
+	free(payload);
+}
+
+bool daydream_api_send_update(const char *api_key, const char *stream_id, const char *json_body)
+{
+	if (!api_key || !stream_id || !json_body)
+		return false;
+
+	CURL *curl = NULL;
+	struct curl_slist *headers = NULL;
+	struct response_buffer response = {0};
+	bool success = false;
+
+	curl = curl_easy_init();
+	if (!curl) {
+		blog(LOG_ERROR, "[Daydream] Failed to initialize curl for update");
+		return false;
+	}
+
+	char auth_header[512];
+	snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", api_key);
+
+	headers = curl_slist_append(headers, auth_header);
+	headers = curl_slist_append(headers, "Content-Type: application/json");
+	headers = curl_slist_append(headers, "x-client-source: obs");
+
 	char url[512];
 	snprintf(url, sizeof(url), "%s/streams/%s", DAYDREAM_API_BASE, stream_id);
 
@@ -585,7 +585,6 @@ bool daydream_api_update_stream(const char *api_key, const char *stream_id, cons
 	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
 	curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
 
-	blog(LOG_INFO, "[Daydream] Updating stream %s with flags 0x%llx", stream_id, (unsigned long long)update_flags);
 	blog(LOG_INFO, "[Daydream] Update JSON: %s", json_body);
 
 	CURLcode res = curl_easy_perform(curl);
@@ -611,14 +610,61 @@ cleanup:
 		curl_easy_cleanup(curl);
 	if (headers)
 		curl_slist_free_all(headers);
-	if (json_body)
-		free(json_body);
 	if (response.data)
 		free(response.data);
 
 	return success;
 }
 
+bool daydream_api_update_stream(const char *api_key, const char *stream_id, const struct daydream_stream_params *params,
+				uint64_t update_flags)
+{
+	if (!api_key || !stream_id || !params || update_flags == 0)
+		return false;
+
+	char *json_body = daydream_api_build_update(params, update_flags);
+	if (!json_body)
+		return false;
+
+	blog(LOG_INFO, "[Daydream] Updating stream %s with flags 0x%llx", stream_id, (unsigned long long)update_flags);
+	bool success = daydream_api_send_update(api_key, stream_id, json_body);
+	free(json_body);
+	return success;
+}
+
+bool daydream_api_prefetch(const char *url, size_t *bytes)
+{
+	if (bytes)
+		*bytes = 0;
+	if (!url || !*url)
+		return false;
+
+	CURL *curl = curl_easy_init();
+	if (!curl)
+		return false;
+
+	struct response_buffer response = {0};
+	curl_easy_setopt(curl, CURLOPT_URL, url);
+	curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_callback);
+	curl_easy_setopt(curl, CURLOPT_WRITEDATA, &response);
+	curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+
+	CURLcode res = curl_easy_perform(curl);
+	long http_code = 0;
+	curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, &http_code);
+	bool success = res == CURLE_OK && http_code == 200;
+	if (success && bytes)
+		*bytes = response.size;
+	else if (!success)
+		blog(LOG_WARNING, "[Daydream] Prefetch of %s failed: %s (HTTP %ld)", url,
+		     res == CURLE_OK ? "bad status" : curl_easy_strerror(res), http_code);
+
+	curl_easy_cleanup(curl);
+	free(response.data);
+	return success;
+}
+
 void daydream_api_free_result(struct daydream_stream_result *result)
 {
 	if (result->stream_id) {
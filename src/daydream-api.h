@@ -33,6 +33,9 @@ struct daydream_controlnet_params {
 	float color_scale;
 };
 
+// Scales below this are sent with the ControlNet disabled, skipping its preprocessor
+#define DAYDREAM_CONTROLNET_MIN_SCALE 0.005f
+
 struct daydream_prompt_schedule {
 	int count;
 	const char *prompts[DAYDREAM_MAX_SCHEDULE_SLOTS];
@@ -94,4 +97,18 @@ struct daydream_stream_result daydream_api_create_stream(const char *api_key,
 bool daydream_api_update_stream(const char *api_key, const char *stream_id, const struct daydream_stream_params *params,
 				uint64_t update_flags);
 
+// The same update in two halves, so a body can be built ahead of time and sent later.
+// build returns the JSON body, or NULL; release it with daydream_api_free_payload.
+char *daydream_api_build_update(const struct daydream_stream_params *params, uint64_t update_flags);
+bool daydream_api_send_update(const char *api_key, const char *stream_id, const char *json_body);
+void daydream_api_free_payload(char *payload);
+
+// GET url and discard the body, to check it is reachable and warm any cache in front of it.
+// bytes, if given, is set to the size fetched.
+bool daydream_api_prefetch(const char *url, size_t *bytes);
+
 void daydream_api_free_result(struct daydream_stream_result *result);
+
+// Offsets into struct daydream_controlnet_params of the scales model_id's ControlNets use, in the order
+// they are sent. Returns how many were written, at most max.
+size_t daydream_api_controlnet_fields(const char *model_id, size_t offsets[], size_t max);
@@ -1,5 +1,6 @@
 #include "daydream-auth.h"
 #include "daydream-api.h"
+#include "daydream-clock.h"
 #include <obs-module.h>
 #include <util/threading.h>
 #include <util/platform.h>
@@ -248,10 +249,10 @@ static void *auth_thread_func(void *data)
 	tv.tv_usec = 0;
 	setsockopt(auth->server_socket, SOL_SOCKET, SO_RCVTIMEO, (const char *)&tv, sizeof(tv));
 
-	time_t start_time = time(NULL);
+	uint64_t deadline_ns = daydream_clock_now_ns() + (uint64_t)AUTH_TIMEOUT_SEC * 1000000000ULL;
 
 	while (!auth->auth_cancelled) {
-		if (time(NULL) - start_time > AUTH_TIMEOUT_SEC) {
+		if (daydream_clock_now_ns() > deadline_ns) {
 			blog(LOG_WARNING, "[Daydream] Auth timeout");
 			if (auth->callback)
 				auth->callback(false, NULL, "Login timeout", auth->callback_userdata);
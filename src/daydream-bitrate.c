@@ -0,0 +1,170 @@
+#include "daydream-bitrate.h"
+#include <obs-module.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+#include <string.h>
+#include <stdio.h>
+#include <time.h>
+
+#define HISTORY_FILE "bitrate-history.json"
+#define HISTORY_MAX_ENTRIES 32
+#define HISTORY_MAX_AGE_S (30 * 24 * 3600)
+
+// Networks change between sessions (other traffic, a different access point on the same subnet),
+// so start a little below the last settled rate and let the controller climb back
+#define HISTORY_START_MARGIN 0.85
+
+static pthread_mutex_t history_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static char *address_prefix(const char *address)
+{
+	if (!address || !*address)
+		return NULL;
+
+	unsigned int a, b, c, d;
+	if (!strchr(address, ':')) {
+		if (sscanf(address, "%u.%u.%u.%u", &a, &b, &c, &d) != 4)
+			return NULL;
+		char key[32];
+		snprintf(key, sizeof(key), "%u.%u.%u.0/24", a, b, c);
+		return bstrdup(key);
+	}
+
+	// First four groups, written as "a:b:c:d::/64". A "::" inside them means the prefix is
+	// compressed, so the whole address is used instead.
+	const char *p = address;
+	for (int groups = 0; groups < 4; groups++) {
+		p = strchr(p, ':');
+		if (!p)
+			return bstrdup(address);
+		p++;
+	}
+	char *key = bstrdup_n(address, (size_t)(p - address));
+	if (strstr(key, "::")) {
+		bfree(key);
+		return bstrdup(address);
+	}
+	struct dstr prefix = {0};
+	dstr_printf(&prefix, "%s:/64", key);
+	bfree(key);
+	return prefix.array;
+}
+
+char *daydream_bitrate_network_key(const char *public_address, const char *local_address)
+{
+	char *public_prefix = address_prefix(public_address);
+	char *local_prefix = address_prefix(local_address);
+	if (!public_prefix)
+		return local_prefix;
+	if (!local_prefix)
+		return public_prefix;
+
+	struct dstr key = {0};
+	dstr_printf(&key, "%s via %s", public_prefix, local_prefix);
+	bfree(public_prefix);
+	bfree(local_prefix);
+	return key.array;
+}
+
+static char *history_path(void)
+{
+	char *dir = obs_module_config_path("");
+	if (dir) {
+		os_mkdirs(dir);
+		bfree(dir);
+	}
+	return obs_module_config_path(HISTORY_FILE);
+}
+
+uint32_t daydream_bitrate_initial(const char *network_key)
+{
+	uint32_t bitrate = DAYDREAM_BITRATE_DEFAULT;
+	if (!network_key)
+		return bitrate;
+
+	pthread_mutex_lock(&history_mutex);
+	char *path = history_path();
+	obs_data_t *history = path ? obs_data_create_from_json_file_safe(path, "bak") : NULL;
+	bfree(path);
+
+	obs_data_array_t *networks = history ? obs_data_get_array(history, "networks") : NULL;
+	size_t count = obs_data_array_count(networks);
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *entry = obs_data_array_item(networks, i);
+		if (strcmp(obs_data_get_string(entry, "key"), network_key) == 0 &&
+		    time(NULL) - (time_t)obs_data_get_int(entry, "updated") < HISTORY_MAX_AGE_S) {
+			double start = (double)obs_data_get_int(entry, "bitrate") * HISTORY_START_MARGIN;
+			if (start < DAYDREAM_BITRATE_MIN)
+				start = DAYDREAM_BITRATE_MIN;
+			if (start > DAYDREAM_BITRATE_MAX)
+				start = DAYDREAM_BITRATE_MAX;
+			bitrate = (uint32_t)start;
+		}
+		obs_data_release(entry);
+	}
+
+	obs_data_array_release(networks);
+	obs_data_release(history);
+	pthread_mutex_unlock(&history_mutex);
+	return bitrate;
+}
+
+void daydream_bitrate_remember(const char *network_key, uint32_t bitrate)
+{
+	if (!network_key || bitrate == 0)
+		return;
+
+	pthread_mutex_lock(&history_mutex);
+	char *path = history_path();
+	if (!path) {
+		pthread_mutex_unlock(&history_mutex);
+		return;
+	}
+
+	obs_data_t *history = obs_data_create_from_json_file_safe(path, "bak");
+	if (!history)
+		history = obs_data_create();
+	obs_data_array_t *networks = obs_data_get_array(history, "networks");
+	if (!networks) {
+		networks = obs_data_array_create();
+		obs_data_set_array(history, "networks", networks);
+	}
+
+	// Replace this network's entry and drop the oldest ones beyond the cap
+	for (size_t i = obs_data_array_count(networks); i > 0; i--) {
+		obs_data_t *entry = obs_data_array_item(networks, i - 1);
+		if (strcmp(obs_data_get_string(entry, "key"), network_key) == 0)
+			obs_data_array_erase(networks, i - 1);
+		obs_data_release(entry);
+	}
+	while (obs_data_array_count(networks) >= HISTORY_MAX_ENTRIES) {
+		size_t oldest = 0;
+		long long oldest_time = 0;
+		for (size_t i = 0; i < obs_data_array_count(networks); i++) {
+			obs_data_t *entry = obs_data_array_item(networks, i);
+			long long updated = obs_data_get_int(entry, "updated");
+			if (i == 0 || updated < oldest_time) {
+				oldest = i;
+				oldest_time = updated;
+			}
+			obs_data_release(entry);
+		}
+		obs_data_array_erase(networks, oldest);
+	}
+
+	obs_data_t *entry = obs_data_create();
+	obs_data_set_string(entry, "key", network_key);
+	obs_data_set_int(entry, "bitrate", bitrate);
+	obs_data_set_int(entry, "updated", (long long)time(NULL));
+	obs_data_array_push_back(networks, entry);
+	obs_data_release(entry);
+
+	if (!obs_data_save_json_safe(history, path, "tmp", "bak"))
+		blog(LOG_WARNING, "[Daydream] Failed to save bitrate history to %s", path);
+
+	obs_data_array_release(networks);
+	obs_data_release(history);
+	bfree(path);
+	pthread_mutex_unlock(&history_mutex);
+}
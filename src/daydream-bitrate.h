@@ -0,0 +1,32 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DAYDREAM_BITRATE_DEFAULT 500000
+#define DAYDREAM_BITRATE_MIN 150000
+#define DAYDREAM_BITRATE_MAX 2500000
+
+// History of the send bitrate each network settled on, kept in bitrate-history.json in the plugin
+// config folder so the next session on that network can start close to it.
+
+// Network identity for the history: the subnet (/24 for IPv4, /64 for IPv6) of public_address, the
+// server-reflexive one, followed by that of local_address. Private subnets like 192.168.1.0/24 repeat
+// across homes, so the LAN prefix alone is only the fallback when there is no public address.
+// Returns a string to bfree, or NULL.
+char *daydream_bitrate_network_key(const char *public_address, const char *local_address);
+
+// Start rate for network_key, a margin below what it last settled on, or DAYDREAM_BITRATE_DEFAULT
+// if the network is unknown or its entry is stale
+uint32_t daydream_bitrate_initial(const char *network_key);
+
+void daydream_bitrate_remember(const char *network_key, uint32_t bitrate);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,151 @@
+#include "daydream-clock.h"
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+
+// Deadlines tracked for next_deadline(); sleepers beyond this still work, they just aren't reported
+#define SIM_MAX_SLEEPERS 32
+
+struct daydream_sim_clock {
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	uint64_t now_ns;
+	bool auto_advance;
+	bool released;
+	int waiters; // Threads inside sim_sleepto's wait; destroy waits for them to leave
+
+	uint64_t deadlines[SIM_MAX_SLEEPERS]; // 0 = free slot
+};
+
+static struct daydream_sim_clock *active_sim = NULL;
+
+static void sim_sleepto(struct daydream_sim_clock *clock, uint64_t target_ns)
+{
+	pthread_mutex_lock(&clock->mutex);
+
+	if (clock->auto_advance) {
+		if (target_ns > clock->now_ns)
+			clock->now_ns = target_ns;
+		pthread_cond_broadcast(&clock->cond);
+		pthread_mutex_unlock(&clock->mutex);
+		return;
+	}
+
+	int slot = -1;
+	for (int i = 0; i < SIM_MAX_SLEEPERS && target_ns > clock->now_ns; i++) {
+		if (clock->deadlines[i] == 0) {
+			clock->deadlines[i] = target_ns;
+			slot = i;
+			break;
+		}
+	}
+
+	clock->waiters++;
+	while (clock->now_ns < target_ns && !clock->released)
+		pthread_cond_wait(&clock->cond, &clock->mutex);
+	clock->waiters--;
+
+	if (slot >= 0)
+		clock->deadlines[slot] = 0;
+	if (clock->released && clock->waiters == 0)
+		pthread_cond_broadcast(&clock->cond);
+	pthread_mutex_unlock(&clock->mutex);
+}
+
+uint64_t daydream_clock_now_ns(void)
+{
+	struct daydream_sim_clock *sim = active_sim;
+	return sim ? daydream_sim_clock_now_ns(sim) : os_gettime_ns();
+}
+
+void daydream_clock_sleepto_ns(uint64_t target_ns)
+{
+	struct daydream_sim_clock *sim = active_sim;
+	if (sim)
+		sim_sleepto(sim, target_ns);
+	else
+		os_sleepto_ns(target_ns);
+}
+
+void daydream_clock_sleep_ms(uint32_t ms)
+{
+	struct daydream_sim_clock *sim = active_sim;
+	if (sim)
+		sim_sleepto(sim, daydream_sim_clock_now_ns(sim) + (uint64_t)ms * 1000000ULL);
+	else
+		os_sleep_ms(ms);
+}
+
+struct daydream_sim_clock *daydream_sim_clock_create(uint64_t start_ns, bool auto_advance)
+{
+	struct daydream_sim_clock *clock = bzalloc(sizeof(struct daydream_sim_clock));
+	pthread_mutex_init(&clock->mutex, NULL);
+	pthread_cond_init(&clock->cond, NULL);
+	clock->now_ns = start_ns;
+	clock->auto_advance = auto_advance;
+	return clock;
+}
+
+void daydream_sim_clock_destroy(struct daydream_sim_clock *clock)
+{
+	if (!clock)
+		return;
+
+	if (active_sim == clock) {
+		blog(LOG_WARNING, "[Daydream Clock] Destroying the active simulated clock, reverting to real time");
+		active_sim = NULL;
+	}
+
+	pthread_mutex_lock(&clock->mutex);
+	clock->released = true;
+	pthread_cond_broadcast(&clock->cond);
+	// Woken sleepers still need the mutex to return from pthread_cond_wait
+	while (clock->waiters > 0)
+		pthread_cond_wait(&clock->cond, &clock->mutex);
+	pthread_mutex_unlock(&clock->mutex);
+
+	pthread_cond_destroy(&clock->cond);
+	pthread_mutex_destroy(&clock->mutex);
+	bfree(clock);
+}
+
+uint64_t daydream_sim_clock_now_ns(struct daydream_sim_clock *clock)
+{
+	pthread_mutex_lock(&clock->mutex);
+	uint64_t now = clock->now_ns;
+	pthread_mutex_unlock(&clock->mutex);
+	return now;
+}
+
+void daydream_sim_clock_advance(struct daydream_sim_clock *clock, uint64_t delta_ns)
+{
+	pthread_mutex_lock(&clock->mutex);
+	clock->now_ns += delta_ns;
+	pthread_cond_broadcast(&clock->cond);
+	pthread_mutex_unlock(&clock->mutex);
+}
+
+uint64_t daydream_sim_clock_next_deadline(struct daydream_sim_clock *clock)
+{
+	uint64_t next = 0;
+
+	pthread_mutex_lock(&clock->mutex);
+	for (int i = 0; i < SIM_MAX_SLEEPERS; i++) {
+		uint64_t deadline = clock->deadlines[i];
+		if (deadline != 0 && (next == 0 || deadline < next))
+			next = deadline;
+	}
+	pthread_mutex_unlock(&clock->mutex);
+	return next;
+}
+
+void daydream_clock_set_simulated(struct daydream_sim_clock *clock)
+{
+	active_sim = clock;
+	blog(LOG_INFO, "[Daydream Clock] Using %s clock", clock ? "simulated" : "real");
+}
+
+bool daydream_clock_is_simulated(void)
+{
+	return active_sim != NULL;
+}
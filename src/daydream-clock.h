@@ -0,0 +1,41 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Time source for pacing, debouncing, retry and timeout logic. Defaults to the
+// real clock (os_gettime_ns / os_sleepto_ns). Tools can install a simulated
+// clock to run session behaviour faster than real time with deterministic
+// results. Switch clocks only while no pipeline objects exist.
+uint64_t daydream_clock_now_ns(void);
+void daydream_clock_sleepto_ns(uint64_t target_ns);
+void daydream_clock_sleep_ms(uint32_t ms);
+
+// Simulated clock. Time only moves when advanced. With auto_advance a sleep
+// jumps time forward to its deadline, which suits single-threaded drivers;
+// without it sleepers block until another thread advances past their deadline.
+struct daydream_sim_clock;
+
+struct daydream_sim_clock *daydream_sim_clock_create(uint64_t start_ns, bool auto_advance);
+
+// Wakes any blocked sleepers and waits for them to return; uninstall the clock first
+void daydream_sim_clock_destroy(struct daydream_sim_clock *clock);
+
+uint64_t daydream_sim_clock_now_ns(struct daydream_sim_clock *clock);
+void daydream_sim_clock_advance(struct daydream_sim_clock *clock, uint64_t delta_ns);
+
+// Earliest deadline a thread is currently blocked on, or 0 if none; lets a
+// driver jump straight to the next event instead of stepping
+uint64_t daydream_sim_clock_next_deadline(struct daydream_sim_clock *clock);
+
+// Route the daydream_clock_* functions through clock, or back to the real clock with NULL
+void daydream_clock_set_simulated(struct daydream_sim_clock *clock);
+bool daydream_clock_is_simulated(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,72 @@
+#include "daydream-codec.h"
+#include "daydream-encoder.h"
+#include "daydream-decoder.h"
+#include <string.h>
+
+// AV1 and VP9 hold up better than H.264 at the bitrates a congested uplink allows; VP8 is last because
+// it is the weakest of the four and rarely hardware accelerated
+static const enum daydream_video_codec auto_order[DAYDREAM_CODEC_COUNT] = {
+	DAYDREAM_CODEC_AV1,
+	DAYDREAM_CODEC_VP9,
+	DAYDREAM_CODEC_H264,
+	DAYDREAM_CODEC_VP8,
+};
+
+const char *daydream_video_codec_name(enum daydream_video_codec codec)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		return "VP8";
+	case DAYDREAM_CODEC_VP9:
+		return "VP9";
+	case DAYDREAM_CODEC_AV1:
+		return "AV1";
+	default:
+		return "H.264";
+	}
+}
+
+bool daydream_video_codec_parse(const char *name, enum daydream_video_codec *codec)
+{
+	static const char *names[DAYDREAM_CODEC_COUNT] = {"h264", "vp8", "vp9", "av1"};
+	if (!name)
+		return false;
+	for (int i = 0; i < DAYDREAM_CODEC_COUNT; i++) {
+		if (strcmp(name, names[i]) == 0) {
+			*codec = (enum daydream_video_codec)i;
+			return true;
+		}
+	}
+	return false;
+}
+
+static bool offer_has(const enum daydream_video_codec *list, size_t count, enum daydream_video_codec codec)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (list[i] == codec)
+			return true;
+	}
+	return false;
+}
+
+size_t daydream_video_codec_offer(const char *preferred, enum daydream_video_codec out[DAYDREAM_CODEC_COUNT])
+{
+	enum daydream_video_codec first;
+	size_t count = 0;
+
+	if (daydream_video_codec_parse(preferred, &first))
+		out[count++] = first;
+	for (int i = 0; i < DAYDREAM_CODEC_COUNT; i++) {
+		if (!offer_has(out, count, auto_order[i]))
+			out[count++] = auto_order[i];
+	}
+
+	// The gateway may pick any of them, so both directions have to work locally
+	size_t kept = 0;
+	for (size_t i = 0; i < count; i++) {
+		if (out[i] == DAYDREAM_CODEC_H264 ||
+		    (daydream_encoder_supports(out[i]) && daydream_decoder_supports(out[i])))
+			out[kept++] = out[i];
+	}
+	return kept;
+}
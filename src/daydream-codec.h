@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Video codecs the pipeline can negotiate. H.264 is the zero value so older configs keep their behavior.
+enum daydream_video_codec {
+	DAYDREAM_CODEC_H264 = 0,
+	DAYDREAM_CODEC_VP8,
+	DAYDREAM_CODEC_VP9,
+	DAYDREAM_CODEC_AV1,
+	DAYDREAM_CODEC_COUNT,
+};
+
+// Display name, e.g. "H.264" or "AV1"
+const char *daydream_video_codec_name(enum daydream_video_codec codec);
+
+// Parses "h264", "vp8", "vp9" or "av1"; returns false for anything else, including "auto"
+bool daydream_video_codec_parse(const char *name, enum daydream_video_codec *codec);
+
+// Codecs to offer in SDP, most preferred first. preferred is "auto" (or NULL) for AV1, VP9, H.264,
+// VP8, or one codec name to put that codec first. Codecs this machine can neither encode nor decode
+// are left out. H.264 is always offered, so there is a fallback every gateway accepts.
+size_t daydream_video_codec_offer(const char *preferred, enum daydream_video_codec out[DAYDREAM_CODEC_COUNT]);
+
+#ifdef __cplusplus
+}
+#endif
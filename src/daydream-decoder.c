@@ -4,6 +4,8 @@
 #include <libavutil/imgutils.h>
 #include <libavutil/hwcontext.h>
 #include <libswscale/swscale.h>
+#include <util/platform.h>
+#include <pthread.h>
 
 struct daydream_decoder {
 	AVCodecContext *codec_ctx;
@@ -22,13 +24,35 @@ struct daydream_decoder {
 
 	uint32_t width;
 	uint32_t height;
+	enum daydream_video_codec codec;
 
 	// BGRA output buffer (for SW fallback only - sws_scale needs output buffer)
 	uint8_t *output_buffer;
 	size_t output_buffer_size;
 	uint32_t output_linesize;
+
+	// Pool bookkeeping
+	uint64_t idle_since_ns;
+	struct daydream_decoder *pool_next;
 };
 
+static const AVCodec *find_decoder(enum daydream_video_codec codec)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		return avcodec_find_decoder(AV_CODEC_ID_VP8);
+	case DAYDREAM_CODEC_VP9:
+		return avcodec_find_decoder(AV_CODEC_ID_VP9);
+	case DAYDREAM_CODEC_AV1: {
+		// FFmpeg's own AV1 decoder only works through a hardware accelerator
+		const AVCodec *dav1d = avcodec_find_decoder_by_name("libdav1d");
+		return dav1d ? dav1d : avcodec_find_decoder_by_name("libaom-av1");
+	}
+	default:
+		return avcodec_find_decoder(AV_CODEC_ID_H264);
+	}
+}
+
 static enum AVPixelFormat get_hw_format(AVCodecContext *ctx, const enum AVPixelFormat *pix_fmts)
 {
 	struct daydream_decoder *decoder = ctx->opaque;
@@ -88,10 +112,11 @@ struct daydream_decoder *daydream_decoder_create(const struct daydream_decoder_c
 	struct daydream_decoder *decoder = bzalloc(sizeof(struct daydream_decoder));
 	decoder->width = config->width;
 	decoder->height = config->height;
+	decoder->codec = config->codec;
 
-	const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+	const AVCodec *codec = find_decoder(config->codec);
 	if (!codec) {
-		blog(LOG_ERROR, "[Daydream Decoder] H.264 decoder not found");
+		blog(LOG_ERROR, "[Daydream Decoder] %s decoder not found", daydream_video_codec_name(config->codec));
 		bfree(decoder);
 		return NULL;
 	}
@@ -160,7 +185,8 @@ struct daydream_decoder *daydream_decoder_create(const struct daydream_decoder_c
 		return NULL;
 	}
 
-	blog(LOG_INFO, "[Daydream Decoder] Created (%s)", decoder->using_hw ? "hardware" : "software");
+	blog(LOG_INFO, "[Daydream Decoder] Created %s decoder (%s, %s)", daydream_video_codec_name(decoder->codec),
+	     codec->name, decoder->using_hw ? "hardware" : "software");
 
 	return decoder;
 }
@@ -188,6 +214,108 @@ void daydream_decoder_destroy(struct daydream_decoder *decoder)
 	bfree(decoder);
 }
 
+// Idle decoders kept for the next session; a hardware decoder holds a device context, so not for long
+#define POOL_MAX_IDLE 2
+#define POOL_IDLE_TIMEOUT_NS (60 * 1000000000ULL)
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct daydream_decoder *pool_head; // Most recently released first
+
+// Unlinks pooled decoders past the first keep, and any idle longer than the timeout; pool_mutex held
+static struct daydream_decoder *pool_detach_stale(uint64_t now_ns, size_t keep)
+{
+	struct daydream_decoder *stale = NULL;
+	struct daydream_decoder **link = &pool_head;
+	size_t kept = 0;
+	while (*link) {
+		struct daydream_decoder *decoder = *link;
+		if (kept >= keep || now_ns - decoder->idle_since_ns >= POOL_IDLE_TIMEOUT_NS) {
+			*link = decoder->pool_next;
+			decoder->pool_next = stale;
+			stale = decoder;
+		} else {
+			link = &decoder->pool_next;
+			kept++;
+		}
+	}
+	return stale;
+}
+
+static void destroy_list(struct daydream_decoder *decoder)
+{
+	while (decoder) {
+		struct daydream_decoder *next = decoder->pool_next;
+		daydream_decoder_destroy(decoder);
+		decoder = next;
+	}
+}
+
+struct daydream_decoder *daydream_decoder_acquire(const struct daydream_decoder_config *config)
+{
+	if (!config)
+		return NULL;
+
+	struct daydream_decoder *decoder = NULL;
+	pthread_mutex_lock(&pool_mutex);
+	for (struct daydream_decoder **link = &pool_head; *link; link = &(*link)->pool_next) {
+		if ((*link)->width == config->width && (*link)->height == config->height &&
+		    (*link)->codec == config->codec) {
+			decoder = *link;
+			*link = decoder->pool_next;
+			decoder->pool_next = NULL;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&pool_mutex);
+
+	if (!decoder)
+		return daydream_decoder_create(config);
+
+	// Drop reference frames from the last session; the new stream starts at a keyframe
+	avcodec_flush_buffers(decoder->codec_ctx);
+	decoder->consecutive_hw_failures = 0;
+	blog(LOG_INFO, "[Daydream Decoder] Reusing pooled decoder (%s)", decoder->using_hw ? "hardware" : "software");
+	return decoder;
+}
+
+void daydream_decoder_release(struct daydream_decoder *decoder)
+{
+	if (!decoder)
+		return;
+	// A failed software fallback leaves no codec context to reuse
+	if (!decoder->codec_ctx) {
+		daydream_decoder_destroy(decoder);
+		return;
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	decoder->idle_since_ns = os_gettime_ns();
+	decoder->pool_next = pool_head;
+	pool_head = decoder;
+	struct daydream_decoder *stale = pool_detach_stale(decoder->idle_since_ns, POOL_MAX_IDLE);
+	pthread_mutex_unlock(&pool_mutex);
+
+	destroy_list(stale);
+}
+
+void daydream_decoder_pool_trim(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	struct daydream_decoder *stale = pool_head ? pool_detach_stale(os_gettime_ns(), POOL_MAX_IDLE) : NULL;
+	pthread_mutex_unlock(&pool_mutex);
+
+	destroy_list(stale);
+}
+
+void daydream_decoder_pool_clear(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	struct daydream_decoder *stale = pool_detach_stale(os_gettime_ns(), 0);
+	pthread_mutex_unlock(&pool_mutex);
+
+	destroy_list(stale);
+}
+
 // Fallback from HW to SW decoder after repeated failures
 static bool fallback_to_sw_decoder(struct daydream_decoder *decoder)
 {
@@ -211,9 +339,10 @@ static bool fallback_to_sw_decoder(struct daydream_decoder *decoder)
 	avcodec_free_context(&decoder->codec_ctx);
 
 	// Reinitialize as software decoder
-	const AVCodec *codec = avcodec_find_decoder(AV_CODEC_ID_H264);
+	const AVCodec *codec = find_decoder(decoder->codec);
 	if (!codec) {
-		blog(LOG_ERROR, "[Daydream Decoder] Failed to find H264 decoder for fallback");
+		blog(LOG_ERROR, "[Daydream Decoder] Failed to find %s decoder for fallback",
+		     daydream_video_codec_name(decoder->codec));
 		return false;
 	}
 
@@ -248,13 +377,13 @@ static bool fallback_to_sw_decoder(struct daydream_decoder *decoder)
 
 #define HW_FAILURE_THRESHOLD 5 // Fallback after 5 consecutive HW transfer failures
 
-bool daydream_decoder_decode(struct daydream_decoder *decoder, const uint8_t *h264_data, size_t size,
+bool daydream_decoder_decode(struct daydream_decoder *decoder, const uint8_t *data, size_t size,
 			     struct daydream_decoded_frame *out_frame)
 {
-	if (!decoder || !h264_data || size == 0 || !out_frame)
+	if (!decoder || !data || size == 0 || !out_frame)
 		return false;
 
-	decoder->packet->data = (uint8_t *)h264_data;
+	decoder->packet->data = (uint8_t *)data;
 	decoder->packet->size = (int)size;
 
 	int ret = avcodec_send_packet(decoder->codec_ctx, decoder->packet);
@@ -367,3 +496,13 @@ bool daydream_decoder_decode(struct daydream_decoder *decoder, const uint8_t *h2
 
 	return true;
 }
+
+enum daydream_video_codec daydream_decoder_get_codec(struct daydream_decoder *decoder)
+{
+	return decoder ? decoder->codec : DAYDREAM_CODEC_H264;
+}
+
+bool daydream_decoder_supports(enum daydream_video_codec codec)
+{
+	return find_decoder(codec) != NULL;
+}
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "daydream-codec.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -13,6 +14,7 @@ struct daydream_decoder;
 struct daydream_decoder_config {
 	uint32_t width;
 	uint32_t height;
+	enum daydream_video_codec codec; // Negotiated through the WHEP SDP
 };
 
 struct daydream_decoded_frame {
@@ -34,9 +36,22 @@ struct daydream_decoded_frame {
 struct daydream_decoder *daydream_decoder_create(const struct daydream_decoder_config *config);
 void daydream_decoder_destroy(struct daydream_decoder *decoder);
 
-bool daydream_decoder_decode(struct daydream_decoder *decoder, const uint8_t *h264_data, size_t size,
+// Per-process pool for the streaming path, as for the encoder: acquire reuses an idle decoder of the
+// same size and codec after flushing it, release returns it to the pool
+struct daydream_decoder *daydream_decoder_acquire(const struct daydream_decoder_config *config);
+void daydream_decoder_release(struct daydream_decoder *decoder);
+void daydream_decoder_pool_trim(void);
+void daydream_decoder_pool_clear(void);
+
+// One access unit: Annex B for H.264, a frame for VP8/VP9, a temporal unit of OBUs for AV1
+bool daydream_decoder_decode(struct daydream_decoder *decoder, const uint8_t *data, size_t size,
 			     struct daydream_decoded_frame *out_frame);
 
+enum daydream_video_codec daydream_decoder_get_codec(struct daydream_decoder *decoder);
+
+// Whether this FFmpeg build can decode codec in software; hardware decoding is used on top when available
+bool daydream_decoder_supports(enum daydream_video_codec codec);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,6 +4,7 @@
 #include <libavutil/opt.h>
 #include <libavutil/imgutils.h>
 #include <libswscale/swscale.h>
+#include <util/platform.h>
 #include <string.h>
 #include <pthread.h>
 
@@ -14,6 +15,22 @@
 #include <CoreMedia/CoreMedia.h>
 #endif
 
+#if defined(DAYDREAM_X264_DIRECT)
+#include <x264.h>
+
+// Cap slices at roughly one RTP payload so each finished slice can leave as a single packet
+#define X264_SLICE_MAX_SIZE 1200
+
+// A slice finished out of macroblock order, waiting for the slices before it
+struct x264_pending_slice {
+	uint8_t *data;
+	size_t size;
+	int first_mb;
+	int last_mb;
+	bool owned; // Heap fallback rather than arena memory
+};
+#endif
+
 // Forward declarations
 #if defined(__APPLE__)
 static bool init_zerocopy_encoder(struct daydream_encoder *encoder, uint32_t bitrate);
@@ -29,6 +46,10 @@ struct daydream_encoder {
 	uint32_t height;
 	uint32_t fps;
 	uint32_t bitrate;
+	enum daydream_video_codec codec;
+	enum daydream_h264_profile profile;
+	enum daydream_rate_control rate_control;
+	const char *codec_name;
 	int64_t frame_count;
 
 	bool request_keyframe;
@@ -56,11 +77,58 @@ struct daydream_encoder {
 
 	uint8_t *output_buffer;
 	size_t output_buffer_size;
+
+	// Pool bookkeeping: the configuration this encoder was acquired for and when it was released
+	struct daydream_encoder_config pool_key;
+	bool poolable;
+	uint64_t idle_since_ns;
+	struct daydream_encoder *pool_next;
+
+#if defined(DAYDREAM_X264_DIRECT)
+	// Direct libx264 path, slices handed out from nalu_process
+	x264_t *x264;
+	x264_picture_t x264_pic;
+	bool using_x264;
+	daydream_encoder_slice_callback on_slice;
+	void *slice_userdata;
+
+	// Per-frame slice state, guarded by slice_mutex (nalu_process runs on x264's slice threads)
+	pthread_mutex_t slice_mutex;
+	uint8_t *nal_arena; // Scratch for x264_nal_encode, reset every frame
+	size_t nal_arena_size;
+	size_t nal_arena_used;
+	struct x264_pending_slice *pending_slices;
+	size_t pending_count;
+	size_t pending_capacity;
+	int next_mb;      // First macroblock of the next slice to emit
+	int total_mbs;    // Macroblocks per frame
+	size_t out_size;  // Bytes of the access unit assembled in output_buffer
+	size_t sent_size; // Bytes of it already handed to on_slice
+	bool slice_is_keyframe;
+#endif
 };
 
-static const AVCodec *find_best_h264_encoder(void)
+#define MAX_CANDIDATES 8
+
+static enum AVCodecID codec_id(enum daydream_video_codec codec)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		return AV_CODEC_ID_VP8;
+	case DAYDREAM_CODEC_VP9:
+		return AV_CODEC_ID_VP9;
+	case DAYDREAM_CODEC_AV1:
+		return AV_CODEC_ID_AV1;
+	default:
+		return AV_CODEC_ID_H264;
+	}
+}
+
+// Encoders for codec in order of preference, hardware first. A hardware encoder can be compiled in without the
+// hardware being present, so create tries each in turn until one opens.
+static size_t find_encoders(enum daydream_video_codec codec, const AVCodec *out[MAX_CANDIDATES])
 {
-	const char *encoder_names[] = {
+	static const char *h264_names[] = {
 #if defined(__APPLE__)
 		"h264_videotoolbox",
 #elif defined(_WIN32)
@@ -69,47 +137,146 @@ static const AVCodec *find_best_h264_encoder(void)
 		"h264_nvenc", "h264_vaapi", "h264_qsv",
 #endif
 		"libx264", NULL};
+	static const char *vp8_names[] = {"libvpx", NULL};
+	static const char *vp9_names[] = {
+#if defined(_WIN32)
+		"vp9_qsv",
+#elif defined(__linux__)
+		"vp9_vaapi", "vp9_qsv",
+#endif
+		"libvpx-vp9", NULL};
+	static const char *av1_names[] = {
+#if defined(_WIN32)
+		"av1_nvenc", "av1_amf", "av1_qsv",
+#elif defined(__linux__)
+		"av1_nvenc", "av1_vaapi", "av1_qsv",
+#endif
+		"libsvtav1", "libaom-av1", NULL};
+
+	const char **names = codec == DAYDREAM_CODEC_VP8   ? vp8_names
+			     : codec == DAYDREAM_CODEC_VP9 ? vp9_names
+			     : codec == DAYDREAM_CODEC_AV1 ? av1_names
+							   : h264_names;
+	size_t count = 0;
+	for (int i = 0; names[i] && count < MAX_CANDIDATES - 1; i++) {
+		const AVCodec *found = avcodec_find_encoder_by_name(names[i]);
+		if (found)
+			out[count++] = found;
+	}
 
-	for (int i = 0; encoder_names[i]; i++) {
-		const AVCodec *codec = avcodec_find_encoder_by_name(encoder_names[i]);
-		if (codec) {
-			blog(LOG_INFO, "[Daydream Encoder] Found encoder: %s", encoder_names[i]);
-			return codec;
-		}
+	if (count == 0) {
+		const AVCodec *fallback = avcodec_find_encoder(codec_id(codec));
+		if (fallback)
+			out[count++] = fallback;
 	}
+	return count;
+}
 
-	return avcodec_find_encoder(AV_CODEC_ID_H264);
+const char *daydream_h264_profile_name(enum daydream_h264_profile profile)
+{
+	switch (profile) {
+	case DAYDREAM_H264_HIGH:
+		return "high";
+	case DAYDREAM_H264_MAIN:
+		return "main";
+	default:
+		return "baseline";
+	}
 }
 
-static void configure_encoder_options(AVCodecContext *ctx, const AVCodec *codec)
+static int keyint_frames(uint32_t fps, uint32_t keyint_ms)
+{
+	// Keyframe every 0.5s by default for faster recovery
+	uint64_t frames = (uint64_t)fps * (keyint_ms ? keyint_ms : 500) / 1000;
+	return frames > 0 ? (int)frames : 1;
+}
+
+static void configure_encoder_options(AVCodecContext *ctx, const AVCodec *codec, enum daydream_h264_profile profile,
+				      const struct daydream_encoder_config *config)
 {
 	const char *name = codec->name;
+	bool nvenc = strcmp(name, "h264_nvenc") == 0 || strcmp(name, "av1_nvenc") == 0;
+	bool crf = strcmp(name, "libx264") == 0 || strcmp(name, "libvpx") == 0 || strcmp(name, "libvpx-vp9") == 0 ||
+		   strcmp(name, "libsvtav1") == 0 || strcmp(name, "libaom-av1") == 0;
+
+	// Every H.264 wrapper names its profile option "profile"; VAAPI and AMF spell baseline differently
+	if (codec->id == AV_CODEC_ID_H264) {
+		const char *profile_name = daydream_h264_profile_name(profile);
+		if (profile == DAYDREAM_H264_BASELINE &&
+		    (strcmp(name, "h264_vaapi") == 0 || strcmp(name, "h264_amf") == 0))
+			profile_name = "constrained_baseline";
+		av_opt_set(ctx->priv_data, "profile", profile_name, 0);
+	}
 
 	if (strcmp(name, "libx264") == 0) {
 		av_opt_set(ctx->priv_data, "preset", "ultrafast", 0);
 		av_opt_set(ctx->priv_data, "tune", "zerolatency", 0);
-		av_opt_set(ctx->priv_data, "profile", "baseline", 0);
 		av_opt_set(ctx->priv_data, "sliced-threads", "1", 0); // Parallel slice encoding
 		av_opt_set(ctx->priv_data, "sync-lookahead", "0", 0); // No lookahead buffer
+		// ultrafast turns off the two tools Main and High add over baseline, CABAC and the 8x8 transform,
+		// which are most of their saving; x264 drops 8x8 again for Main when it applies the profile
+		if (profile != DAYDREAM_H264_BASELINE)
+			av_opt_set(ctx->priv_data, "x264-params", "cabac=1:8x8dct=1", 0);
 	} else if (strcmp(name, "h264_videotoolbox") == 0) {
 		av_opt_set(ctx->priv_data, "realtime", "1", 0);
 		av_opt_set(ctx->priv_data, "allow_sw", "0", 0);
 		av_opt_set(ctx->priv_data, "prio_speed", "1", 0); // Prioritize speed
-	} else if (strcmp(name, "h264_nvenc") == 0) {
+	} else if (strcmp(name, "libvpx") == 0 || strcmp(name, "libvpx-vp9") == 0) {
+		av_opt_set(ctx->priv_data, "deadline", "realtime", 0);
+		av_opt_set(ctx->priv_data, "cpu-used", "8", 0);
+		av_opt_set(ctx->priv_data, "lag-in-frames", "0", 0); // No lookahead buffer
+		av_opt_set(ctx->priv_data, "row-mt", "1", 0);        // VP9 only
+	} else if (strcmp(name, "libsvtav1") == 0) {
+		av_opt_set(ctx->priv_data, "preset", "12", 0);
+		// Low-delay prediction structure; SVT-AV1 only does CBR with it
+		av_opt_set(ctx->priv_data, "svtav1-params",
+			   config->rate_control == DAYDREAM_RC_QUALITY ? "pred-struct=1" : "pred-struct=1:rc=2", 0);
+	} else if (strcmp(name, "libaom-av1") == 0) {
+		av_opt_set(ctx->priv_data, "usage", "realtime", 0);
+		av_opt_set(ctx->priv_data, "cpu-used", "8", 0);
+		av_opt_set(ctx->priv_data, "lag-in-frames", "0", 0);
+		av_opt_set(ctx->priv_data, "row-mt", "1", 0);
+	} else if (nvenc) {
 		av_opt_set(ctx->priv_data, "preset", "p1", 0); // Fastest preset
 		av_opt_set(ctx->priv_data, "tune", "ull", 0);  // Ultra low latency
 		av_opt_set(ctx->priv_data, "rc", "cbr", 0);
 		av_opt_set(ctx->priv_data, "delay", "0", 0); // No delay
 		av_opt_set(ctx->priv_data, "zerolatency", "1", 0);
-	} else if (strcmp(name, "h264_amf") == 0) {
-		av_opt_set(ctx->priv_data, "usage", "ultralowlatency", 0);
+	} else if (strcmp(name, "h264_amf") == 0 || strcmp(name, "av1_amf") == 0) {
+		const char *usage = codec->id == AV_CODEC_ID_H264 ? "ultralowlatency" : "lowlatency";
+		av_opt_set(ctx->priv_data, "usage", usage, 0);
 		av_opt_set(ctx->priv_data, "quality", "speed", 0);
 		av_opt_set(ctx->priv_data, "rc", "cbr", 0);
-	} else if (strcmp(name, "h264_qsv") == 0) {
+	} else if (strcmp(name, "h264_qsv") == 0 || strcmp(name, "vp9_qsv") == 0 || strcmp(name, "av1_qsv") == 0) {
 		av_opt_set(ctx->priv_data, "preset", "veryfast", 0);
 		av_opt_set(ctx->priv_data, "low_power", "1", 0);
 		av_opt_set(ctx->priv_data, "async_depth", "1", 0); // Minimal async depth
 	}
+
+	// Overrides; encoders without the option ignore it
+	if (config->preset)
+		av_opt_set(ctx->priv_data, "preset", config->preset, 0);
+	if (config->intra_refresh)
+		av_opt_set(ctx->priv_data, "intra-refresh", "1", 0);
+
+	if (config->rate_control == DAYDREAM_RC_CBR) {
+		ctx->rc_min_rate = ctx->bit_rate;
+		if (strcmp(name, "libx264") == 0)
+			av_opt_set(ctx->priv_data, "nal-hrd", "cbr", 0);
+	} else if (config->rate_control == DAYDREAM_RC_QUALITY) {
+		ctx->bit_rate = 0;
+		ctx->rc_max_rate = 0;
+		ctx->rc_buffer_size = 0;
+		if (crf) {
+			av_opt_set_int(ctx->priv_data, "crf", config->quality, 0);
+		} else if (nvenc) {
+			av_opt_set(ctx->priv_data, "rc", "vbr", 0);
+			av_opt_set_int(ctx->priv_data, "cq", config->quality, 0);
+		} else {
+			ctx->flags |= AV_CODEC_FLAG_QSCALE;
+			ctx->global_quality = (int)config->quality * FF_QP2LAMBDA;
+		}
+	}
 }
 
 #if defined(__APPLE__)
@@ -157,64 +324,279 @@ static bool init_videotoolbox_encoder(struct daydream_encoder *encoder, const AV
 }
 #endif
 
-struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_config *config)
+#if defined(DAYDREAM_X264_DIRECT)
+// Caller holds slice_mutex
+static void x264_append_output(struct daydream_encoder *encoder, const uint8_t *data, size_t size)
 {
-	if (!config || config->width == 0 || config->height == 0)
-		return NULL;
+	if (encoder->out_size + size > encoder->output_buffer_size) {
+		encoder->output_buffer_size = (encoder->out_size + size) * 2;
+		encoder->output_buffer = brealloc(encoder->output_buffer, encoder->output_buffer_size);
+	}
+	memcpy(encoder->output_buffer + encoder->out_size, data, size);
+	encoder->out_size += size;
+}
 
-	struct daydream_encoder *encoder = bzalloc(sizeof(struct daydream_encoder));
-	encoder->width = config->width;
-	encoder->height = config->height;
-	encoder->fps = config->fps > 0 ? config->fps : 30;
-	encoder->bitrate = config->bitrate > 0 ? config->bitrate : 2000000;
-	encoder->frame_count = 0;
-	encoder->request_keyframe = true;
-	encoder->using_hw = false;
-	encoder->using_zerocopy = false;
+// Caller holds slice_mutex. Hands everything assembled since the last call to on_slice, so parameter
+// sets and SEI travel together with the first slice of the frame.
+static void x264_flush_output(struct daydream_encoder *encoder, bool last_slice)
+{
+	if (encoder->sent_size >= encoder->out_size)
+		return;
 
-#if defined(__APPLE__)
-	// Try zero-copy path first on macOS
-	if (config->use_zerocopy) {
-		uint32_t bitrate = config->bitrate > 0 ? config->bitrate : 2000000;
-		if (init_zerocopy_encoder(encoder, bitrate)) {
-			encoder->using_zerocopy = true;
-			encoder->output_buffer_size = config->width * config->height * 2;
-			encoder->output_buffer = bmalloc(encoder->output_buffer_size);
-			blog(LOG_INFO, "[Daydream Encoder] Created %dx%d @ %d fps, %d kbps (zero-copy)", config->width,
-			     config->height, encoder->fps, bitrate / 1000);
-			return encoder;
+	encoder->on_slice(encoder->output_buffer + encoder->sent_size, encoder->out_size - encoder->sent_size,
+			  encoder->slice_is_keyframe, last_slice, encoder->slice_userdata);
+	encoder->sent_size = encoder->out_size;
+}
+
+// Caller holds slice_mutex
+static void x264_emit_slice(struct daydream_encoder *encoder, const uint8_t *data, size_t size, int last_mb)
+{
+	x264_append_output(encoder, data, size);
+	encoder->next_mb = last_mb + 1;
+	x264_flush_output(encoder, encoder->next_mb >= encoder->total_mbs);
+}
+
+// Caller holds slice_mutex. Emits queued slices that are now next in macroblock order.
+static void x264_drain_pending(struct daydream_encoder *encoder)
+{
+	bool progress = true;
+	while (progress) {
+		progress = false;
+		for (size_t i = 0; i < encoder->pending_count; i++) {
+			struct x264_pending_slice *slice = &encoder->pending_slices[i];
+			if (slice->first_mb != encoder->next_mb)
+				continue;
+
+			x264_emit_slice(encoder, slice->data, slice->size, slice->last_mb);
+			if (slice->owned)
+				bfree(slice->data);
+			encoder->pending_slices[i] = encoder->pending_slices[--encoder->pending_count];
+			progress = true;
+			break;
 		}
-		blog(LOG_INFO, "[Daydream Encoder] Zero-copy init failed, falling back to FFmpeg path");
 	}
-#endif
+}
 
-	const AVCodec *codec = find_best_h264_encoder();
-	if (!codec) {
-		blog(LOG_ERROR, "[Daydream Encoder] H.264 encoder not found");
-		bfree(encoder);
-		return NULL;
+static void x264_nalu_process(x264_t *h, x264_nal_t *nal, void *opaque)
+{
+	struct daydream_encoder *encoder = opaque;
+	size_t needed = (size_t)nal->i_payload * 3 / 2 + 5 + 64; // Worst case documented by x264.h
+
+	pthread_mutex_lock(&encoder->slice_mutex);
+	uint8_t *dst;
+	bool owned = false;
+	if (encoder->nal_arena_used + needed <= encoder->nal_arena_size) {
+		dst = encoder->nal_arena + encoder->nal_arena_used;
+		encoder->nal_arena_used += needed;
+	} else {
+		dst = bmalloc(needed);
+		owned = true;
+	}
+	pthread_mutex_unlock(&encoder->slice_mutex);
+
+	// Escaping runs outside the lock, concurrently with the other slice threads
+	x264_nal_encode(h, dst, nal);
+
+	pthread_mutex_lock(&encoder->slice_mutex);
+
+	bool is_slice = nal->i_type == NAL_SLICE || nal->i_type == NAL_SLICE_IDR;
+	if (nal->i_type == NAL_SLICE_IDR || nal->i_type == NAL_SPS)
+		encoder->slice_is_keyframe = true;
+
+	if (!is_slice) {
+		// Headers and SEI go out with the next slice
+		x264_append_output(encoder, nal->p_payload, (size_t)nal->i_payload);
+	} else if (nal->i_first_mb == encoder->next_mb) {
+		x264_emit_slice(encoder, nal->p_payload, (size_t)nal->i_payload, nal->i_last_mb);
+		x264_drain_pending(encoder);
+	} else {
+		// Sliced threads may finish out of order; hold this one until its predecessors are out
+		if (encoder->pending_count == encoder->pending_capacity) {
+			encoder->pending_capacity = encoder->pending_capacity ? encoder->pending_capacity * 2 : 16;
+			size_t bytes = encoder->pending_capacity * sizeof(struct x264_pending_slice);
+			encoder->pending_slices = brealloc(encoder->pending_slices, bytes);
+		}
+		struct x264_pending_slice *slice = &encoder->pending_slices[encoder->pending_count++];
+		slice->data = nal->p_payload;
+		slice->size = (size_t)nal->i_payload;
+		slice->first_mb = nal->i_first_mb;
+		slice->last_mb = nal->i_last_mb;
+		slice->owned = owned;
+		owned = false;
+	}
+
+	pthread_mutex_unlock(&encoder->slice_mutex);
+
+	if (owned)
+		bfree(dst);
+}
+
+static void x264_apply_bitrate(x264_param_t *param, uint32_t bitrate)
+{
+	param->rc.i_rc_method = X264_RC_ABR;
+	param->rc.i_bitrate = (int)(bitrate / 1000);
+	param->rc.i_vbv_max_bitrate = (int)(bitrate / 1000);
+	param->rc.i_vbv_buffer_size = (int)(bitrate / 4000); // Same small buffer as the libavcodec path
+}
+
+static bool init_x264_encoder(struct daydream_encoder *encoder, const struct daydream_encoder_config *config)
+{
+	x264_param_t param;
+	if (x264_param_default_preset(&param, config->preset ? config->preset : "ultrafast", "zerolatency") < 0)
+		return false;
+
+	// zerolatency already selects sliced threads, no lookahead and no B-frames
+	param.i_width = (int)encoder->width;
+	param.i_height = (int)encoder->height;
+	param.i_csp = X264_CSP_I420;
+	param.i_fps_num = encoder->fps;
+	param.i_fps_den = 1;
+	param.i_keyint_max = keyint_frames(encoder->fps, config->keyint_ms);
+	param.b_intra_refresh = config->intra_refresh;
+	param.b_repeat_headers = 1;
+	param.b_annexb = 1;
+	param.i_slice_max_size = X264_SLICE_MAX_SIZE;
+	param.i_log_level = X264_LOG_WARNING;
+	param.nalu_process = x264_nalu_process;
+
+	// As in configure_encoder_options: Main and High get their coding tools back from ultrafast
+	if (encoder->profile != DAYDREAM_H264_BASELINE) {
+		param.b_cabac = 1;
+		param.analyse.b_transform_8x8 = 1;
+	}
+	if (encoder->rate_control == DAYDREAM_RC_QUALITY) {
+		param.rc.i_rc_method = X264_RC_CRF;
+		param.rc.f_rf_constant = (float)config->quality;
+	} else {
+		x264_apply_bitrate(&param, encoder->bitrate);
+		if (encoder->rate_control == DAYDREAM_RC_CBR)
+			param.i_nal_hrd = X264_NAL_HRD_CBR;
+	}
+
+	if (x264_param_apply_profile(&param, daydream_h264_profile_name(encoder->profile)) < 0) {
+		encoder->profile = DAYDREAM_H264_BASELINE;
+		if (x264_param_apply_profile(&param, "baseline") < 0)
+			return false;
+	}
+
+	encoder->x264 = x264_encoder_open(&param);
+	if (!encoder->x264) {
+		blog(LOG_WARNING, "[Daydream Encoder] Failed to open libx264");
+		return false;
+	}
+
+	if (x264_picture_alloc(&encoder->x264_pic, X264_CSP_I420, param.i_width, param.i_height) < 0) {
+		x264_encoder_close(encoder->x264);
+		encoder->x264 = NULL;
+		return false;
+	}
+
+	encoder->sws_ctx = sws_getContext(encoder->width, encoder->height, AV_PIX_FMT_BGRA, encoder->width,
+					  encoder->height, AV_PIX_FMT_YUV420P, SWS_FAST_BILINEAR, NULL, NULL, NULL);
+	if (!encoder->sws_ctx) {
+		x264_picture_clean(&encoder->x264_pic);
+		x264_encoder_close(encoder->x264);
+		encoder->x264 = NULL;
+		return false;
 	}
 
+	pthread_mutex_init(&encoder->slice_mutex, NULL);
+	encoder->on_slice = config->on_slice;
+	encoder->slice_userdata = config->slice_userdata;
+	encoder->total_mbs = (int)(((encoder->width + 15) / 16) * ((encoder->height + 15) / 16));
+	encoder->nal_arena_size = (size_t)encoder->width * encoder->height * 2;
+	encoder->nal_arena = bmalloc(encoder->nal_arena_size);
+	encoder->output_buffer_size = (size_t)encoder->width * encoder->height * 2;
+	encoder->output_buffer = bmalloc(encoder->output_buffer_size);
+	return true;
+}
+
+static bool encode_x264_frame(struct daydream_encoder *encoder, const uint8_t *bgra_data, uint32_t linesize,
+			      struct daydream_encoded_frame *out_frame)
+{
+	const uint8_t *src_data[1] = {bgra_data};
+	int src_linesize[1] = {(int)linesize};
+
+	sws_scale(encoder->sws_ctx, src_data, src_linesize, 0, encoder->height, encoder->x264_pic.img.plane,
+		  encoder->x264_pic.img.i_stride);
+
+	encoder->x264_pic.i_pts = encoder->frame_count++;
+	encoder->x264_pic.opaque = encoder;
+	encoder->x264_pic.i_type = encoder->request_keyframe ? X264_TYPE_IDR : X264_TYPE_AUTO;
+	encoder->request_keyframe = false;
+
+	pthread_mutex_lock(&encoder->slice_mutex);
+	encoder->nal_arena_used = 0;
+	encoder->next_mb = 0;
+	encoder->out_size = 0;
+	encoder->sent_size = 0;
+	encoder->slice_is_keyframe = false;
+	pthread_mutex_unlock(&encoder->slice_mutex);
+
+	// Slices are delivered from nalu_process before this returns; the returned NAL array is not valid
+	x264_nal_t *nals = NULL;
+	int nal_count = 0;
+	x264_picture_t pic_out;
+	int ret = x264_encoder_encode(encoder->x264, &nals, &nal_count, &encoder->x264_pic, &pic_out);
+	if (ret < 0) {
+		blog(LOG_ERROR, "[Daydream Encoder] libx264 encode failed: %d", ret);
+		return false;
+	}
+
+	pthread_mutex_lock(&encoder->slice_mutex);
+
+	// Anything still queued means a slice went missing; send what we have rather than stall
+	for (size_t i = 0; i < encoder->pending_count; i++) {
+		struct x264_pending_slice *slice = &encoder->pending_slices[i];
+		x264_append_output(encoder, slice->data, slice->size);
+		if (slice->owned)
+			bfree(slice->data);
+	}
+	if (encoder->pending_count > 0) {
+		blog(LOG_WARNING, "[Daydream Encoder] %zu slices left out of order at end of frame",
+		     encoder->pending_count);
+		encoder->pending_count = 0;
+	}
+	x264_flush_output(encoder, true);
+
+	bool have_output = encoder->out_size > 0;
+	out_frame->data = encoder->output_buffer;
+	out_frame->size = encoder->out_size;
+	out_frame->is_keyframe = encoder->slice_is_keyframe;
+	out_frame->pts = encoder->x264_pic.i_pts;
+	out_frame->sent_as_slices = true;
+
+	pthread_mutex_unlock(&encoder->slice_mutex);
+
+	return have_output;
+}
+#endif
+
+// Sets up the FFmpeg path with codec; on failure leaves encoder as it was so the next candidate can be tried
+static bool init_ffmpeg_encoder(struct daydream_encoder *encoder, const AVCodec *codec,
+				const struct daydream_encoder_config *config)
+{
+	encoder->profile = config->profile;
+	encoder->using_hw = false;
+
 	encoder->codec_ctx = avcodec_alloc_context3(codec);
 	if (!encoder->codec_ctx) {
 		blog(LOG_ERROR, "[Daydream Encoder] Failed to allocate codec context");
-		bfree(encoder);
-		return NULL;
+		return false;
 	}
 
 	encoder->codec_ctx->width = config->width;
 	encoder->codec_ctx->height = config->height;
 	encoder->codec_ctx->time_base = (AVRational){1, (int)encoder->fps};
 	encoder->codec_ctx->framerate = (AVRational){(int)encoder->fps, 1};
-	encoder->codec_ctx->gop_size = encoder->fps / 2; // Keyframe every 0.5s for faster recovery
+	encoder->codec_ctx->gop_size = keyint_frames(encoder->fps, config->keyint_ms);
 	encoder->codec_ctx->max_b_frames = 0;
 
-	uint32_t bitrate = config->bitrate > 0 ? config->bitrate : 2000000;
-	encoder->codec_ctx->bit_rate = bitrate;
-	encoder->codec_ctx->rc_max_rate = bitrate;
-	encoder->codec_ctx->rc_buffer_size = bitrate / 4; // Smaller buffer for faster rate control
+	encoder->codec_ctx->bit_rate = encoder->bitrate;
+	encoder->codec_ctx->rc_max_rate = encoder->bitrate;
+	encoder->codec_ctx->rc_buffer_size = encoder->bitrate / 4; // Smaller buffer for faster rate control
 
-	configure_encoder_options(encoder->codec_ctx, codec);
+	configure_encoder_options(encoder->codec_ctx, codec, encoder->profile, config);
 
 #if defined(__APPLE__)
 	// Try hardware encoder with direct BGRA input
@@ -228,8 +610,17 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 		encoder->codec_ctx->pix_fmt = AV_PIX_FMT_YUV420P;
 	}
 
-	if (avcodec_open2(encoder->codec_ctx, codec, NULL) < 0) {
-		blog(LOG_ERROR, "[Daydream Encoder] Failed to open codec");
+	int open_ret = avcodec_open2(encoder->codec_ctx, codec, NULL);
+	if (open_ret < 0 && codec->id == AV_CODEC_ID_H264 && encoder->profile != DAYDREAM_H264_BASELINE) {
+		// Baseline is decodable under any negotiated profile, so it is always a safe fallback
+		blog(LOG_WARNING, "[Daydream Encoder] %s rejected %s profile, retrying with baseline", codec->name,
+		     daydream_h264_profile_name(encoder->profile));
+		encoder->profile = DAYDREAM_H264_BASELINE;
+		configure_encoder_options(encoder->codec_ctx, codec, encoder->profile, config);
+		open_ret = avcodec_open2(encoder->codec_ctx, codec, NULL);
+	}
+	if (open_ret < 0) {
+		blog(LOG_WARNING, "[Daydream Encoder] Failed to open %s", codec->name);
 #if defined(__APPLE__)
 		if (encoder->hw_frames_ctx)
 			av_buffer_unref(&encoder->hw_frames_ctx);
@@ -237,8 +628,7 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 			av_buffer_unref(&encoder->hw_device_ctx);
 #endif
 		avcodec_free_context(&encoder->codec_ctx);
-		bfree(encoder);
-		return NULL;
+		return false;
 	}
 
 	encoder->frame = av_frame_alloc();
@@ -251,8 +641,7 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 			av_buffer_unref(&encoder->hw_device_ctx);
 #endif
 		avcodec_free_context(&encoder->codec_ctx);
-		bfree(encoder);
-		return NULL;
+		return false;
 	}
 
 	if (encoder->using_hw) {
@@ -278,8 +667,7 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 				av_buffer_unref(&encoder->hw_device_ctx);
 #endif
 			avcodec_free_context(&encoder->codec_ctx);
-			bfree(encoder);
-			return NULL;
+			return false;
 		}
 
 		// Create sws context for SW path
@@ -291,8 +679,7 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 			blog(LOG_ERROR, "[Daydream Encoder] Failed to create sws context");
 			av_frame_free(&encoder->frame);
 			avcodec_free_context(&encoder->codec_ctx);
-			bfree(encoder);
-			return NULL;
+			return false;
 		}
 	}
 
@@ -301,6 +688,7 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 		blog(LOG_ERROR, "[Daydream Encoder] Failed to allocate packet");
 		if (encoder->sws_ctx)
 			sws_freeContext(encoder->sws_ctx);
+		encoder->sws_ctx = NULL;
 		av_frame_free(&encoder->frame);
 #if defined(__APPLE__)
 		if (encoder->hw_frames_ctx)
@@ -309,15 +697,97 @@ struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_c
 			av_buffer_unref(&encoder->hw_device_ctx);
 #endif
 		avcodec_free_context(&encoder->codec_ctx);
+		return false;
+	}
+
+	return true;
+}
+
+struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_config *config)
+{
+	if (!config || config->width == 0 || config->height == 0)
+		return NULL;
+
+	struct daydream_encoder *encoder = bzalloc(sizeof(struct daydream_encoder));
+	encoder->width = config->width;
+	encoder->height = config->height;
+	encoder->fps = config->fps > 0 ? config->fps : 30;
+	encoder->bitrate = config->bitrate > 0 ? config->bitrate : 2000000;
+	encoder->codec = config->codec;
+	encoder->profile = config->profile;
+	encoder->rate_control = config->rate_control;
+	encoder->frame_count = 0;
+	encoder->request_keyframe = true;
+	encoder->using_hw = false;
+	encoder->using_zerocopy = false;
+
+#if defined(__APPLE__)
+	// Try zero-copy path first on macOS
+	if (config->use_zerocopy && config->codec == DAYDREAM_CODEC_H264) {
+		uint32_t bitrate = config->bitrate > 0 ? config->bitrate : 2000000;
+		if (init_zerocopy_encoder(encoder, bitrate)) {
+			encoder->using_zerocopy = true;
+			encoder->codec_name = "videotoolbox (zero-copy)";
+			encoder->output_buffer_size = config->width * config->height * 2;
+			encoder->output_buffer = bmalloc(encoder->output_buffer_size);
+			blog(LOG_INFO, "[Daydream Encoder] Created %dx%d @ %d fps, %d kbps (zero-copy)", config->width,
+			     config->height, encoder->fps, bitrate / 1000);
+			return encoder;
+		}
+		blog(LOG_INFO, "[Daydream Encoder] Zero-copy init failed, falling back to FFmpeg path");
+	}
+#endif
+
+#if defined(DAYDREAM_X264_DIRECT)
+	// Slice output trades the hardware encoder for a first packet that leaves before the frame is done
+	if (config->on_slice && config->codec == DAYDREAM_CODEC_H264) {
+		if (init_x264_encoder(encoder, config)) {
+			encoder->using_x264 = true;
+			encoder->codec_name = "libx264 (direct)";
+			blog(LOG_INFO, "[Daydream Encoder] Created %dx%d @ %d fps, %d kbps (libx264 direct, sliced, %s)",
+			     config->width, config->height, encoder->fps, encoder->bitrate / 1000,
+			     daydream_h264_profile_name(encoder->profile));
+			return encoder;
+		}
+		blog(LOG_INFO, "[Daydream Encoder] Direct libx264 init failed, falling back to FFmpeg path");
+	}
+#endif
+
+	const AVCodec *candidates[MAX_CANDIDATES];
+	size_t count = 0;
+	if (config->codec_name) {
+		candidates[0] = avcodec_find_encoder_by_name(config->codec_name);
+		if (candidates[0] && candidates[0]->id == codec_id(encoder->codec))
+			count = 1;
+	} else {
+		count = find_encoders(encoder->codec, candidates);
+	}
+	if (count == 0) {
+		blog(LOG_ERROR, "[Daydream Encoder] %s encoder not found%s%s",
+		     daydream_video_codec_name(encoder->codec), config->codec_name ? ": " : "",
+		     config->codec_name ? config->codec_name : "");
+		bfree(encoder);
+		return NULL;
+	}
+
+	const AVCodec *codec = NULL;
+	for (size_t i = 0; i < count && !codec; i++) {
+		if (init_ffmpeg_encoder(encoder, candidates[i], config))
+			codec = candidates[i];
+	}
+	if (!codec) {
 		bfree(encoder);
 		return NULL;
 	}
 
 	encoder->output_buffer_size = config->width * config->height * 2;
 	encoder->output_buffer = bmalloc(encoder->output_buffer_size);
+	encoder->codec_name = codec->name;
 
-	blog(LOG_INFO, "[Daydream Encoder] Created %dx%d @ %d fps, %d kbps (encoder: %s, hw: %s)", config->width,
-	     config->height, encoder->fps, bitrate / 1000, codec->name, encoder->using_hw ? "yes" : "no");
+	blog(LOG_INFO, "[Daydream Encoder] Created %dx%d @ %d fps, %d kbps (encoder: %s, profile: %s, hw: %s)",
+	     config->width, config->height, encoder->fps, encoder->bitrate / 1000, codec->name,
+	     encoder->codec == DAYDREAM_CODEC_H264 ? daydream_h264_profile_name(encoder->profile) : "-",
+	     encoder->using_hw ? "yes" : "no");
 
 	return encoder;
 }
@@ -342,6 +812,16 @@ void daydream_encoder_destroy(struct daydream_encoder *encoder)
 	}
 #endif
 
+#if defined(DAYDREAM_X264_DIRECT)
+	if (encoder->using_x264) {
+		x264_encoder_close(encoder->x264);
+		x264_picture_clean(&encoder->x264_pic);
+		pthread_mutex_destroy(&encoder->slice_mutex);
+		bfree(encoder->nal_arena);
+		bfree(encoder->pending_slices);
+	}
+#endif
+
 	if (encoder->sws_ctx)
 		sws_freeContext(encoder->sws_ctx);
 	if (encoder->packet)
@@ -358,10 +838,157 @@ void daydream_encoder_destroy(struct daydream_encoder *encoder)
 		avcodec_free_context(&encoder->codec_ctx);
 	if (encoder->output_buffer)
 		bfree(encoder->output_buffer);
+	bfree((char *)encoder->pool_key.codec_name);
+	bfree((char *)encoder->pool_key.preset);
 
 	bfree(encoder);
 }
 
+// Idle encoders kept for the next session. Hardware encoders hold a session the GPU only has a few of,
+// which OBS's own outputs may need, so only a couple are kept and not for long.
+#define POOL_MAX_IDLE 2
+#define POOL_IDLE_TIMEOUT_NS (60 * 1000000000ULL)
+
+static pthread_mutex_t pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct daydream_encoder *pool_head; // Most recently released first
+
+static bool same_string(const char *a, const char *b)
+{
+	return a == b || (a && b && strcmp(a, b) == 0);
+}
+
+static bool pool_key_matches(const struct daydream_encoder_config *key, const struct daydream_encoder_config *config)
+{
+	return key->width == config->width && key->height == config->height && key->fps == config->fps &&
+	       key->codec == config->codec && key->profile == config->profile &&
+	       key->use_zerocopy == config->use_zerocopy &&
+	       same_string(key->codec_name, config->codec_name) && same_string(key->preset, config->preset) &&
+	       key->rate_control == config->rate_control && key->quality == config->quality &&
+	       key->keyint_ms == config->keyint_ms && key->intra_refresh == config->intra_refresh &&
+	       (key->on_slice != NULL) == (config->on_slice != NULL);
+}
+
+// Whether the encoder can drop whatever it still has buffered and start over at a keyframe
+static bool can_reset(struct daydream_encoder *encoder)
+{
+	if (encoder->using_zerocopy)
+		return false;
+#if defined(DAYDREAM_X264_DIRECT)
+	// zerolatency holds no frames between encode calls, so there is nothing to flush
+	if (encoder->using_x264)
+		return true;
+#endif
+	return encoder->codec_ctx && (encoder->codec_ctx->codec->capabilities & AV_CODEC_CAP_ENCODER_FLUSH);
+}
+
+// Unlinks pooled encoders past the first keep, and any idle longer than the timeout; pool_mutex held
+static struct daydream_encoder *pool_detach_stale(uint64_t now_ns, size_t keep)
+{
+	struct daydream_encoder *stale = NULL;
+	struct daydream_encoder **link = &pool_head;
+	size_t kept = 0;
+	while (*link) {
+		struct daydream_encoder *encoder = *link;
+		if (kept >= keep || now_ns - encoder->idle_since_ns >= POOL_IDLE_TIMEOUT_NS) {
+			*link = encoder->pool_next;
+			encoder->pool_next = stale;
+			stale = encoder;
+		} else {
+			link = &encoder->pool_next;
+			kept++;
+		}
+	}
+	return stale;
+}
+
+static void destroy_list(struct daydream_encoder *encoder)
+{
+	while (encoder) {
+		struct daydream_encoder *next = encoder->pool_next;
+		daydream_encoder_destroy(encoder);
+		encoder = next;
+	}
+}
+
+struct daydream_encoder *daydream_encoder_acquire(const struct daydream_encoder_config *config)
+{
+	if (!config)
+		return NULL;
+
+	struct daydream_encoder *encoder = NULL;
+	pthread_mutex_lock(&pool_mutex);
+	for (struct daydream_encoder **link = &pool_head; *link; link = &(*link)->pool_next) {
+		if (pool_key_matches(&(*link)->pool_key, config)) {
+			encoder = *link;
+			*link = encoder->pool_next;
+			encoder->pool_next = NULL;
+			break;
+		}
+	}
+	pthread_mutex_unlock(&pool_mutex);
+
+	if (encoder) {
+		if (encoder->codec_ctx)
+			avcodec_flush_buffers(encoder->codec_ctx);
+#if defined(DAYDREAM_X264_DIRECT)
+		encoder->on_slice = config->on_slice;
+		encoder->slice_userdata = config->slice_userdata;
+#endif
+		daydream_encoder_set_bitrate(encoder, config->bitrate > 0 ? config->bitrate : 2000000);
+		encoder->request_keyframe = true;
+		blog(LOG_INFO, "[Daydream Encoder] Reusing pooled %s encoder, %dx%d @ %d fps", encoder->codec_name,
+		     encoder->width, encoder->height, encoder->fps);
+		return encoder;
+	}
+
+	encoder = daydream_encoder_create(config);
+	if (encoder) {
+		encoder->pool_key = *config;
+		encoder->pool_key.codec_name = config->codec_name ? bstrdup(config->codec_name) : NULL;
+		encoder->pool_key.preset = config->preset ? bstrdup(config->preset) : NULL;
+		encoder->pool_key.slice_userdata = NULL;
+		encoder->poolable = true;
+	}
+	return encoder;
+}
+
+void daydream_encoder_release(struct daydream_encoder *encoder)
+{
+	if (!encoder)
+		return;
+	if (!encoder->poolable || !can_reset(encoder)) {
+		daydream_encoder_destroy(encoder);
+		return;
+	}
+
+	pthread_mutex_lock(&pool_mutex);
+	encoder->idle_since_ns = os_gettime_ns();
+	encoder->pool_next = pool_head;
+	pool_head = encoder;
+	struct daydream_encoder *stale = pool_detach_stale(encoder->idle_since_ns, POOL_MAX_IDLE);
+	pthread_mutex_unlock(&pool_mutex);
+
+	destroy_list(stale);
+}
+
+void daydream_encoder_pool_trim(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	struct daydream_encoder *stale = pool_head ? pool_detach_stale(os_gettime_ns(), POOL_MAX_IDLE) : NULL;
+	pthread_mutex_unlock(&pool_mutex);
+
+	destroy_list(stale);
+}
+
+void daydream_encoder_pool_clear(void)
+{
+	pthread_mutex_lock(&pool_mutex);
+	struct daydream_encoder *stale = pool_detach_stale(os_gettime_ns(), 0);
+	pthread_mutex_unlock(&pool_mutex);
+
+	destroy_list(stale);
+}
+
 #if defined(__APPLE__)
 static bool encode_hw_frame(struct daydream_encoder *encoder, const uint8_t *bgra_data, uint32_t linesize)
 {
@@ -421,6 +1048,12 @@ bool daydream_encoder_encode(struct daydream_encoder *encoder, const uint8_t *bg
 		return false;
 
 	bool send_success = false;
+	out_frame->sent_as_slices = false;
+
+#if defined(DAYDREAM_X264_DIRECT)
+	if (encoder->using_x264)
+		return encode_x264_frame(encoder, bgra_data, linesize, out_frame);
+#endif
 
 #if defined(__APPLE__)
 	if (encoder->using_hw) {
@@ -674,8 +1307,16 @@ static bool init_zerocopy_encoder(struct daydream_encoder *encoder, uint32_t bit
 	// Configure session for realtime ultra-low-latency
 	VTSessionSetProperty(encoder->vt_session, kVTCompressionPropertyKey_RealTime, kCFBooleanTrue);
 	VTSessionSetProperty(encoder->vt_session, kVTCompressionPropertyKey_AllowFrameReordering, kCFBooleanFalse);
-	VTSessionSetProperty(encoder->vt_session, kVTCompressionPropertyKey_ProfileLevel,
-			     kVTProfileLevel_H264_Baseline_AutoLevel);
+	CFStringRef profile_level = kVTProfileLevel_H264_Baseline_AutoLevel;
+	if (encoder->profile == DAYDREAM_H264_HIGH)
+		profile_level = kVTProfileLevel_H264_High_AutoLevel;
+	else if (encoder->profile == DAYDREAM_H264_MAIN)
+		profile_level = kVTProfileLevel_H264_Main_AutoLevel;
+	if (VTSessionSetProperty(encoder->vt_session, kVTCompressionPropertyKey_ProfileLevel, profile_level) != noErr) {
+		encoder->profile = DAYDREAM_H264_BASELINE;
+		VTSessionSetProperty(encoder->vt_session, kVTCompressionPropertyKey_ProfileLevel,
+				     kVTProfileLevel_H264_Baseline_AutoLevel);
+	}
 
 	// Ultra-low-latency: no frame delay, prioritize speed
 	int32_t maxFrameDelay = 0;
@@ -794,6 +1435,7 @@ bool daydream_encoder_encode_iosurface(struct daydream_encoder *encoder, struct
 	out_frame->size = encoder->vt_output_size;
 	out_frame->is_keyframe = encoder->vt_is_keyframe;
 	out_frame->pts = encoder->frame_count;
+	out_frame->sent_as_slices = false;
 
 	pthread_mutex_unlock(&encoder->vt_mutex);
 
@@ -817,6 +1459,10 @@ bool daydream_encoder_set_bitrate(struct daydream_encoder *encoder, uint32_t bit
 	if (encoder->bitrate == bitrate)
 		return true;
 
+	// Constant quality has no bitrate target to move
+	if (encoder->rate_control == DAYDREAM_RC_QUALITY)
+		return false;
+
 	encoder->bitrate = bitrate;
 
 #if defined(__APPLE__)
@@ -837,10 +1483,27 @@ bool daydream_encoder_set_bitrate(struct daydream_encoder *encoder, uint32_t bit
 	}
 #endif
 
+#if defined(DAYDREAM_X264_DIRECT)
+	if (encoder->using_x264) {
+		x264_param_t param;
+		x264_encoder_parameters(encoder->x264, &param);
+		x264_apply_bitrate(&param, bitrate);
+		if (x264_encoder_reconfig(encoder->x264, &param) < 0) {
+			blog(LOG_WARNING, "[Daydream Encoder] Failed to set libx264 bitrate");
+			return false;
+		}
+
+		blog(LOG_INFO, "[Daydream Encoder] libx264 bitrate changed to %d kbps", bitrate / 1000);
+		return true;
+	}
+#endif
+
 	if (encoder->codec_ctx) {
 		encoder->codec_ctx->bit_rate = bitrate;
 		encoder->codec_ctx->rc_max_rate = bitrate;
 		encoder->codec_ctx->rc_buffer_size = bitrate / 2;
+		if (encoder->rate_control == DAYDREAM_RC_CBR)
+			encoder->codec_ctx->rc_min_rate = bitrate;
 		blog(LOG_INFO, "[Daydream Encoder] FFmpeg bitrate changed to %d kbps", bitrate / 1000);
 	}
 
@@ -859,3 +1522,39 @@ void daydream_encoder_request_keyframe(struct daydream_encoder *encoder)
 	if (encoder)
 		encoder->request_keyframe = true;
 }
+
+bool daydream_encoder_is_sliced(struct daydream_encoder *encoder)
+{
+#if defined(DAYDREAM_X264_DIRECT)
+	return encoder && encoder->using_x264;
+#else
+	UNUSED_PARAMETER(encoder);
+	return false;
+#endif
+}
+
+enum daydream_h264_profile daydream_encoder_get_profile(struct daydream_encoder *encoder)
+{
+	return encoder ? encoder->profile : DAYDREAM_H264_BASELINE;
+}
+
+const char *daydream_encoder_get_codec_name(struct daydream_encoder *encoder)
+{
+	return encoder && encoder->codec_name ? encoder->codec_name : "none";
+}
+
+enum daydream_video_codec daydream_encoder_get_codec(struct daydream_encoder *encoder)
+{
+	return encoder ? encoder->codec : DAYDREAM_CODEC_H264;
+}
+
+bool daydream_encoder_supports(enum daydream_video_codec codec)
+{
+	const AVCodec *candidates[MAX_CANDIDATES];
+	size_t count = find_encoders(codec, candidates);
+	for (size_t i = 0; i < count; i++) {
+		if (!(candidates[i]->capabilities & AV_CODEC_CAP_HARDWARE))
+			return true;
+	}
+	return false;
+}
@@ -3,6 +3,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include "daydream-codec.h"
 
 #if defined(__APPLE__)
 #include <CoreVideo/CoreVideo.h>
@@ -15,12 +16,46 @@ extern "C" {
 
 struct daydream_encoder;
 
+// Negotiated through the WHIP SDP; baseline is the zero value so older configs keep their behavior
+enum daydream_h264_profile {
+	DAYDREAM_H264_BASELINE = 0,
+	DAYDREAM_H264_MAIN,
+	DAYDREAM_H264_HIGH,
+};
+
+// The zero value is what the live path uses: average bitrate with the VBV capped at the same rate
+enum daydream_rate_control {
+	DAYDREAM_RC_CAPPED_ABR = 0,
+	DAYDREAM_RC_CBR,     // Constant bitrate, with filler where the encoder supports it
+	DAYDREAM_RC_QUALITY, // Constant quality (CRF/CQ) at config->quality; bitrate is ignored
+};
+
+// Receives Annex B data as soon as the slices covering it are finished, while the rest of the frame is
+// still encoding. Called from x264 worker threads, one call at a time, in macroblock order. The data is
+// only valid for the duration of the call; last_slice marks the end of the access unit.
+typedef void (*daydream_encoder_slice_callback)(const uint8_t *data, size_t size, bool is_keyframe, bool last_slice,
+						void *userdata);
+
 struct daydream_encoder_config {
 	uint32_t width;
 	uint32_t height;
 	uint32_t fps;
 	uint32_t bitrate;
-	bool use_zerocopy; // macOS only: use IOSurface zero-copy path
+	enum daydream_video_codec codec;    // Negotiated through the WHIP SDP
+	enum daydream_h264_profile profile; // H.264 only; falls back to baseline if the encoder rejects it
+	bool use_zerocopy;                  // macOS only: use IOSurface zero-copy path
+
+	// Tuning overrides, used by the benchmark harness and power profiles; zero values keep the low-latency defaults
+	const char *codec_name;                  // FFmpeg encoder to use instead of the best available
+	const char *preset;                      // Encoder-specific speed preset
+	enum daydream_rate_control rate_control;
+	uint32_t quality;                        // CRF/CQ value for DAYDREAM_RC_QUALITY
+	uint32_t keyint_ms;                      // Keyframe interval, 500 ms when 0
+	bool intra_refresh;                      // Rolling intra refresh instead of periodic IDR frames
+
+	// Builds with ENABLE_X264_DIRECT only: drive libx264 directly and deliver slices through on_slice
+	daydream_encoder_slice_callback on_slice;
+	void *slice_userdata;
 };
 
 struct daydream_encoded_frame {
@@ -28,11 +63,21 @@ struct daydream_encoded_frame {
 	size_t size;
 	bool is_keyframe;
 	int64_t pts;
+	bool sent_as_slices; // Already delivered through on_slice, do not send again
 };
 
 struct daydream_encoder *daydream_encoder_create(const struct daydream_encoder_config *config);
 void daydream_encoder_destroy(struct daydream_encoder *encoder);
 
+// Per-process pool for the streaming path. acquire hands back an idle encoder created for the same
+// configuration, flushed, at config->bitrate and with a keyframe forced, or creates a new one. release
+// returns it to the pool, or destroys it if it cannot be flushed. Idle encoders are destroyed by
+// pool_trim once they have waited too long, and all of them by pool_clear.
+struct daydream_encoder *daydream_encoder_acquire(const struct daydream_encoder_config *config);
+void daydream_encoder_release(struct daydream_encoder *encoder);
+void daydream_encoder_pool_trim(void);
+void daydream_encoder_pool_clear(void);
+
 // Standard encode path (CPU BGRA buffer)
 bool daydream_encoder_encode(struct daydream_encoder *encoder, const uint8_t *bgra_data, uint32_t linesize,
 			     struct daydream_encoded_frame *out_frame);
@@ -42,6 +87,20 @@ bool daydream_encoder_set_bitrate(struct daydream_encoder *encoder, uint32_t bit
 uint32_t daydream_encoder_get_bitrate(struct daydream_encoder *encoder);
 void daydream_encoder_request_keyframe(struct daydream_encoder *encoder);
 
+// True when frames are delivered slice by slice through the config's on_slice callback
+bool daydream_encoder_is_sliced(struct daydream_encoder *encoder);
+
+// Profile actually in use, after any fallback
+enum daydream_h264_profile daydream_encoder_get_profile(struct daydream_encoder *encoder);
+const char *daydream_h264_profile_name(enum daydream_h264_profile profile);
+
+// Name of the encoder backend in use, e.g. "libx264" or "h264_nvenc"
+const char *daydream_encoder_get_codec_name(struct daydream_encoder *encoder);
+enum daydream_video_codec daydream_encoder_get_codec(struct daydream_encoder *encoder);
+
+// Whether this FFmpeg build has an encoder for codec that does not depend on hardware being present
+bool daydream_encoder_supports(enum daydream_video_codec codec);
+
 #if defined(__APPLE__)
 // Zero-copy encode path (macOS only)
 // Returns IOSurface that can be used as render target, NULL if not using zero-copy
@@ -5,12 +5,25 @@
 #include "daydream-decoder.h"
 #include "daydream-whip.h"
 #include "daydream-whep.h"
+#include "daydream-recorder.h"
+#include "daydream-interp.h"
+#include "daydream-latency.h"
+#include "daydream-probe.h"
+#include "daydream-clock.h"
+#include "daydream-bitrate.h"
+#include "daydream-rate-control.h"
+#include "daydream-governor.h"
+#include "daydream-render-cost.h"
 #include "plugin-support.h"
 #include <obs-module.h>
 #include <limits.h>
+#include <stddef.h>
 #include <graphics/graphics.h>
+#include <graphics/image-file.h>
 #include <util/threading.h>
 #include <util/platform.h>
+#include <util/dstr.h>
+#include <time.h>
 
 #define PROP_LOGIN "login"
 #define PROP_LOGOUT "logout"
@@ -54,6 +67,19 @@
 #define PROP_STEP_2 "step_2"
 #define PROP_STEP_3 "step_3"
 #define PROP_STEP_4 "step_4"
+#define PROP_GOVERNOR_ENABLED "governor_enabled"
+#define PROP_GOVERNOR_TARGET_FPS "governor_target_fps"
+#define PROP_GOVERNOR_MIN_STEPS "governor_min_steps"
+#define PROP_GOVERNOR_CONTROLNET_MAX "governor_controlnet_max_scale"
+
+// Presets
+#define PROP_PRESETS "presets"
+#define PROP_PRESET_NAME "preset_name"
+#define PROP_PRESET_SCENE "preset_scene"
+#define PROP_PRESET_SAVE "preset_save"
+#define PROP_PRESET_ARMED "preset_armed"
+#define PROP_PRESET_APPLY "preset_apply"
+#define PROP_PRESET_DELETE "preset_delete"
 
 // IP Adapter
 #define PROP_IP_ADAPTER_ENABLED "ip_adapter_enabled"
@@ -72,9 +98,55 @@
 #define PROP_START "start"
 #define PROP_STOP "stop"
 
+// Recording
+#define PROP_RECORD_ENABLED "record_enabled"
+#define PROP_RECORD_PATH "record_path"
+#define PROP_RECORD_FORMAT "record_format"
+
 // Experimental
 #define PROP_FRAME_SKIP_ENABLED "frame_skip_enabled"
 #define PROP_BLUR_SIZE "blur_size"
+#define PROP_INTERP_ENABLED "frame_interp_enabled"
+#define PROP_INTERP_BUDGET "frame_interp_budget_ms"
+#define PROP_AV_SYNC_ENABLED "av_sync_enabled"
+#define PROP_BLEND_OPACITY "blend_opacity"
+#define PROP_BLEND_MASK "blend_mask_path"
+#define PROP_SLICED_ENCODE "sliced_encode_enabled"
+#define PROP_INGEST_HOSTS "ingest_hosts"
+#define PROP_STUN_SERVER "stun_server"
+#define PROP_PLAYBACK_HOSTS "playback_hosts"
+#define PROP_BITRATE_FEEDBACK "bitrate_feedback_enabled"
+#define PROP_POWER_PROFILE "power_profile"
+#define PROP_STREAM_SIZE "stream_size"
+#define PROP_VIDEO_CODEC "video_codec"
+#define PROP_UPSCALE_ENABLED "upscale_enabled"
+#define PROP_UPSCALE_SHARPNESS "upscale_sharpness"
+#define PROP_RENDER_BUDGET "render_budget_ms"
+#define PROP_RENDER_DECIMATE "render_decimate"
+
+#define POWER_PROFILE_BALANCED "balanced"
+#define POWER_PROFILE_LOW "low_power"
+
+// Everything a live update can change, and so everything a preset covers
+#define PRESET_UPDATE_FLAGS                                                                                 \
+	(UPDATE_FLAG_PROMPT | UPDATE_FLAG_NEGATIVE_PROMPT | UPDATE_FLAG_SEED | UPDATE_FLAG_STEP_SCHEDULE | \
+	 UPDATE_FLAG_GUIDANCE | UPDATE_FLAG_DELTA | UPDATE_FLAG_CONTROLNETS | UPDATE_FLAG_IP_ADAPTER |     \
+	 UPDATE_FLAG_INTERP)
+
+#define DEFAULT_STREAM_SIZE 512
+#define DEFAULT_SEND_FPS 30
+#define LOW_POWER_SEND_FPS 15
+#define LOW_POWER_KEYINT_MS 2000
+
+// A named look, with its update body serialised ahead of time so applying it costs one request
+struct daydream_preset {
+	char *name;
+	char *scene;       // Applied when this scene goes live, if set
+	char *fingerprint; // Model, IP adapter type and preset JSON the payload was built from
+	char *payload;
+	char *style_image_url;
+	bool prefetched;
+};
 
 struct daydream_filter {
 	obs_source_t *source;
@@ -121,6 +193,14 @@ struct daydream_filter {
 	int step_count;
 	int step_indices[DAYDREAM_MAX_SCHEDULE_SLOTS];
 
+	// Output FPS governor; the level is applied on top of the settings above when updates are sent
+	bool governor_enabled;
+	int governor_target_fps;
+	struct daydream_governor_limits governor_limits;
+	struct daydream_governor *governor; // Render thread, under mutex
+	int governor_level;
+	uint64_t governor_last_check_ns;
+
 	// IP Adapter
 	bool ip_adapter_enabled;
 	float ip_adapter_scale;
@@ -135,6 +215,23 @@ struct daydream_filter {
 	float hed_scale;
 	float color_scale;
 
+	// Presets, rebuilt from settings when the preset list, model or IP adapter type changes
+	struct daydream_preset *presets;
+	size_t preset_count;
+	char *presets_source; // What they were last built from, compared on every update
+	char *armed_preset;
+	char *preset_payload; // Waiting for the update thread
+	bool preset_applying; // This update comes from a preset whose payload is already queued
+	obs_hotkey_id preset_hotkey;
+	pthread_t prefetch_thread;
+	bool prefetch_thread_created;
+	bool prefetch_running;
+
+	// Recording (compressed AI output, no re-encode)
+	bool record_enabled;
+	char *record_path;
+	char *record_format;
+
 	char *stream_id;
 	char *whip_url;
 	char *whep_url;
@@ -145,6 +242,16 @@ struct daydream_filter {
 	struct daydream_decoder *decoder;
 	struct daydream_whip *whip;
 	struct daydream_whep *whep;
+	struct daydream_recorder *recorder;
+
+	// Alternative gateway origins, comma-separated; probed against the API-provided URLs at start
+	char *ingest_hosts;
+	char *playback_hosts;
+	struct daydream_prober *ingest_prober;
+	struct daydream_prober *playback_prober;
+	char *stun_server; // Empty unless the operator opts in to a public address for the bitrate history
+
+	bool bitrate_feedback_enabled; // Send REMB from the WHEP side (cold)
 
 	pthread_t encode_thread;
 	bool encode_thread_running;
@@ -163,6 +270,7 @@ struct daydream_filter {
 	int pending_produce_idx; // Buffer index with ready data
 	int pending_consume_idx; // Buffer index encode is reading (-1 if idle)
 	bool pending_frame_ready;
+	uint64_t pending_capture_ns[2]; // Capture time per buffer
 
 	// Double buffer for decode output
 	uint8_t *decoded_frame[2]; // BGRA fallback
@@ -181,7 +289,9 @@ struct daydream_filter {
 	gs_texture_t *nv12_tex_y;
 	gs_texture_t *nv12_tex_uv;
 	gs_effect_t *nv12_effect;
-	gs_texrender_t *nv12_texrender;
+	gs_texrender_t *nv12_texrender; // RGB copy, only kept while interpolation or blending needs it
+	bool nv12_rgb_valid;            // nv12_texrender matches the current planes
+	bool render_is_nv12;            // Last uploaded frame was NV12 (vs BGRA output_texture)
 
 	// Blur background for letterboxing
 	gs_texrender_t *blur_texrender;
@@ -195,14 +305,49 @@ struct daydream_filter {
 	uint64_t last_encode_time;
 	uint32_t target_fps;
 
+	// Power profile, fixed while streaming. Low power sends fewer frames, skips the optional GPU passes
+	// and only reads back the frames it actually sends.
+	bool low_power;
+	uint64_t next_capture_ns;
+	uint64_t busy_capture_ns; // Wall time per stage since power_window_start_ns
+	uint64_t busy_encode_ns;
+	uint64_t busy_decode_ns;
+	uint64_t power_window_start_ns;
+	double busy_ms_per_min; // Last completed window, negative until there is one
+
+	// RTP timestamps follow capture time so returned frames can be matched
+	struct daydream_latency *latency;
+	uint64_t stream_start_ns;
+	uint32_t last_timestamp_ms;
+
+	// Send bitrate, started from this network's history and steered by the gateway's RTCP feedback.
+	// Encode thread only while streaming.
+	struct daydream_rate_controller *rate_controller;
+	char *network_key;
+	uint64_t feedback_reports;
+	uint64_t last_rate_update_ns;
+
+	// Capture-to-first-packet timing, logged periodically to compare encoder paths
+	uint64_t first_packet_total_ns;
+	uint64_t first_packet_count;
+
 	// Parameter update tracking
 	uint64_t pending_update_flags;
 	uint64_t last_update_time_ns;
 	pthread_t update_thread;
-	pthread_cond_t update_cond;
+	os_event_t *update_event; // Auto-reset, so a signal sent while the thread is busy is not lost
 	bool update_thread_running;
 	bool update_pending;
 
+	// Direct control. Controllers take only direct_mutex; the update thread folds their values into the
+	// fields above under the mutex. Bits index direct_params.
+	pthread_mutex_t direct_mutex;
+	struct direct_value *direct_values; // Latest value of each parameter
+	uint64_t direct_staged;             // Set by a controller, not yet folded into the fields
+	uint64_t direct_dirty;              // Set by a controller, not yet copied to settings
+	uint64_t direct_update_flags;
+	uint64_t direct_update_time_ns;
+
 	// Experimental: Frame skip
 	bool frame_skip_enabled;
 	uint32_t last_displayed_rtp_ts;
@@ -212,10 +357,97 @@ struct daydream_filter {
 
 	// Experimental: Blur background
 	int blur_size;
+
+	// Experimental: Frame interpolation
+	bool interp_enabled;
+	int interp_budget_ms;
+	struct daydream_interp *interp; // Motion estimation, WHEP thread only
+	uint32_t interp_last_rtp;       // RTP timestamp of the last frame pushed to interp
+	uint64_t interp_me_total_ns;
+	uint64_t interp_me_count;
+	float *interp_field[2];     // Motion field per decode buffer
+	bool interp_field_valid[2]; // Field exists for this buffer
+	uint32_t interp_ref_rtp[2]; // RTP timestamp of the frame the field points into
+	uint32_t decoded_rtp_ts[2]; // RTP timestamp per decode buffer
+	uint32_t interp_field_cols;
+	uint32_t interp_field_rows;
+	gs_texture_t *nv12_prev_tex_y;
+	gs_texture_t *nv12_prev_tex_uv;
+	gs_texture_t *interp_motion_tex;
+	uint32_t render_rtp_ts; // RTP timestamp of the frame in nv12_tex_y/uv
+	bool render_has_frame;
+	bool interp_active;
+	bool interp_over_budget;
+	uint64_t interp_start_ns;
+	uint64_t interp_interval_ns;
+
+	// Experimental: Automatic A/V sync
+	bool av_sync_enabled;
+	bool av_sync_applied;        // Parent offset currently overridden
+	int64_t av_sync_original_ns; // Parent offset before we touched it
+	int64_t av_sync_offset_ns;   // Latency compensation added on top
+	uint64_t av_sync_last_check_ns;
+
+	// Experimental: Original/AI blend
+	float blend_opacity;
+	char *blend_mask_path;
+	bool blend_mask_dirty;
+	gs_image_file_t blend_mask;
+	gs_effect_t *blend_effect;
+	gs_texrender_t *blend_texrender;
+
+	// Square resolution requested from the server, fixed while streaming
+	uint32_t stream_size;
+	char *video_codec; // "auto" or the codec to offer first, fixed while streaming
+
+	// Experimental: Edge-adaptive upscale (EASU + RCAS) from stream_size to the shown size
+	bool upscale_enabled;
+	float upscale_sharpness;
+	gs_effect_t *upscale_effect;
+	gs_texrender_t *upscale_texrender;
+	gs_timer_t *upscale_timer;  // Nested in the render timer, sharing its range
+	bool upscale_timer_pending; // A measurement is in flight on the GPU
+	bool upscale_timer_running; // Started this frame, ended after the RCAS draw
+	uint64_t upscale_gpu_ns;    // Summed GPU time of the measured frames
+	uint64_t upscale_timed;
+	uint64_t upscale_log_ns;
+	uint64_t bytes_received; // WHEP payload since upscale_log_ns
+	gs_texture_t **history_tex;   // GPU ring of recent crop frames
+	uint64_t *history_capture_ns; // Capture time per ring slot (0 = empty)
+	size_t history_capacity;
+	size_t history_pos;
+	uint64_t history_last_resize_ns;
+	int blend_match_idx; // Ring slot holding the original of the displayed AI frame (-1 if none)
+	uint64_t blend_match_capture_ns;
+
+	// Experimental: Render budget. The filter's own passes after the parent render are timed on the GPU,
+	// one measurement in flight at a time, or on the CPU where the backend has no timer queries. Render
+	// thread only, except render_level and render_cost_ms which the properties view reads.
+	float render_budget_ms; // 0 = unlimited
+	bool render_decimate;   // The governor may halve the capture rate as a last resort
+	struct daydream_render_cost *render_cost;
+	int render_level;
+	double render_cost_ms; // Last completed window, negative until there is one
+	gs_timer_t *render_timer;
+	gs_timer_range_t *render_timer_range;
+	bool render_timer_pending;
+	bool render_timer_running;
+	bool render_timer_cpu; // Timer queries unavailable
+	uint64_t render_cpu_start_ns;
+	bool capture_skipped; // Alternates at DAYDREAM_RENDER_DECIMATED
+
+	// Experimental: Sliced x264 output (encode thread state for the current frame)
+	bool sliced_encode_enabled;
+	uint32_t slice_timestamp_ms;
+	uint64_t slice_capture_ns;
+	bool slice_first_sent;
 };
 
-// Forward declaration
+// Forward declarations
 static void schedule_params_update(struct daydream_filter *ctx, uint64_t flags);
+static void daydream_filter_get_defaults(obs_data_t *settings);
+static struct daydream_recorder *create_recorder(struct daydream_filter *ctx, uint32_t width, uint32_t height,
+						 enum daydream_video_codec codec);
 
 static const char *daydream_filter_get_name(void *unused)
 {
@@ -233,10 +465,273 @@ static bool str_changed(const char *old_str, const char *new_str)
 	return strcmp(old_str, new_str) != 0;
 }
 
+// Settings a preset captures: everything that can change live through a PATCH
+static const char *const preset_string_keys[] = {
+	PROP_NEGATIVE_PROMPT, PROP_PROMPT_1,      PROP_PROMPT_2, PROP_PROMPT_3, PROP_PROMPT_4,
+	PROP_PROMPT_INTERP,   PROP_SEED_INTERP,   PROP_STYLE_IMAGE_URL,         NULL,
+};
+static const char *const preset_int_keys[] = {
+	PROP_PROMPT_COUNT, PROP_SEED_COUNT, PROP_SEED_1, PROP_SEED_2, PROP_SEED_3, PROP_SEED_4,
+	PROP_STEP_COUNT,   PROP_STEP_1,     PROP_STEP_2, PROP_STEP_3, PROP_STEP_4, NULL,
+};
+static const char *const preset_double_keys[] = {
+	PROP_GUIDANCE,        PROP_DELTA,
+	PROP_PROMPT_1_WEIGHT, PROP_PROMPT_2_WEIGHT, PROP_PROMPT_3_WEIGHT, PROP_PROMPT_4_WEIGHT,
+	PROP_SEED_1_WEIGHT,   PROP_SEED_2_WEIGHT,   PROP_SEED_3_WEIGHT,   PROP_SEED_4_WEIGHT,
+	PROP_IP_ADAPTER_SCALE,
+	PROP_DEPTH_SCALE,     PROP_CANNY_SCALE,     PROP_TILE_SCALE,
+	PROP_OPENPOSE_SCALE,  PROP_HED_SCALE,       PROP_COLOR_SCALE,
+	NULL,
+};
+static const char *const preset_bool_keys[] = {
+	PROP_NORMALIZE_PROMPT,
+	PROP_NORMALIZE_SEED,
+	PROP_IP_ADAPTER_ENABLED,
+	NULL,
+};
+
+static obs_data_t *preset_snapshot(obs_data_t *settings)
+{
+	obs_data_t *snapshot = obs_data_create();
+	for (size_t i = 0; preset_string_keys[i]; i++) {
+		const char *key = preset_string_keys[i];
+		obs_data_set_string(snapshot, key, obs_data_get_string(settings, key));
+	}
+	for (size_t i = 0; preset_int_keys[i]; i++) {
+		const char *key = preset_int_keys[i];
+		obs_data_set_int(snapshot, key, obs_data_get_int(settings, key));
+	}
+	for (size_t i = 0; preset_double_keys[i]; i++) {
+		const char *key = preset_double_keys[i];
+		obs_data_set_double(snapshot, key, obs_data_get_double(settings, key));
+	}
+	for (size_t i = 0; preset_bool_keys[i]; i++) {
+		const char *key = preset_bool_keys[i];
+		obs_data_set_bool(snapshot, key, obs_data_get_bool(settings, key));
+	}
+	return snapshot;
+}
+
+// Stream parameters straight from settings; strings point into settings
+static void params_from_settings(obs_data_t *settings, const char *model, struct daydream_stream_params *params)
+{
+	static const char *const prompt_keys[] = {PROP_PROMPT_1, PROP_PROMPT_2, PROP_PROMPT_3, PROP_PROMPT_4};
+	static const char *const prompt_weight_keys[] = {PROP_PROMPT_1_WEIGHT, PROP_PROMPT_2_WEIGHT,
+							 PROP_PROMPT_3_WEIGHT, PROP_PROMPT_4_WEIGHT};
+	static const char *const seed_keys[] = {PROP_SEED_1, PROP_SEED_2, PROP_SEED_3, PROP_SEED_4};
+	static const char *const seed_weight_keys[] = {PROP_SEED_1_WEIGHT, PROP_SEED_2_WEIGHT, PROP_SEED_3_WEIGHT,
+						       PROP_SEED_4_WEIGHT};
+	static const char *const step_keys[] = {PROP_STEP_1, PROP_STEP_2, PROP_STEP_3, PROP_STEP_4};
+
+	params->model_id = model;
+	params->negative_prompt = obs_data_get_string(settings, PROP_NEGATIVE_PROMPT);
+	params->guidance = (float)obs_data_get_double(settings, PROP_GUIDANCE);
+	params->delta = (float)obs_data_get_double(settings, PROP_DELTA);
+	params->num_inference_steps = (int)obs_data_get_int(settings, PROP_NUM_STEPS);
+
+	params->prompt_schedule.count = (int)obs_data_get_int(settings, PROP_PROMPT_COUNT);
+	params->seed_schedule.count = (int)obs_data_get_int(settings, PROP_SEED_COUNT);
+	params->step_schedule.count = (int)obs_data_get_int(settings, PROP_STEP_COUNT);
+	for (int i = 0; i < DAYDREAM_MAX_SCHEDULE_SLOTS; i++) {
+		params->prompt_schedule.prompts[i] = obs_data_get_string(settings, prompt_keys[i]);
+		params->prompt_schedule.weights[i] = (float)obs_data_get_double(settings, prompt_weight_keys[i]);
+		params->seed_schedule.seeds[i] = (int)obs_data_get_int(settings, seed_keys[i]);
+		params->seed_schedule.weights[i] = (float)obs_data_get_double(settings, seed_weight_keys[i]);
+		params->step_schedule.steps[i] = (int)obs_data_get_int(settings, step_keys[i]);
+	}
+
+	params->ip_adapter.enabled = obs_data_get_bool(settings, PROP_IP_ADAPTER_ENABLED);
+	params->ip_adapter.scale = (float)obs_data_get_double(settings, PROP_IP_ADAPTER_SCALE);
+	params->ip_adapter.type = obs_data_get_string(settings, PROP_IP_ADAPTER_TYPE);
+	params->ip_adapter.style_image_url = obs_data_get_string(settings, PROP_STYLE_IMAGE_URL);
+
+	params->controlnets.depth_scale = (float)obs_data_get_double(settings, PROP_DEPTH_SCALE);
+	params->controlnets.canny_scale = (float)obs_data_get_double(settings, PROP_CANNY_SCALE);
+	params->controlnets.tile_scale = (float)obs_data_get_double(settings, PROP_TILE_SCALE);
+	params->controlnets.openpose_scale = (float)obs_data_get_double(settings, PROP_OPENPOSE_SCALE);
+	params->controlnets.hed_scale = (float)obs_data_get_double(settings, PROP_HED_SCALE);
+	params->controlnets.color_scale = (float)obs_data_get_double(settings, PROP_COLOR_SCALE);
+
+	params->prompt_interpolation_method = obs_data_get_string(settings, PROP_PROMPT_INTERP);
+	params->normalize_prompt_weights = obs_data_get_bool(settings, PROP_NORMALIZE_PROMPT);
+	params->seed_interpolation_method = obs_data_get_string(settings, PROP_SEED_INTERP);
+	params->normalize_seed_weights = obs_data_get_bool(settings, PROP_NORMALIZE_SEED);
+}
+
+static void preset_free(struct daydream_preset *preset)
+{
+	bfree(preset->name);
+	bfree(preset->scene);
+	bfree(preset->fingerprint);
+	bfree(preset->payload);
+	bfree(preset->style_image_url);
+}
+
+static struct daydream_preset *find_preset(struct daydream_preset *presets, size_t count, const char *name)
+{
+	for (size_t i = 0; i < count; i++) {
+		if (presets[i].name && name && strcmp(presets[i].name, name) == 0)
+			return &presets[i];
+	}
+	return NULL;
+}
+
+struct prefetch_job {
+	struct daydream_filter *ctx;
+	char **urls;
+	size_t count;
+};
+
+// Fetch preset style images before they are needed, so a dead link shows up in the log when the preset
+// is saved rather than on air, and any cache between us and the image host is warm
+static void *prefetch_thread_func(void *arg)
+{
+	struct prefetch_job *job = arg;
+
+	for (size_t i = 0; i < job->count; i++) {
+		uint64_t start = daydream_clock_now_ns();
+		size_t bytes = 0;
+		if (daydream_api_prefetch(job->urls[i], &bytes))
+			blog(LOG_INFO, "[Daydream] Prefetched style image %s (%zu KB in %llu ms)", job->urls[i],
+			     bytes / 1024, (unsigned long long)((daydream_clock_now_ns() - start) / 1000000));
+		bfree(job->urls[i]);
+	}
+
+	pthread_mutex_lock(&job->ctx->mutex);
+	job->ctx->prefetch_running = false;
+	pthread_mutex_unlock(&job->ctx->mutex);
+
+	bfree(job->urls);
+	bfree(job);
+	return NULL;
+}
+
+// Caller holds ctx->mutex
+static void start_prefetch(struct daydream_filter *ctx)
+{
+	if (ctx->prefetch_running)
+		return;
+
+	size_t count = 0;
+	for (size_t i = 0; i < ctx->preset_count; i++) {
+		if (!ctx->presets[i].prefetched && ctx->presets[i].style_image_url && *ctx->presets[i].style_image_url)
+			count++;
+	}
+	if (count == 0)
+		return;
+
+	struct prefetch_job *job = bzalloc(sizeof(struct prefetch_job));
+	job->ctx = ctx;
+	job->urls = bzalloc(count * sizeof(char *));
+	for (size_t i = 0; i < ctx->preset_count; i++) {
+		struct daydream_preset *preset = &ctx->presets[i];
+		if (!preset->prefetched && preset->style_image_url && *preset->style_image_url)
+			job->urls[job->count++] = bstrdup(preset->style_image_url);
+		preset->prefetched = true;
+	}
+
+	// The previous job has finished, so this only reaps it
+	if (ctx->prefetch_thread_created)
+		pthread_join(ctx->prefetch_thread, NULL);
+	ctx->prefetch_running = true;
+	ctx->prefetch_thread_created = pthread_create(&ctx->prefetch_thread, NULL, prefetch_thread_func, job) == 0;
+	if (!ctx->prefetch_thread_created) {
+		ctx->prefetch_running = false;
+		for (size_t i = 0; i < job->count; i++)
+			bfree(job->urls[i]);
+		bfree(job->urls);
+		bfree(job);
+	}
+}
+
+// Rebuild ctx->presets from settings, keeping payloads whose preset and model are unchanged. Most updates
+// touch neither, so the whole list is serialised once and compared before anything is rebuilt.
+// Caller holds ctx->mutex.
+static void sync_presets(struct daydream_filter *ctx, obs_data_t *settings)
+{
+	// Not part of a preset, but every payload carries it
+	const char *ip_adapter_type = obs_data_get_string(settings, PROP_IP_ADAPTER_TYPE);
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_PRESETS);
+
+	obs_data_t *list = obs_data_create();
+	if (array)
+		obs_data_set_array(list, PROP_PRESETS, array);
+	struct dstr source = {0};
+	dstr_printf(&source, "%s\n%s\n%s", ctx->model ? ctx->model : "", ip_adapter_type, obs_data_get_json(list));
+	obs_data_release(list);
+	if (ctx->presets_source && strcmp(ctx->presets_source, source.array) == 0) {
+		dstr_free(&source);
+		obs_data_array_release(array);
+		return;
+	}
+	bfree(ctx->presets_source);
+	ctx->presets_source = source.array;
+
+	size_t count = obs_data_array_count(array);
+	struct daydream_preset *presets = count ? bzalloc(count * sizeof(struct daydream_preset)) : NULL;
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		obs_data_t *preset_settings = obs_data_get_obj(item, "settings");
+		const char *name = obs_data_get_string(item, "name");
+
+		struct dstr fingerprint = {0};
+		dstr_printf(&fingerprint, "%s\n%s\n%s", ctx->model ? ctx->model : "", ip_adapter_type,
+			    preset_settings ? obs_data_get_json(preset_settings) : "");
+
+		struct daydream_preset *old = find_preset(ctx->presets, ctx->preset_count, name);
+		if (old && strcmp(old->fingerprint, fingerprint.array) == 0) {
+			bfree(old->scene);
+			presets[i] = *old;
+			memset(old, 0, sizeof(*old));
+			dstr_free(&fingerprint);
+		} else {
+			// Defaults and current settings underneath, for anything an older preset does not cover
+			obs_data_t *merged = obs_data_create();
+			daydream_filter_get_defaults(merged);
+			obs_data_apply(merged, settings);
+			if (preset_settings)
+				obs_data_apply(merged, preset_settings);
+
+			struct daydream_stream_params params = {0};
+			params_from_settings(merged, ctx->model, &params);
+			char *payload = daydream_api_build_update(&params, PRESET_UPDATE_FLAGS);
+
+			presets[i].name = bstrdup(name);
+			presets[i].fingerprint = fingerprint.array;
+			presets[i].payload = payload ? bstrdup(payload) : NULL;
+			presets[i].style_image_url = bstrdup(params.ip_adapter.style_image_url);
+			daydream_api_free_payload(payload);
+			obs_data_release(merged);
+		}
+		presets[i].scene = bstrdup(obs_data_get_string(item, "scene"));
+
+		obs_data_release(preset_settings);
+		obs_data_release(item);
+	}
+	obs_data_array_release(array);
+
+	for (size_t i = 0; i < ctx->preset_count; i++)
+		preset_free(&ctx->presets[i]);
+	bfree(ctx->presets);
+	ctx->presets = presets;
+	ctx->preset_count = count;
+
+	start_prefetch(ctx);
+}
+
+static void sync_direct_params(struct daydream_filter *ctx, obs_data_t *settings);
+static void drop_direct_params(struct daydream_filter *ctx, obs_data_t *values);
+static void refresh_direct_params(struct daydream_filter *ctx);
+static void take_direct_params(struct daydream_filter *ctx);
+
 static void daydream_filter_update(void *data, obs_data_t *settings)
 {
 	struct daydream_filter *ctx = data;
 
+	// Values a controller set since the last sync are newer than what the settings hold
+	sync_direct_params(ctx, settings);
+
 	pthread_mutex_lock(&ctx->mutex);
 
 	bool is_streaming = ctx->streaming;
@@ -287,6 +782,10 @@ static void daydream_filter_update(void *data, obs_data_t *settings)
 	new_step_indices[1] = (int)obs_data_get_int(settings, PROP_STEP_2);
 	new_step_indices[2] = (int)obs_data_get_int(settings, PROP_STEP_3);
 	new_step_indices[3] = (int)obs_data_get_int(settings, PROP_STEP_4);
+	bool new_governor_enabled = obs_data_get_bool(settings, PROP_GOVERNOR_ENABLED);
+	int new_governor_target = (int)obs_data_get_int(settings, PROP_GOVERNOR_TARGET_FPS);
+	int new_governor_min_steps = (int)obs_data_get_int(settings, PROP_GOVERNOR_MIN_STEPS);
+	float new_governor_controlnet_max = (float)obs_data_get_double(settings, PROP_GOVERNOR_CONTROLNET_MAX);
 
 	// IP Adapter
 	bool new_ip_enabled = obs_data_get_bool(settings, PROP_IP_ADAPTER_ENABLED);
@@ -305,9 +804,42 @@ static void daydream_filter_update(void *data, obs_data_t *settings)
 	// Experimental
 	bool new_frame_skip = obs_data_get_bool(settings, PROP_FRAME_SKIP_ENABLED);
 	int new_blur_size = (int)obs_data_get_int(settings, PROP_BLUR_SIZE);
+	bool new_interp_enabled = obs_data_get_bool(settings, PROP_INTERP_ENABLED);
+	bool new_av_sync_enabled = obs_data_get_bool(settings, PROP_AV_SYNC_ENABLED);
+	float new_blend_opacity = (float)obs_data_get_double(settings, PROP_BLEND_OPACITY);
+	const char *new_blend_mask = obs_data_get_string(settings, PROP_BLEND_MASK);
+	int new_interp_budget = (int)obs_data_get_int(settings, PROP_INTERP_BUDGET);
+	bool new_sliced_encode = obs_data_get_bool(settings, PROP_SLICED_ENCODE);
+	const char *new_ingest_hosts = obs_data_get_string(settings, PROP_INGEST_HOSTS);
+	const char *new_playback_hosts = obs_data_get_string(settings, PROP_PLAYBACK_HOSTS);
+	const char *new_stun_server = obs_data_get_string(settings, PROP_STUN_SERVER);
+	bool new_bitrate_feedback = obs_data_get_bool(settings, PROP_BITRATE_FEEDBACK);
+	bool new_low_power = strcmp(obs_data_get_string(settings, PROP_POWER_PROFILE), POWER_PROFILE_LOW) == 0;
+	uint32_t new_stream_size = (uint32_t)obs_data_get_int(settings, PROP_STREAM_SIZE);
+	const char *new_video_codec = obs_data_get_string(settings, PROP_VIDEO_CODEC);
+	bool new_upscale_enabled = obs_data_get_bool(settings, PROP_UPSCALE_ENABLED);
+	float new_upscale_sharpness = (float)obs_data_get_double(settings, PROP_UPSCALE_SHARPNESS);
+	float new_render_budget = (float)obs_data_get_double(settings, PROP_RENDER_BUDGET);
+	bool new_render_decimate = obs_data_get_bool(settings, PROP_RENDER_DECIMATE);
+	if (new_stream_size < 256 || new_stream_size > DEFAULT_STREAM_SIZE || new_stream_size % 64 != 0)
+		new_stream_size = DEFAULT_STREAM_SIZE;
+
+	// Low power turns off every pass that needs an intermediate texture: the blur background, and the
+	// NV12 to RGB copy that interpolation, blending and upscaling read from
+	if (new_low_power) {
+		new_blur_size = 0;
+		new_interp_enabled = false;
+		new_blend_opacity = 0.0f;
+		new_upscale_enabled = false;
+	}
 
-	// Detect changes if streaming
-	if (is_streaming) {
+	// Recording
+	bool new_record_enabled = obs_data_get_bool(settings, PROP_RECORD_ENABLED);
+	const char *new_record_path = obs_data_get_string(settings, PROP_RECORD_PATH);
+	const char *new_record_format = obs_data_get_string(settings, PROP_RECORD_FORMAT);
+
+	// Detect changes if streaming; a preset's changes are already queued as one payload
+	if (is_streaming && !ctx->preset_applying) {
 		// Prompt changes
 		if (new_prompt_count != ctx->prompt_count)
 			update_flags |= UPDATE_FLAG_PROMPT;
@@ -366,6 +898,8 @@ static void daydream_filter_update(void *data, obs_data_t *settings)
 	bfree(ctx->style_image_url);
 	bfree(ctx->prompt_interpolation);
 	bfree(ctx->seed_interpolation);
+	bfree(ctx->record_path);
+	bfree(ctx->record_format);
 	for (int i = 0; i < DAYDREAM_MAX_SCHEDULE_SLOTS; i++) {
 		bfree(ctx->prompts[i]);
 	}
@@ -397,6 +931,10 @@ static void daydream_filter_update(void *data, obs_data_t *settings)
 	for (int i = 0; i < DAYDREAM_MAX_SCHEDULE_SLOTS; i++) {
 		ctx->step_indices[i] = new_step_indices[i];
 	}
+	ctx->governor_enabled = new_governor_enabled;
+	ctx->governor_target_fps = new_governor_target;
+	ctx->governor_limits.min_steps = new_governor_min_steps;
+	ctx->governor_limits.controlnet_max_scale = new_governor_controlnet_max;
 
 	ctx->ip_adapter_enabled = new_ip_enabled;
 	ctx->ip_adapter_scale = new_ip_scale;
@@ -412,6 +950,44 @@ static void daydream_filter_update(void *data, obs_data_t *settings)
 
 	ctx->frame_skip_enabled = new_frame_skip;
 	ctx->blur_size = new_blur_size;
+	ctx->interp_enabled = new_interp_enabled;
+	ctx->interp_budget_ms = new_interp_budget;
+	ctx->av_sync_enabled = new_av_sync_enabled;
+	ctx->blend_opacity = new_blend_opacity;
+	if (str_changed(ctx->blend_mask_path, new_blend_mask)) {
+		bfree(ctx->blend_mask_path);
+		ctx->blend_mask_path = bstrdup(new_blend_mask);
+		ctx->blend_mask_dirty = true;
+	}
+	ctx->sliced_encode_enabled = new_sliced_encode && !new_low_power;
+	ctx->upscale_enabled = new_upscale_enabled;
+	ctx->upscale_sharpness = new_upscale_sharpness;
+	ctx->render_budget_ms = new_render_budget;
+	ctx->render_decimate = new_render_decimate;
+	if (!is_streaming) {
+		ctx->low_power = new_low_power;
+		ctx->target_fps = new_low_power ? LOW_POWER_SEND_FPS : DEFAULT_SEND_FPS;
+		ctx->stream_size = new_stream_size;
+		bfree(ctx->video_codec);
+		ctx->video_codec = bstrdup(new_video_codec);
+	}
+	bfree(ctx->ingest_hosts);
+	bfree(ctx->playback_hosts);
+	ctx->ingest_hosts = bstrdup(new_ingest_hosts);
+	ctx->playback_hosts = bstrdup(new_playback_hosts);
+	bfree(ctx->stun_server);
+	ctx->stun_server = bstrdup(new_stun_server);
+	ctx->bitrate_feedback_enabled = new_bitrate_feedback;
+
+	ctx->record_enabled = new_record_enabled;
+	ctx->record_path = bstrdup(new_record_path);
+	ctx->record_format = bstrdup(new_record_format);
+
+	bfree(ctx->armed_preset);
+	ctx->armed_preset = bstrdup(obs_data_get_string(settings, PROP_PRESET_ARMED));
+	sync_presets(ctx, settings);
+	ctx->preset_applying = false;
+	refresh_direct_params(ctx);
 
 	pthread_mutex_unlock(&ctx->mutex);
 
@@ -421,6 +997,93 @@ static void daydream_filter_update(void *data, obs_data_t *settings)
 	}
 }
 
+// Queue the preset's prebuilt payload and fold its values into the settings, so the UI and any later
+// live update start from the preset rather than sending its fields again
+static void apply_preset(struct daydream_filter *ctx, const char *name)
+{
+	obs_data_t *settings = obs_source_get_settings(ctx->source);
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_PRESETS);
+	obs_data_t *preset_settings = NULL;
+	for (size_t i = 0; i < obs_data_array_count(array) && !preset_settings; i++) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		if (strcmp(obs_data_get_string(item, "name"), name) == 0)
+			preset_settings = obs_data_get_obj(item, "settings");
+		obs_data_release(item);
+	}
+	obs_data_array_release(array);
+	obs_data_release(settings);
+
+	if (!preset_settings) {
+		blog(LOG_WARNING, "[Daydream] Preset '%s' not found", name);
+		return;
+	}
+
+	// Otherwise the update below would put a controller's earlier values back over the preset's
+	drop_direct_params(ctx, preset_settings);
+
+	pthread_mutex_lock(&ctx->mutex);
+	struct daydream_preset *preset = find_preset(ctx->presets, ctx->preset_count, name);
+	if (ctx->streaming && preset && preset->payload) {
+		bfree(ctx->preset_payload);
+		ctx->preset_payload = bstrdup(preset->payload);
+		ctx->pending_update_flags = 0;
+		ctx->update_pending = true;
+		ctx->last_update_time_ns = 0;
+		ctx->preset_applying = true;
+
+		// The payload carries the full step schedule and ControlNets, so the governor starts over
+		daydream_governor_destroy(ctx->governor);
+		ctx->governor = NULL;
+		ctx->governor_level = 0;
+		os_event_signal(ctx->update_event);
+	}
+	pthread_mutex_unlock(&ctx->mutex);
+
+	blog(LOG_INFO, "[Daydream] Applying preset '%s'", name);
+	obs_source_update(ctx->source, preset_settings);
+	obs_source_update_properties(ctx->source);
+	obs_data_release(preset_settings);
+}
+
+static void on_preset_hotkey(void *data, obs_hotkey_id id, obs_hotkey_t *hotkey, bool pressed)
+{
+	UNUSED_PARAMETER(id);
+	UNUSED_PARAMETER(hotkey);
+	struct daydream_filter *ctx = data;
+	if (!pressed)
+		return;
+
+	pthread_mutex_lock(&ctx->mutex);
+	char *name = ctx->armed_preset && *ctx->armed_preset ? bstrdup(ctx->armed_preset) : NULL;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	if (name)
+		apply_preset(ctx, name);
+	bfree(name);
+}
+
+static void on_scene_activate(void *data, calldata_t *cd)
+{
+	struct daydream_filter *ctx = data;
+	obs_source_t *source = calldata_ptr(cd, "source");
+	if (!source || obs_source_get_type(source) != OBS_SOURCE_TYPE_SCENE)
+		return;
+
+	const char *scene = obs_source_get_name(source);
+	char *name = NULL;
+	pthread_mutex_lock(&ctx->mutex);
+	for (size_t i = 0; i < ctx->preset_count && !name; i++) {
+		const char *preset_scene = ctx->presets[i].scene;
+		if (preset_scene && *preset_scene && scene && strcmp(preset_scene, scene) == 0)
+			name = bstrdup(ctx->presets[i].name);
+	}
+	pthread_mutex_unlock(&ctx->mutex);
+
+	if (name)
+		apply_preset(ctx, name);
+	bfree(name);
+}
+
 #define PARAMS_UPDATE_DELAY_NS (100 * 1000000ULL) // 100ms debounce
 
 static void *update_thread_func(void *arg)
@@ -429,25 +1092,24 @@ static void *update_thread_func(void *arg)
 
 	while (ctx->update_thread_running) {
 		pthread_mutex_lock(&ctx->mutex);
+		take_direct_params(ctx);
 
-		// Wait for update signal
-		while (ctx->update_thread_running && !ctx->update_pending) {
-			pthread_cond_wait(&ctx->update_cond, &ctx->mutex);
-		}
-
-		if (!ctx->update_thread_running) {
+		// Wait for a settings change, a controller or shutdown
+		if (!ctx->update_pending) {
 			pthread_mutex_unlock(&ctx->mutex);
-			break;
+			os_event_wait(ctx->update_event);
+			continue;
 		}
 
 		// Debounce: wait for 100ms after last change
 		uint64_t target_time = ctx->last_update_time_ns + PARAMS_UPDATE_DELAY_NS;
-		uint64_t now = os_gettime_ns();
+		uint64_t now = daydream_clock_now_ns();
 
 		if (now < target_time) {
 			pthread_mutex_unlock(&ctx->mutex);
-			os_sleep_ms((uint32_t)((target_time - now) / 1000000ULL));
+			daydream_clock_sleep_ms((uint32_t)((target_time - now) / 1000000ULL));
 			pthread_mutex_lock(&ctx->mutex);
+			take_direct_params(ctx);
 		}
 
 		// Check if still pending and no new changes came in
@@ -460,6 +1122,8 @@ static void *update_thread_func(void *arg)
 		uint64_t flags = ctx->pending_update_flags;
 		ctx->pending_update_flags = 0;
 		ctx->update_pending = false;
+		char *preset_payload = ctx->preset_payload;
+		ctx->preset_payload = NULL;
 
 		// Build params struct
 		struct daydream_stream_params params = {0};
@@ -503,6 +1167,8 @@ static void *update_thread_func(void *arg)
 		params.seed_interpolation_method = ctx->seed_interpolation;
 		params.normalize_seed_weights = ctx->normalize_seed_weights;
 
+		daydream_governor_apply(&params, &ctx->governor_limits, ctx->governor_level);
+
 		char *stream_id = bstrdup(ctx->stream_id);
 		const char *api_key = daydream_auth_get_api_key(ctx->auth);
 
@@ -510,12 +1176,17 @@ static void *update_thread_func(void *arg)
 
 		// Send PATCH request
 		if (stream_id && api_key) {
-			bool success = daydream_api_update_stream(api_key, stream_id, &params, flags);
-			if (!success) {
-				blog(LOG_WARNING, "[Daydream] Failed to update stream parameters");
+			if (preset_payload && !daydream_api_send_update(api_key, stream_id, preset_payload))
+				blog(LOG_WARNING, "[Daydream] Failed to apply preset");
+			if (flags) {
+				bool success = daydream_api_update_stream(api_key, stream_id, &params, flags);
+				if (!success) {
+					blog(LOG_WARNING, "[Daydream] Failed to update stream parameters");
+				}
 			}
 		}
 
+		bfree(preset_payload);
 		bfree(stream_id);
 	}
 
@@ -527,11 +1198,452 @@ static void schedule_params_update(struct daydream_filter *ctx, uint64_t flags)
 	pthread_mutex_lock(&ctx->mutex);
 	ctx->pending_update_flags |= flags;
 	ctx->update_pending = true;
-	ctx->last_update_time_ns = os_gettime_ns();
-	pthread_cond_signal(&ctx->update_cond);
+	ctx->last_update_time_ns = daydream_clock_now_ns();
+	pthread_mutex_unlock(&ctx->mutex);
+	os_event_signal(ctx->update_event);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Direct control                                                            */
+
+// External controllers (scripts, MIDI bridges) set live parameters through the source's proc handler:
+//
+//   set_param(in string name, in float value, out bool applied)
+//   set_param_string(in string name, in string value, out bool applied)
+//   set_params(in string json, out int applied)   e.g. {"guidance": 1.5, "prompt_1": "ink wash"}
+//
+// Names are the settings keys. Each call stages the value and its UPDATE_FLAG_* bit under direct_mutex
+// and wakes the update thread, which folds them into the fields and the coalescer under the mutex. A
+// controller at 60-120 Hz therefore never takes the mutex the render thread holds, nor pays for an
+// obs_source_update. The settings catch up lazily, when the filter is updated, its properties are
+// shown or it is saved.
+
+enum direct_param_type {
+	DIRECT_FLOAT,
+	DIRECT_INT,
+	DIRECT_BOOL,
+	DIRECT_STRING,
+};
+
+struct direct_param {
+	const char *name;
+	enum direct_param_type type;
+	size_t offset; // Field in struct daydream_filter
+	double min;    // Range of the matching property
+	double max;
+	uint64_t update_flag;
+};
+
+// Latest value of a parameter: number for numeric and boolean parameters, string for text
+struct direct_value {
+	double number;
+	char *string;
+};
+
+#define DIRECT_FIELD(field) offsetof(struct daydream_filter, field)
+
+static const struct direct_param direct_params[] = {
+	{PROP_PROMPT_1, DIRECT_STRING, DIRECT_FIELD(prompts[0]), 0, 0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_2, DIRECT_STRING, DIRECT_FIELD(prompts[1]), 0, 0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_3, DIRECT_STRING, DIRECT_FIELD(prompts[2]), 0, 0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_4, DIRECT_STRING, DIRECT_FIELD(prompts[3]), 0, 0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_1_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(prompt_weights[0]), 0.0, 1.0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_2_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(prompt_weights[1]), 0.0, 1.0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_3_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(prompt_weights[2]), 0.0, 1.0, UPDATE_FLAG_PROMPT},
+	{PROP_PROMPT_4_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(prompt_weights[3]), 0.0, 1.0, UPDATE_FLAG_PROMPT},
+	{PROP_NEGATIVE_PROMPT, DIRECT_STRING, DIRECT_FIELD(negative_prompt), 0, 0, UPDATE_FLAG_NEGATIVE_PROMPT},
+	{PROP_SEED_1, DIRECT_INT, DIRECT_FIELD(seeds[0]), 0, INT_MAX, UPDATE_FLAG_SEED},
+	{PROP_SEED_2, DIRECT_INT, DIRECT_FIELD(seeds[1]), 0, INT_MAX, UPDATE_FLAG_SEED},
+	{PROP_SEED_3, DIRECT_INT, DIRECT_FIELD(seeds[2]), 0, INT_MAX, UPDATE_FLAG_SEED},
+	{PROP_SEED_4, DIRECT_INT, DIRECT_FIELD(seeds[3]), 0, INT_MAX, UPDATE_FLAG_SEED},
+	{PROP_SEED_1_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(seed_weights[0]), 0.0, 1.0, UPDATE_FLAG_SEED},
+	{PROP_SEED_2_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(seed_weights[1]), 0.0, 1.0, UPDATE_FLAG_SEED},
+	{PROP_SEED_3_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(seed_weights[2]), 0.0, 1.0, UPDATE_FLAG_SEED},
+	{PROP_SEED_4_WEIGHT, DIRECT_FLOAT, DIRECT_FIELD(seed_weights[3]), 0.0, 1.0, UPDATE_FLAG_SEED},
+	{PROP_STEP_1, DIRECT_INT, DIRECT_FIELD(step_indices[0]), 0, 50, UPDATE_FLAG_STEP_SCHEDULE},
+	{PROP_STEP_2, DIRECT_INT, DIRECT_FIELD(step_indices[1]), 0, 50, UPDATE_FLAG_STEP_SCHEDULE},
+	{PROP_STEP_3, DIRECT_INT, DIRECT_FIELD(step_indices[2]), 0, 50, UPDATE_FLAG_STEP_SCHEDULE},
+	{PROP_STEP_4, DIRECT_INT, DIRECT_FIELD(step_indices[3]), 0, 50, UPDATE_FLAG_STEP_SCHEDULE},
+	{PROP_GUIDANCE, DIRECT_FLOAT, DIRECT_FIELD(guidance), 0.1, 20.0, UPDATE_FLAG_GUIDANCE},
+	{PROP_DELTA, DIRECT_FLOAT, DIRECT_FIELD(delta), 0.0, 1.0, UPDATE_FLAG_DELTA},
+	{PROP_IP_ADAPTER_ENABLED, DIRECT_BOOL, DIRECT_FIELD(ip_adapter_enabled), 0, 1, UPDATE_FLAG_IP_ADAPTER},
+	{PROP_IP_ADAPTER_SCALE, DIRECT_FLOAT, DIRECT_FIELD(ip_adapter_scale), 0.0, 1.0, UPDATE_FLAG_IP_ADAPTER},
+	{PROP_DEPTH_SCALE, DIRECT_FLOAT, DIRECT_FIELD(depth_scale), 0.0, 1.0, UPDATE_FLAG_CONTROLNETS},
+	{PROP_CANNY_SCALE, DIRECT_FLOAT, DIRECT_FIELD(canny_scale), 0.0, 1.0, UPDATE_FLAG_CONTROLNETS},
+	{PROP_TILE_SCALE, DIRECT_FLOAT, DIRECT_FIELD(tile_scale), 0.0, 1.0, UPDATE_FLAG_CONTROLNETS},
+	{PROP_OPENPOSE_SCALE, DIRECT_FLOAT, DIRECT_FIELD(openpose_scale), 0.0, 1.0, UPDATE_FLAG_CONTROLNETS},
+	{PROP_HED_SCALE, DIRECT_FLOAT, DIRECT_FIELD(hed_scale), 0.0, 1.0, UPDATE_FLAG_CONTROLNETS},
+	{PROP_COLOR_SCALE, DIRECT_FLOAT, DIRECT_FIELD(color_scale), 0.0, 1.0, UPDATE_FLAG_CONTROLNETS},
+};
+
+#define DIRECT_PARAM_COUNT (sizeof(direct_params) / sizeof(direct_params[0]))
+
+static size_t find_direct_param(const char *name)
+{
+	for (size_t i = 0; name && i < DIRECT_PARAM_COUNT; i++) {
+		if (strcmp(direct_params[i].name, name) == 0)
+			return i;
+	}
+	return DIRECT_PARAM_COUNT;
+}
+
+// Stages one parameter: number for numeric and boolean parameters, string for text. Returns false if
+// the name is unknown or the value has the wrong type. Caller holds ctx->direct_mutex.
+static bool set_direct_param(struct daydream_filter *ctx, const char *name, const double *number,
+			     const char *string, uint64_t *update_flags)
+{
+	size_t idx = find_direct_param(name);
+	if (idx == DIRECT_PARAM_COUNT)
+		return false;
+
+	const struct direct_param *param = &direct_params[idx];
+	if ((param->type == DIRECT_STRING) != (string != NULL) || (param->type != DIRECT_STRING && !number))
+		return false;
+
+	struct direct_value *current = &ctx->direct_values[idx];
+	double value = number ? *number : 0.0;
+	if (!(value >= param->min)) // Also catches NaN
+		value = param->min;
+	if (value > param->max)
+		value = param->max;
+
+	// Rounded to what the field holds, so a repeat of the same value is not a change
+	switch (param->type) {
+	case DIRECT_FLOAT:
+		value = (float)value;
+		break;
+	case DIRECT_INT:
+		value = (int)value;
+		break;
+	case DIRECT_BOOL:
+		value = value != 0.0 ? 1.0 : 0.0;
+		break;
+	case DIRECT_STRING:
+		break;
+	}
+
+	bool changed;
+	if (param->type == DIRECT_STRING) {
+		changed = str_changed(current->string, string);
+		if (changed) {
+			bfree(current->string);
+			current->string = bstrdup(string);
+		}
+	} else {
+		changed = current->number != value;
+		current->number = value;
+	}
+
+	if (changed) {
+		ctx->direct_staged |= 1ULL << idx;
+		ctx->direct_dirty |= 1ULL << idx;
+		*update_flags |= param->update_flag;
+	}
+	return true;
+}
+
+// Hands what the calls changed to the update thread, which sends it through the same debounce as
+// settings changes
+static void finish_direct_params(struct daydream_filter *ctx, uint64_t update_flags)
+{
+	if (update_flags != 0) {
+		ctx->direct_update_flags |= update_flags;
+		ctx->direct_update_time_ns = daydream_clock_now_ns();
+	}
+	pthread_mutex_unlock(&ctx->direct_mutex);
+
+	if (update_flags != 0)
+		os_event_signal(ctx->update_event);
+}
+
+// Folds staged values into the fields and their flags into the coalescer. Caller holds ctx->mutex.
+// Flags are dropped when not streaming, since a stream starts from the fields.
+static void take_direct_params(struct daydream_filter *ctx)
+{
+	pthread_mutex_lock(&ctx->direct_mutex);
+	for (size_t i = 0; ctx->direct_staged && i < DIRECT_PARAM_COUNT; i++) {
+		if (!(ctx->direct_staged & (1ULL << i)))
+			continue;
+
+		const struct direct_param *param = &direct_params[i];
+		const struct direct_value *value = &ctx->direct_values[i];
+		void *field = (char *)ctx + param->offset;
+		switch (param->type) {
+		case DIRECT_FLOAT:
+			*(float *)field = (float)value->number;
+			break;
+		case DIRECT_INT:
+			*(int *)field = (int)value->number;
+			break;
+		case DIRECT_BOOL:
+			*(bool *)field = value->number != 0.0;
+			break;
+		case DIRECT_STRING:
+			if (str_changed(*(char **)field, value->string)) {
+				bfree(*(char **)field);
+				*(char **)field = bstrdup(value->string);
+			}
+			break;
+		}
+		ctx->direct_staged &= ~(1ULL << i);
+	}
+	uint64_t flags = ctx->direct_update_flags;
+	uint64_t time_ns = ctx->direct_update_time_ns;
+	ctx->direct_update_flags = 0;
+	pthread_mutex_unlock(&ctx->direct_mutex);
+
+	if (flags != 0 && ctx->streaming) {
+		ctx->pending_update_flags |= flags;
+		ctx->update_pending = true;
+		if (time_ns > ctx->last_update_time_ns)
+			ctx->last_update_time_ns = time_ns;
+	}
+}
+
+// Reloads the staged values from the fields once filter_update has read the settings. Values a
+// controller set since sync_direct_params are still dirty and stay staged. Caller holds ctx->mutex.
+static void refresh_direct_params(struct daydream_filter *ctx)
+{
+	pthread_mutex_lock(&ctx->direct_mutex);
+	ctx->direct_staged &= ctx->direct_dirty;
+	for (size_t i = 0; i < DIRECT_PARAM_COUNT; i++) {
+		if (ctx->direct_dirty & (1ULL << i))
+			continue;
+
+		const struct direct_param *param = &direct_params[i];
+		const void *field = (const char *)ctx + param->offset;
+		struct direct_value *value = &ctx->direct_values[i];
+		switch (param->type) {
+		case DIRECT_FLOAT:
+			value->number = *(const float *)field;
+			break;
+		case DIRECT_INT:
+			value->number = *(const int *)field;
+			break;
+		case DIRECT_BOOL:
+			value->number = *(const bool *)field ? 1.0 : 0.0;
+			break;
+		case DIRECT_STRING:
+			if (str_changed(value->string, *(char *const *)field)) {
+				bfree(value->string);
+				value->string = bstrdup(*(char *const *)field);
+			}
+			break;
+		}
+	}
+	pthread_mutex_unlock(&ctx->direct_mutex);
+}
+
+static void proc_set_param(void *data, calldata_t *cd)
+{
+	struct daydream_filter *ctx = data;
+	const char *name = NULL;
+	double value = 0.0;
+	uint64_t update_flags = 0;
+	bool applied = false;
+
+	if (calldata_get_string(cd, "name", &name) && calldata_get_float(cd, "value", &value)) {
+		pthread_mutex_lock(&ctx->direct_mutex);
+		applied = set_direct_param(ctx, name, &value, NULL, &update_flags);
+		finish_direct_params(ctx, update_flags);
+	}
+	calldata_set_bool(cd, "applied", applied);
+}
+
+static void proc_set_param_string(void *data, calldata_t *cd)
+{
+	struct daydream_filter *ctx = data;
+	const char *name = NULL;
+	const char *value = NULL;
+	uint64_t update_flags = 0;
+	bool applied = false;
+
+	if (calldata_get_string(cd, "name", &name) && calldata_get_string(cd, "value", &value) && value) {
+		pthread_mutex_lock(&ctx->direct_mutex);
+		applied = set_direct_param(ctx, name, NULL, value, &update_flags);
+		finish_direct_params(ctx, update_flags);
+	}
+	calldata_set_bool(cd, "applied", applied);
+}
+
+// Several parameters from one JSON object, sent as one update. Parsed before taking the lock.
+static void proc_set_params(void *data, calldata_t *cd)
+{
+	struct daydream_filter *ctx = data;
+	const char *json = NULL;
+	obs_data_t *values = calldata_get_string(cd, "json", &json) && json ? obs_data_create_from_json(json) : NULL;
+	uint64_t update_flags = 0;
+	long long applied = 0;
+
+	if (values) {
+		pthread_mutex_lock(&ctx->direct_mutex);
+		for (obs_data_item_t *item = obs_data_first(values); item; obs_data_item_next(&item)) {
+			const char *name = obs_data_item_get_name(item);
+			const char *text;
+			double number;
+			switch (obs_data_item_gettype(item)) {
+			case OBS_DATA_NUMBER:
+				number = obs_data_item_get_double(item);
+				applied += set_direct_param(ctx, name, &number, NULL, &update_flags);
+				break;
+			case OBS_DATA_BOOLEAN:
+				number = obs_data_item_get_bool(item) ? 1.0 : 0.0;
+				applied += set_direct_param(ctx, name, &number, NULL, &update_flags);
+				break;
+			case OBS_DATA_STRING:
+				text = obs_data_item_get_string(item);
+				applied += set_direct_param(ctx, name, NULL, text, &update_flags);
+				break;
+			default:
+				break;
+			}
+		}
+		finish_direct_params(ctx, update_flags);
+		obs_data_release(values);
+	}
+	calldata_set_int(cd, "applied", applied);
+}
+
+static void sync_direct_params(struct daydream_filter *ctx, obs_data_t *settings)
+{
+	pthread_mutex_lock(&ctx->direct_mutex);
+	for (size_t i = 0; ctx->direct_dirty && i < DIRECT_PARAM_COUNT; i++) {
+		if (!(ctx->direct_dirty & (1ULL << i)))
+			continue;
+
+		const struct direct_param *param = &direct_params[i];
+		const struct direct_value *value = &ctx->direct_values[i];
+		switch (param->type) {
+		case DIRECT_FLOAT:
+			obs_data_set_double(settings, param->name, value->number);
+			break;
+		case DIRECT_INT:
+			obs_data_set_int(settings, param->name, (long long)value->number);
+			break;
+		case DIRECT_BOOL:
+			obs_data_set_bool(settings, param->name, value->number != 0.0);
+			break;
+		case DIRECT_STRING:
+			obs_data_set_string(settings, param->name, value->string);
+			break;
+		}
+		ctx->direct_dirty &= ~(1ULL << i);
+	}
+	pthread_mutex_unlock(&ctx->direct_mutex);
+}
+
+// Forgets controller values for the keys in values, which are about to replace them
+static void drop_direct_params(struct daydream_filter *ctx, obs_data_t *values)
+{
+	pthread_mutex_lock(&ctx->direct_mutex);
+	for (size_t i = 0; i < DIRECT_PARAM_COUNT; i++) {
+		if (obs_data_has_user_value(values, direct_params[i].name)) {
+			ctx->direct_dirty &= ~(1ULL << i);
+			ctx->direct_staged &= ~(1ULL << i);
+		}
+	}
+	pthread_mutex_unlock(&ctx->direct_mutex);
+}
+
+static void daydream_filter_save(void *data, obs_data_t *settings)
+{
+	sync_direct_params(data, settings);
+}
+
+#define POWER_REPORT_INTERVAL_NS (60 * 1000000000ULL)
+
+static void note_busy(struct daydream_filter *ctx, uint64_t *counter, uint64_t start_ns)
+{
+	uint64_t elapsed = daydream_clock_now_ns() - start_ns;
+	pthread_mutex_lock(&ctx->mutex);
+	*counter += elapsed;
 	pthread_mutex_unlock(&ctx->mutex);
 }
 
+// Logs the time spent capturing, encoding and decoding, scaled to a minute, so profiles can be compared.
+// This is wall time around each stage: for hardware paths it includes waiting on the GPU or media engine,
+// so it is an estimate of CPU cost rather than a measurement of it.
+static void report_power_usage(struct daydream_filter *ctx, uint64_t now)
+{
+	pthread_mutex_lock(&ctx->mutex);
+	uint64_t window_ns = now - ctx->power_window_start_ns;
+	if (window_ns < POWER_REPORT_INTERVAL_NS) {
+		pthread_mutex_unlock(&ctx->mutex);
+		return;
+	}
+
+	double per_min = 60000.0 / (double)window_ns; // Busy fraction of the window, in ms per minute
+	double capture_ms = (double)ctx->busy_capture_ns * per_min;
+	double encode_ms = (double)ctx->busy_encode_ns * per_min;
+	double decode_ms = (double)ctx->busy_decode_ns * per_min;
+	ctx->busy_ms_per_min = capture_ms + encode_ms + decode_ms;
+	ctx->busy_capture_ns = 0;
+	ctx->busy_encode_ns = 0;
+	ctx->busy_decode_ns = 0;
+	ctx->power_window_start_ns = now;
+	bool low_power = ctx->low_power;
+	double total_ms = ctx->busy_ms_per_min;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	blog(LOG_INFO,
+	     "[Daydream] Estimated pipeline CPU (%s): %.0f ms/min (capture %.0f, encode %.0f, decode %.0f)",
+	     low_power ? "low power" : "balanced", total_ms, capture_ms, encode_ms, decode_ms);
+}
+
+// Low power reads back only the frames it is going to send instead of one per render tick, which also
+// wakes the encode thread once per sent frame. The quarter-interval slack absorbs render jitter so a
+// 60 Hz render loop lands on every fourth tick for 15 fps rather than drifting to every fifth.
+static bool capture_due(struct daydream_filter *ctx)
+{
+	if (ctx->low_power) {
+		uint64_t interval_ns = 1000000000ULL / ctx->target_fps;
+		uint64_t now = daydream_clock_now_ns();
+		if (now + interval_ns / 4 < ctx->next_capture_ns)
+			return false;
+
+		// Keep the cadence unless we fell more than a frame behind (stall, scene switch)
+		if (now - ctx->next_capture_ns < interval_ns || now < ctx->next_capture_ns)
+			ctx->next_capture_ns += interval_ns;
+		else
+			ctx->next_capture_ns = now + interval_ns;
+	}
+
+	// The render governor's last resort: every other frame that would have been sent
+	if (ctx->render_level >= DAYDREAM_RENDER_DECIMATED) {
+		ctx->capture_skipped = !ctx->capture_skipped;
+		return !ctx->capture_skipped;
+	}
+	return true;
+}
+
+// The decoder and recorder are set up before the WHEP answer arrives; switch both if it picked another codec
+static void match_whep_codec(struct daydream_filter *ctx)
+{
+	enum daydream_video_codec codec = daydream_whep_get_codec(ctx->whep);
+	if (codec == daydream_decoder_get_codec(ctx->decoder))
+		return;
+
+	struct daydream_decoder_config config = {
+		.width = ctx->stream_size,
+		.height = ctx->stream_size,
+		.codec = codec,
+	};
+	struct daydream_decoder *decoder = daydream_decoder_acquire(&config);
+	if (!decoder)
+		return;
+
+	blog(LOG_INFO, "[Daydream] Playback negotiated %s, switching decoder from %s",
+	     daydream_video_codec_name(codec), daydream_video_codec_name(daydream_decoder_get_codec(ctx->decoder)));
+	daydream_decoder_release(ctx->decoder);
+	ctx->decoder = decoder;
+
+	// Nothing is written before the first keyframe, so the replaced recorder never opened its file
+	if (ctx->recorder) {
+		daydream_recorder_destroy(ctx->recorder);
+		ctx->recorder = create_recorder(ctx, ctx->stream_size, ctx->stream_size, codec);
+	}
+}
+
 static void on_whep_frame(const uint8_t *data, size_t size, uint32_t rtp_timestamp, bool is_keyframe, void *userdata)
 {
 	struct daydream_filter *ctx = userdata;
@@ -540,7 +1652,14 @@ static void on_whep_frame(const uint8_t *data, size_t size, uint32_t rtp_timesta
 	if (!ctx || !ctx->decoder || ctx->stopping)
 		return;
 
+	match_whep_codec(ctx);
+
 	ctx->frames_received++;
+	ctx->bytes_received += size;
+
+	// Archive the access unit as received; the recorder drops non-monotonic frames itself
+	if (ctx->recorder)
+		daydream_recorder_write(ctx->recorder, data, size, rtp_timestamp);
 
 	// Frame skip: drop out-of-order frames
 	if (ctx->frame_skip_enabled) {
@@ -566,14 +1685,63 @@ static void on_whep_frame(const uint8_t *data, size_t size, uint32_t rtp_timesta
 	}
 
 	struct daydream_decoded_frame decoded;
-	if (!daydream_decoder_decode(ctx->decoder, data, size, &decoded))
+	uint64_t decode_start = daydream_clock_now_ns();
+	bool decoded_ok = daydream_decoder_decode(ctx->decoder, data, size, &decoded);
+	note_busy(ctx, &ctx->busy_decode_ns, decode_start);
+	if (!decoded_ok)
 		return;
 
+	// Motion estimation for frame interpolation, kept off the render thread
+	const float *field = NULL;
+	uint32_t field_cols = 0;
+	uint32_t field_rows = 0;
+	if (ctx->interp_enabled && decoded.is_nv12) {
+		if (!ctx->interp)
+			ctx->interp = daydream_interp_create();
+
+		uint64_t me_start = daydream_clock_now_ns();
+		if (daydream_interp_push_frame(ctx->interp, decoded.y_data, decoded.y_linesize, decoded.width,
+					       decoded.height)) {
+			field = daydream_interp_get_field(ctx->interp, &field_cols, &field_rows);
+			ctx->interp_me_total_ns += daydream_clock_now_ns() - me_start;
+			ctx->interp_me_count++;
+			if (ctx->interp_me_count % 300 == 0) {
+				blog(LOG_INFO,
+				     "[Daydream] Frame interpolation: motion estimation %.2f ms avg per %ux%u frame",
+				     (double)ctx->interp_me_total_ns / (double)ctx->interp_me_count / 1000000.0,
+				     decoded.width, decoded.height);
+			}
+		}
+	} else if (ctx->interp) {
+		daydream_interp_reset(ctx->interp);
+	}
+
 	pthread_mutex_lock(&ctx->mutex);
 
 	// Write to buffer that render isn't reading
 	int write_idx = (ctx->decode_consume_idx == 0) ? 1 : 0;
 
+	ctx->decoded_rtp_ts[write_idx] = rtp_timestamp;
+	ctx->interp_field_valid[write_idx] = false;
+	if (field) {
+		size_t field_size = (size_t)field_cols * field_rows * 2 * sizeof(float);
+
+		if (!ctx->interp_field[0] || ctx->interp_field_cols != field_cols ||
+		    ctx->interp_field_rows != field_rows) {
+			bfree(ctx->interp_field[0]);
+			bfree(ctx->interp_field[1]);
+			ctx->interp_field[0] = bmalloc(field_size);
+			ctx->interp_field[1] = bmalloc(field_size);
+			ctx->interp_field_cols = field_cols;
+			ctx->interp_field_rows = field_rows;
+		}
+
+		memcpy(ctx->interp_field[write_idx], field, field_size);
+		ctx->interp_field_valid[write_idx] = true;
+		ctx->interp_ref_rtp[write_idx] = ctx->interp_last_rtp;
+	}
+	ctx->interp_last_rtp = rtp_timestamp;
+
 	if (decoded.is_nv12) {
 		size_t y_size = decoded.y_linesize * decoded.height;
 		size_t uv_size = decoded.uv_linesize * (decoded.height / 2);
@@ -639,11 +1807,83 @@ static void on_whip_state(bool connected, const char *error, void *userdata)
 static void *whep_connect_thread_func(void *data)
 {
 	struct daydream_filter *ctx = data;
-	daydream_whep_connect(ctx->whep);
+	// The URL the gateway returned, which an alternative playback host may have replaced
+	const char *gateway_url = daydream_whip_get_whep_url(ctx->whip);
+
+	if (!daydream_whep_connect(ctx->whep) && !ctx->stopping && gateway_url &&
+	    strcmp(ctx->whep_url, gateway_url) != 0) {
+		blog(LOG_WARNING, "[Daydream] Playback endpoint %s failed, falling back to %s", ctx->whep_url,
+		     gateway_url);
+
+		pthread_mutex_lock(&ctx->mutex);
+		struct daydream_prober *failed_prober = ctx->playback_prober;
+		ctx->playback_prober = NULL;
+		bfree(ctx->whep_url);
+		ctx->whep_url = bstrdup(gateway_url);
+		pthread_mutex_unlock(&ctx->mutex);
+
+		daydream_prober_destroy(failed_prober);
+		daydream_whep_disconnect(ctx->whep);
+		daydream_whep_set_url(ctx->whep, gateway_url);
+		daydream_whep_connect(ctx->whep);
+	}
 	ctx->whep_thread_running = false;
 	return NULL;
 }
 
+#define FIRST_PACKET_LOG_INTERVAL 300 // Frames, ~10 s at 30 fps
+
+static void note_first_packet(struct daydream_filter *ctx, uint64_t capture_ns)
+{
+	ctx->first_packet_total_ns += daydream_clock_now_ns() - capture_ns;
+	if (++ctx->first_packet_count < FIRST_PACKET_LOG_INTERVAL)
+		return;
+
+	blog(LOG_INFO, "[Daydream] Capture to first packet: %.2f ms avg over %llu frames (%s)",
+	     (double)ctx->first_packet_total_ns / (double)ctx->first_packet_count / 1000000.0,
+	     (unsigned long long)ctx->first_packet_count,
+	     daydream_encoder_is_sliced(ctx->encoder) ? "x264 slices" : "whole frame");
+	ctx->first_packet_total_ns = 0;
+	ctx->first_packet_count = 0;
+}
+
+// Encode thread, from inside daydream_encoder_encode. Every slice of a frame shares its RTP timestamp, and
+// the WHIP track's frame marker clears the RTP marker bit on all but the last slice's final packet.
+static void on_encoded_slice(const uint8_t *data, size_t size, bool is_keyframe, bool last_slice, void *userdata)
+{
+	struct daydream_filter *ctx = userdata;
+
+	if (!ctx->slice_first_sent) {
+		ctx->slice_first_sent = true;
+		note_first_packet(ctx, ctx->slice_capture_ns);
+	}
+	daydream_whip_send_slice(ctx->whip, data, size, ctx->slice_timestamp_ms, is_keyframe, last_slice);
+}
+
+#define RATE_UPDATE_INTERVAL_NS (1000 * 1000000ULL)
+#define RATE_CHANGE_THRESHOLD 0.05 // Smaller steps are not worth an encoder reconfigure
+
+static void update_send_bitrate(struct daydream_filter *ctx, uint64_t now)
+{
+	if (!ctx->rate_controller || !ctx->encoder || now - ctx->last_rate_update_ns < RATE_UPDATE_INTERVAL_NS)
+		return;
+	ctx->last_rate_update_ns = now;
+
+	struct daydream_whip_feedback feedback;
+	if (!daydream_whip_get_feedback(ctx->whip, &feedback))
+		return;
+
+	// Only fresh receiver reports carry a loss sample; otherwise the controller just holds
+	double loss = feedback.reports != ctx->feedback_reports ? feedback.loss_fraction : -1.0;
+	ctx->feedback_reports = feedback.reports;
+
+	uint32_t target = daydream_rate_controller_update(ctx->rate_controller, loss, feedback.remb_bitrate, now);
+	uint32_t current = daydream_encoder_get_bitrate(ctx->encoder);
+	uint32_t change = target > current ? target - current : current - target;
+	if (current == 0 || (double)change >= RATE_CHANGE_THRESHOLD * current)
+		daydream_encoder_set_bitrate(ctx->encoder, target);
+}
+
 static void *encode_thread_func(void *data)
 {
 	struct daydream_filter *ctx = data;
@@ -673,6 +1913,7 @@ static void *encode_thread_func(void *data)
 #endif
 		uint8_t *frame_data = NULL;
 		uint32_t frame_linesize = 0;
+		uint64_t capture_ns = ctx->pending_capture_ns[ctx->pending_produce_idx];
 
 		if (!zerocopy) {
 			// Take ownership of the buffer - no copy needed!
@@ -685,8 +1926,18 @@ static void *encode_thread_func(void *data)
 		pthread_mutex_unlock(&ctx->mutex);
 
 		if (ctx->encoder && ctx->whip && daydream_whip_is_connected(ctx->whip)) {
-			struct daydream_encoded_frame encoded;
+			struct daydream_encoded_frame encoded = {0};
 			bool success = false;
+			uint64_t encode_start = daydream_clock_now_ns();
+
+			// Stamp with capture time (strictly increasing) rather than an ideal frame clock.
+			// Known before encoding, since slices may be sent from inside the encode call.
+			uint32_t timestamp_ms = (uint32_t)((capture_ns - ctx->stream_start_ns) / 1000000);
+			if (ctx->frame_count > 0 && timestamp_ms <= ctx->last_timestamp_ms)
+				timestamp_ms = ctx->last_timestamp_ms + 1;
+			ctx->slice_timestamp_ms = timestamp_ms;
+			ctx->slice_capture_ns = capture_ns;
+			ctx->slice_first_sent = false;
 
 #if defined(__APPLE__)
 			if (zerocopy) {
@@ -698,11 +1949,18 @@ static void *encode_thread_func(void *data)
 			}
 
 			if (success) {
-				uint32_t timestamp_ms = (uint32_t)(ctx->frame_count * 1000 / ctx->target_fps);
-				daydream_whip_send_frame(ctx->whip, encoded.data, encoded.size, timestamp_ms,
-							 encoded.is_keyframe);
+				ctx->last_timestamp_ms = timestamp_ms;
+
+				daydream_latency_mark_sent(ctx->latency, daydream_whip_rtp_timestamp(timestamp_ms),
+							   capture_ns);
+				if (!encoded.sent_as_slices) {
+					daydream_whip_send_frame(ctx->whip, encoded.data, encoded.size, timestamp_ms,
+								 encoded.is_keyframe);
+					note_first_packet(ctx, capture_ns);
+				}
 				ctx->frame_count++;
 			}
+			note_busy(ctx, &ctx->busy_encode_ns, encode_start);
 		}
 
 		// Release buffer ownership
@@ -710,35 +1968,277 @@ static void *encode_thread_func(void *data)
 		ctx->pending_consume_idx = -1;
 		pthread_mutex_unlock(&ctx->mutex);
 
-		uint64_t now = os_gettime_ns();
+		uint64_t now = daydream_clock_now_ns();
 		uint64_t elapsed = now - ctx->last_encode_time;
 		if (elapsed < frame_interval_ns) {
-			os_sleepto_ns(ctx->last_encode_time + frame_interval_ns);
+			daydream_clock_sleepto_ns(ctx->last_encode_time + frame_interval_ns);
 		}
-		ctx->last_encode_time = os_gettime_ns();
+		ctx->last_encode_time = daydream_clock_now_ns();
+		report_power_usage(ctx, ctx->last_encode_time);
+		update_send_bitrate(ctx, ctx->last_encode_time);
 	}
 
 	return NULL;
 }
 
+#define HISTORY_MIN_FRAMES 8
+#define HISTORY_MAX_FRAMES 64 // 64 MiB at 512x512 BGRA
+#define HISTORY_RESIZE_INTERVAL_NS (1000 * 1000000ULL)
+#define HISTORY_MATCH_TOLERANCE_NS (50 * 1000000ULL)
+
+// Graphics context must be held for the history_* helpers
+static void history_free(struct daydream_filter *ctx)
+{
+	for (size_t i = 0; i < ctx->history_capacity; i++) {
+		if (ctx->history_tex[i])
+			gs_texture_destroy(ctx->history_tex[i]);
+	}
+	bfree(ctx->history_tex);
+	bfree(ctx->history_capture_ns);
+	ctx->history_tex = NULL;
+	ctx->history_capture_ns = NULL;
+	ctx->history_capacity = 0;
+	ctx->history_pos = 0;
+	ctx->blend_match_idx = -1;
+}
+
+// Size the ring to cover the measured round trip at the render rate, with headroom
+// for the next AI frame arriving before the matched original is overwritten
+static void history_fit_to_latency(struct daydream_filter *ctx)
+{
+	uint64_t now = daydream_clock_now_ns();
+	if (ctx->history_capacity > 0 && now - ctx->history_last_resize_ns < HISTORY_RESIZE_INTERVAL_NS)
+		return;
+	ctx->history_last_resize_ns = now;
+
+	struct obs_video_info ovi;
+	double fps = 30.0;
+	if (obs_get_video_info(&ovi) && ovi.fps_den > 0)
+		fps = (double)ovi.fps_num / (double)ovi.fps_den;
+
+	uint64_t latency_ns = daydream_latency_get_ns(ctx->latency);
+	if (latency_ns == 0)
+		latency_ns = 400 * 1000000ULL;
+
+	size_t needed = (size_t)((double)latency_ns / 1000000000.0 * fps * 1.5) + 4;
+	if (needed < HISTORY_MIN_FRAMES)
+		needed = HISTORY_MIN_FRAMES;
+	if (needed > HISTORY_MAX_FRAMES)
+		needed = HISTORY_MAX_FRAMES;
+
+	// Grow right away, shrink only once well oversized
+	if (needed <= ctx->history_capacity && needed * 2 > ctx->history_capacity)
+		return;
+
+	for (size_t i = needed; i < ctx->history_capacity; i++) {
+		if (ctx->history_tex[i])
+			gs_texture_destroy(ctx->history_tex[i]);
+	}
+
+	ctx->history_tex = brealloc(ctx->history_tex, needed * sizeof(gs_texture_t *));
+	ctx->history_capture_ns = brealloc(ctx->history_capture_ns, needed * sizeof(uint64_t));
+	for (size_t i = ctx->history_capacity; i < needed; i++) {
+		ctx->history_tex[i] = NULL;
+		ctx->history_capture_ns[i] = 0;
+	}
+
+	ctx->history_capacity = needed;
+	ctx->history_pos %= needed;
+	ctx->blend_match_idx = -1;
+
+	blog(LOG_INFO, "[Daydream] Blend history: %zu frames for %llu ms latency", needed,
+	     (unsigned long long)(latency_ns / 1000000));
+}
+
+static void history_push(struct daydream_filter *ctx, gs_texture_t *crop_tex, uint64_t capture_ns)
+{
+	history_fit_to_latency(ctx);
+
+	size_t slot = ctx->history_pos;
+	uint32_t w = gs_texture_get_width(crop_tex);
+	uint32_t h = gs_texture_get_height(crop_tex);
+
+	gs_texture_t *dst = ctx->history_tex[slot];
+	if (!dst || gs_texture_get_width(dst) != w || gs_texture_get_height(dst) != h) {
+		if (dst)
+			gs_texture_destroy(dst);
+		dst = gs_texture_create(w, h, GS_BGRA, 1, NULL, GS_RENDER_TARGET);
+		ctx->history_tex[slot] = dst;
+	}
+	if (!dst)
+		return;
+
+	gs_copy_texture(dst, crop_tex);
+	ctx->history_capture_ns[slot] = capture_ns;
+	ctx->history_pos = (slot + 1) % ctx->history_capacity;
+}
+
+// Ring slot whose capture time is closest to capture_ns, or -1
+static int history_find(struct daydream_filter *ctx, uint64_t capture_ns)
+{
+	int best = -1;
+	uint64_t best_diff = HISTORY_MATCH_TOLERANCE_NS;
+
+	for (size_t i = 0; i < ctx->history_capacity; i++) {
+		uint64_t slot_ns = ctx->history_capture_ns[i];
+		if (slot_ns == 0 || !ctx->history_tex[i])
+			continue;
+		uint64_t diff = slot_ns > capture_ns ? slot_ns - capture_ns : capture_ns - slot_ns;
+		if (diff <= best_diff) {
+			best_diff = diff;
+			best = (int)i;
+		}
+	}
+	return best;
+}
+
+#define AV_SYNC_CHECK_INTERVAL_NS (1000 * 1000000ULL) // Re-evaluate once per second
+#define AV_SYNC_HYSTERESIS_NS (40 * 1000000LL)         // Ignore drift below ~1 frame at 25 fps
+#define AV_SYNC_MIN_SAMPLES 30                          // Matched frames before the first adjustment
+
+// Put the parent's audio sync offset back the way the user had it
+static void restore_av_sync(struct daydream_filter *ctx)
+{
+	pthread_mutex_lock(&ctx->mutex);
+	bool applied = ctx->av_sync_applied;
+	int64_t original_ns = ctx->av_sync_original_ns;
+	ctx->av_sync_applied = false;
+	ctx->av_sync_offset_ns = 0;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	if (!applied)
+		return;
+
+	obs_source_t *parent = obs_filter_get_parent(ctx->source);
+	if (parent)
+		obs_source_set_sync_offset(parent, original_ns);
+
+	blog(LOG_INFO, "[Daydream] A/V sync: restored audio offset to %lld ms", (long long)(original_ns / 1000000));
+}
+
+// Delay the parent's audio by the measured capture->display latency
+static void update_av_sync(struct daydream_filter *ctx, obs_source_t *parent)
+{
+	if (!ctx->av_sync_enabled || !ctx->streaming) {
+		if (ctx->av_sync_applied)
+			restore_av_sync(ctx);
+		return;
+	}
+
+	uint64_t now = daydream_clock_now_ns();
+	if (now - ctx->av_sync_last_check_ns < AV_SYNC_CHECK_INTERVAL_NS)
+		return;
+	ctx->av_sync_last_check_ns = now;
+
+	if (daydream_latency_get_samples(ctx->latency) < AV_SYNC_MIN_SAMPLES)
+		return;
+
+	// Whole milliseconds are plenty for lip sync
+	int64_t latency_ns = (int64_t)(daydream_latency_get_ns(ctx->latency) / 1000000) * 1000000;
+
+	pthread_mutex_lock(&ctx->mutex);
+	int64_t delta = latency_ns - ctx->av_sync_offset_ns;
+	if (ctx->av_sync_applied && delta > -AV_SYNC_HYSTERESIS_NS && delta < AV_SYNC_HYSTERESIS_NS) {
+		pthread_mutex_unlock(&ctx->mutex);
+		return;
+	}
+
+	if (!ctx->av_sync_applied) {
+		ctx->av_sync_original_ns = obs_source_get_sync_offset(parent);
+		ctx->av_sync_applied = true;
+	}
+	ctx->av_sync_offset_ns = latency_ns;
+	int64_t offset_ns = ctx->av_sync_original_ns + latency_ns;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	obs_source_set_sync_offset(parent, offset_ns);
+	blog(LOG_INFO, "[Daydream] A/V sync: measured latency %lld ms, audio offset set to %lld ms",
+	     (long long)(latency_ns / 1000000), (long long)(offset_ns / 1000000));
+}
+
+#define GOVERNOR_CHECK_INTERVAL_NS (1000 * 1000000ULL)
+
+// Lower or restore the pipeline cost to hold the governor's target output frame rate
+static void update_governor(struct daydream_filter *ctx)
+{
+	if (!ctx->streaming)
+		return;
+
+	uint64_t now = daydream_clock_now_ns();
+	if (now - ctx->governor_last_check_ns < GOVERNOR_CHECK_INTERVAL_NS)
+		return;
+	ctx->governor_last_check_ns = now;
+
+	pthread_mutex_lock(&ctx->mutex);
+	int previous_level = ctx->governor_level;
+	if (!ctx->governor_enabled) {
+		daydream_governor_destroy(ctx->governor);
+		ctx->governor = NULL;
+		ctx->governor_level = 0;
+	} else {
+		// Output cannot run faster than frames are sent
+		double target = ctx->governor_target_fps < (int)ctx->target_fps ? ctx->governor_target_fps
+										    : ctx->target_fps;
+		if (!ctx->governor)
+			ctx->governor = daydream_governor_create(target);
+		daydream_governor_set_target(ctx->governor, target);
+
+		struct daydream_stream_params params = {0};
+		params.model_id = ctx->model;
+		params.step_schedule.count = ctx->step_count;
+		params.controlnets.depth_scale = ctx->depth_scale;
+		params.controlnets.canny_scale = ctx->canny_scale;
+		params.controlnets.tile_scale = ctx->tile_scale;
+		params.controlnets.openpose_scale = ctx->openpose_scale;
+		params.controlnets.hed_scale = ctx->hed_scale;
+		params.controlnets.color_scale = ctx->color_scale;
+		int max_level = daydream_governor_max_level(&params, &ctx->governor_limits);
+
+		ctx->governor_level = daydream_governor_update(ctx->governor, ctx->frames_received,
+								daydream_latency_get_ns(ctx->latency), max_level, now);
+	}
+	bool changed = ctx->governor_level != previous_level;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	if (changed)
+		schedule_params_update(ctx, UPDATE_FLAG_STEP_SCHEDULE | UPDATE_FLAG_CONTROLNETS);
+}
+
 static void *daydream_filter_create(obs_data_t *settings, obs_source_t *source)
 {
 	struct daydream_filter *ctx = bzalloc(sizeof(struct daydream_filter));
 	ctx->source = source;
 	ctx->streaming = false;
 	ctx->stopping = false;
-	ctx->target_fps = 30;
+	ctx->target_fps = DEFAULT_SEND_FPS;
+	ctx->stream_size = DEFAULT_STREAM_SIZE;
+	ctx->busy_ms_per_min = -1.0;
+	ctx->render_cost_ms = -1.0;
 	ctx->frame_count = 0;
 	ctx->pending_consume_idx = -1;
 	ctx->decode_consume_idx = -1;
+	ctx->blend_match_idx = -1;
 
 	pthread_mutex_init(&ctx->mutex, NULL);
 	pthread_cond_init(&ctx->frame_cond, NULL);
-	pthread_cond_init(&ctx->update_cond, NULL);
+	pthread_mutex_init(&ctx->direct_mutex, NULL);
+	os_event_init(&ctx->update_event, OS_EVENT_TYPE_AUTO);
+	ctx->direct_values = bzalloc(DIRECT_PARAM_COUNT * sizeof(*ctx->direct_values));
 
 	ctx->auth = daydream_auth_create();
+	ctx->latency = daydream_latency_create();
 	daydream_filter_update(ctx, settings);
 
+	ctx->preset_hotkey = obs_hotkey_register_source(source, "daydream_apply_preset", "Apply Armed Daydream Preset",
+							on_preset_hotkey, ctx);
+	signal_handler_connect(obs_get_signal_handler(), "source_activate", on_scene_activate, ctx);
+
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+	proc_handler_add(ph, "void set_param(in string name, in float value, out bool applied)", proc_set_param, ctx);
+	proc_handler_add(ph, "void set_param_string(in string name, in string value, out bool applied)",
+			 proc_set_param_string, ctx);
+	proc_handler_add(ph, "void set_params(in string json, out int applied)", proc_set_params, ctx);
+
 	return ctx;
 }
 
@@ -749,7 +2249,7 @@ static void stop_streaming(struct daydream_filter *ctx)
 	// Stop update thread first
 	if (ctx->update_thread_running) {
 		ctx->update_thread_running = false;
-		pthread_cond_signal(&ctx->update_cond);
+		os_event_signal(ctx->update_event);
 		pthread_join(ctx->update_thread, NULL);
 	}
 
@@ -769,6 +2269,19 @@ static void stop_streaming(struct daydream_filter *ctx)
 		ctx->start_thread_running = false;
 	}
 
+	// The encode thread has stopped, so the controller is ours; keep what this network settled on
+	if (ctx->rate_controller) {
+		uint32_t settled = daydream_rate_controller_get_settled(ctx->rate_controller);
+		if (settled > 0 && ctx->network_key) {
+			daydream_bitrate_remember(ctx->network_key, settled);
+			blog(LOG_INFO, "[Daydream] Remembered %u kbps for %s", settled / 1000, ctx->network_key);
+		}
+		daydream_rate_controller_destroy(ctx->rate_controller);
+		ctx->rate_controller = NULL;
+	}
+	bfree(ctx->network_key);
+	ctx->network_key = NULL;
+
 	if (ctx->whip) {
 		daydream_whip_disconnect(ctx->whip);
 		daydream_whip_destroy(ctx->whip);
@@ -781,6 +2294,39 @@ static void stop_streaming(struct daydream_filter *ctx)
 		ctx->whep = NULL;
 	}
 
+	daydream_prober_destroy(ctx->ingest_prober);
+	daydream_prober_destroy(ctx->playback_prober);
+	ctx->ingest_prober = NULL;
+	ctx->playback_prober = NULL;
+
+	// WHEP is gone, so no more writes can arrive
+	if (ctx->recorder) {
+		daydream_recorder_destroy(ctx->recorder);
+		ctx->recorder = NULL;
+	}
+
+	if (ctx->interp) {
+		daydream_interp_destroy(ctx->interp);
+		ctx->interp = NULL;
+	}
+	ctx->interp_me_total_ns = 0;
+	ctx->interp_me_count = 0;
+	ctx->interp_active = false;
+	ctx->render_has_frame = false;
+	ctx->render_is_nv12 = false;
+
+	restore_av_sync(ctx);
+
+	pthread_mutex_lock(&ctx->mutex);
+	daydream_governor_destroy(ctx->governor);
+	ctx->governor = NULL;
+	ctx->governor_level = 0;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	obs_enter_graphics();
+	history_free(ctx);
+	obs_leave_graphics();
+
 #if defined(__APPLE__)
 	if (ctx->iosurface_texture) {
 		obs_enter_graphics();
@@ -792,12 +2338,12 @@ static void stop_streaming(struct daydream_filter *ctx)
 #endif
 
 	if (ctx->encoder) {
-		daydream_encoder_destroy(ctx->encoder);
+		daydream_encoder_release(ctx->encoder);
 		ctx->encoder = NULL;
 	}
 
 	if (ctx->decoder) {
-		daydream_decoder_destroy(ctx->decoder);
+		daydream_decoder_release(ctx->decoder);
 		ctx->decoder = NULL;
 	}
 
@@ -808,6 +2354,8 @@ static void stop_streaming(struct daydream_filter *ctx)
 	// Clear pending updates
 	ctx->pending_update_flags = 0;
 	ctx->update_pending = false;
+	bfree(ctx->preset_payload);
+	ctx->preset_payload = NULL;
 
 	// Trigger UI refresh to re-enable cold parameters
 	obs_source_update_properties(ctx->source);
@@ -817,8 +2365,19 @@ static void daydream_filter_destroy(void *data)
 {
 	struct daydream_filter *ctx = data;
 
+	signal_handler_disconnect(obs_get_signal_handler(), "source_activate", on_scene_activate, ctx);
+	obs_hotkey_unregister(ctx->preset_hotkey);
+
 	stop_streaming(ctx);
 
+	if (ctx->prefetch_thread_created)
+		pthread_join(ctx->prefetch_thread, NULL);
+	for (size_t i = 0; i < ctx->preset_count; i++)
+		preset_free(&ctx->presets[i]);
+	bfree(ctx->presets);
+	bfree(ctx->presets_source);
+	bfree(ctx->armed_preset);
+
 	obs_enter_graphics();
 	if (ctx->texrender)
 		gs_texrender_destroy(ctx->texrender);
@@ -838,42 +2397,440 @@ static void daydream_filter_destroy(void *data)
 		gs_effect_destroy(ctx->nv12_effect);
 	if (ctx->nv12_texrender)
 		gs_texrender_destroy(ctx->nv12_texrender);
+	if (ctx->nv12_prev_tex_y)
+		gs_texture_destroy(ctx->nv12_prev_tex_y);
+	if (ctx->nv12_prev_tex_uv)
+		gs_texture_destroy(ctx->nv12_prev_tex_uv);
+	if (ctx->interp_motion_tex)
+		gs_texture_destroy(ctx->interp_motion_tex);
 	if (ctx->blur_texrender)
 		gs_texrender_destroy(ctx->blur_texrender);
 	if (ctx->blur_texrender2)
 		gs_texrender_destroy(ctx->blur_texrender2);
 	if (ctx->blur_effect)
 		gs_effect_destroy(ctx->blur_effect);
+	if (ctx->blend_effect)
+		gs_effect_destroy(ctx->blend_effect);
+	if (ctx->blend_texrender)
+		gs_texrender_destroy(ctx->blend_texrender);
+	if (ctx->upscale_effect)
+		gs_effect_destroy(ctx->upscale_effect);
+	if (ctx->upscale_texrender)
+		gs_texrender_destroy(ctx->upscale_texrender);
+	if (ctx->upscale_timer)
+		gs_timer_destroy(ctx->upscale_timer);
+	if (ctx->render_timer)
+		gs_timer_destroy(ctx->render_timer);
+	if (ctx->render_timer_range)
+		gs_timer_range_destroy(ctx->render_timer_range);
+	gs_image_file_free(&ctx->blend_mask);
+	history_free(ctx);
 	obs_leave_graphics();
 
-	daydream_auth_destroy(ctx->auth);
+	daydream_auth_destroy(ctx->auth);
+	daydream_latency_destroy(ctx->latency);
+
+	bfree(ctx->negative_prompt);
+	bfree(ctx->model);
+	bfree(ctx->ip_adapter_type);
+	bfree(ctx->style_image_url);
+	bfree(ctx->prompt_interpolation);
+	bfree(ctx->seed_interpolation);
+	bfree(ctx->record_path);
+	bfree(ctx->record_format);
+	bfree(ctx->video_codec);
+	bfree(ctx->blend_mask_path);
+	bfree(ctx->ingest_hosts);
+	bfree(ctx->playback_hosts);
+	bfree(ctx->stun_server);
+	for (int i = 0; i < DAYDREAM_MAX_SCHEDULE_SLOTS; i++) {
+		bfree(ctx->prompts[i]);
+	}
+	bfree(ctx->stream_id);
+	bfree(ctx->whip_url);
+	bfree(ctx->whep_url);
+	bfree(ctx->pending_frame[0]);
+	bfree(ctx->pending_frame[1]);
+	bfree(ctx->decoded_frame[0]);
+	bfree(ctx->decoded_frame[1]);
+	bfree(ctx->nv12_y_data[0]);
+	bfree(ctx->nv12_y_data[1]);
+	bfree(ctx->nv12_uv_data[0]);
+	bfree(ctx->nv12_uv_data[1]);
+	bfree(ctx->interp_field[0]);
+	bfree(ctx->interp_field[1]);
+
+	pthread_cond_destroy(&ctx->frame_cond);
+	for (size_t i = 0; i < DIRECT_PARAM_COUNT; i++)
+		bfree(ctx->direct_values[i].string);
+	bfree(ctx->direct_values);
+
+	os_event_destroy(ctx->update_event);
+	pthread_mutex_destroy(&ctx->direct_mutex);
+	pthread_mutex_destroy(&ctx->mutex);
+
+	bfree(ctx);
+}
+
+// Mix the matched original into the AI frame. Returns the input when no match is available.
+static gs_texture_t *render_blend(struct daydream_filter *ctx, gs_texture_t *ai_tex)
+{
+	if (ctx->blend_mask_dirty) {
+		ctx->blend_mask_dirty = false;
+		gs_image_file_free(&ctx->blend_mask);
+		if (ctx->blend_mask_path && *ctx->blend_mask_path) {
+			gs_image_file_init(&ctx->blend_mask, ctx->blend_mask_path);
+			gs_image_file_init_texture(&ctx->blend_mask);
+			if (!ctx->blend_mask.texture)
+				blog(LOG_WARNING, "[Daydream] Failed to load blend mask: %s", ctx->blend_mask_path);
+		}
+	}
+
+	int idx = ctx->blend_match_idx;
+	if (idx < 0 || (size_t)idx >= ctx->history_capacity || !ctx->history_tex[idx] ||
+	    ctx->history_capture_ns[idx] != ctx->blend_match_capture_ns)
+		return ai_tex;
+
+	if (!ctx->blend_effect) {
+		char *effect_path = obs_module_file("blend.effect");
+		if (effect_path) {
+			ctx->blend_effect = gs_effect_create_from_file(effect_path, NULL);
+			bfree(effect_path);
+		}
+	}
+	if (!ctx->blend_texrender)
+		ctx->blend_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+	if (!ctx->blend_effect || !ctx->blend_texrender)
+		return ai_tex;
+
+	uint32_t w = gs_texture_get_width(ai_tex);
+	uint32_t h = gs_texture_get_height(ai_tex);
+
+	gs_texrender_reset(ctx->blend_texrender);
+	if (!gs_texrender_begin(ctx->blend_texrender, w, h))
+		return ai_tex;
+
+	struct vec4 clear_color;
+	vec4_zero(&clear_color);
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+	gs_ortho(0.0f, (float)w, 0.0f, (float)h, -100.0f, 100.0f);
+
+	gs_texture_t *mask_tex = ctx->blend_mask.texture;
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->blend_effect, "image"), ai_tex);
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->blend_effect, "original"), ctx->history_tex[idx]);
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->blend_effect, "mask"), mask_tex);
+	gs_effect_set_float(gs_effect_get_param_by_name(ctx->blend_effect, "opacity"), ctx->blend_opacity);
+	gs_effect_set_float(gs_effect_get_param_by_name(ctx->blend_effect, "use_mask"), mask_tex ? 1.0f : 0.0f);
+
+	gs_technique_t *tech = gs_effect_get_technique(ctx->blend_effect, "Draw");
+	gs_technique_begin(tech);
+	gs_technique_begin_pass(tech, 0);
+	gs_draw_sprite(ai_tex, 0, w, h);
+	gs_technique_end_pass(tech);
+	gs_technique_end(tech);
+
+	gs_texrender_end(ctx->blend_texrender);
+
+	gs_texture_t *blended = gs_texrender_get_texture(ctx->blend_texrender);
+	return blended ? blended : ai_tex;
+}
+
+// Convert the current NV12 planes to RGB in nv12_texrender. With interpolate set,
+// blend from the previous planes along the motion field at position t.
+static void render_nv12_frame(struct daydream_filter *ctx, uint32_t w, uint32_t h, bool interpolate, float t)
+{
+	if (!ctx->nv12_texrender)
+		ctx->nv12_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+	if (!ctx->nv12_effect || !ctx->nv12_tex_y || !ctx->nv12_tex_uv || !ctx->nv12_texrender)
+		return;
+
+	gs_texrender_reset(ctx->nv12_texrender);
+	if (!gs_texrender_begin(ctx->nv12_texrender, w, h))
+		return;
+
+	struct vec4 clear_color;
+	vec4_zero(&clear_color);
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+	gs_ortho(0.0f, (float)w, 0.0f, (float)h, -100.0f, 100.0f);
+
+	gs_eparam_t *param_y = gs_effect_get_param_by_name(ctx->nv12_effect, "image");
+	gs_eparam_t *param_uv = gs_effect_get_param_by_name(ctx->nv12_effect, "image_uv");
+
+	if (param_y && param_uv) {
+		gs_effect_set_texture(param_y, ctx->nv12_tex_y);
+		gs_effect_set_texture(param_uv, ctx->nv12_tex_uv);
+
+		const char *technique = "Draw";
+		if (interpolate && ctx->nv12_prev_tex_y && ctx->nv12_prev_tex_uv && ctx->interp_motion_tex) {
+			gs_effect_set_texture(gs_effect_get_param_by_name(ctx->nv12_effect, "prev_image"),
+					      ctx->nv12_prev_tex_y);
+			gs_effect_set_texture(gs_effect_get_param_by_name(ctx->nv12_effect, "prev_image_uv"),
+					      ctx->nv12_prev_tex_uv);
+			gs_effect_set_texture(gs_effect_get_param_by_name(ctx->nv12_effect, "motion"),
+					      ctx->interp_motion_tex);
+			gs_effect_set_float(gs_effect_get_param_by_name(ctx->nv12_effect, "interp_t"), t);
+			technique = "DrawInterp";
+		}
+
+		gs_technique_t *tech = gs_effect_get_technique(ctx->nv12_effect, technique);
+		gs_technique_begin(tech);
+		gs_technique_begin_pass(tech, 0);
+		gs_draw_sprite(ctx->nv12_tex_y, 0, w, h);
+		gs_technique_end_pass(tech);
+		gs_technique_end(tech);
+	}
+
+	gs_texrender_end(ctx->nv12_texrender);
+	ctx->nv12_rgb_valid = true;
+}
+
+// Bind the current NV12 planes to the "image"/"image_uv" parameters of nv12_effect
+static void set_nv12_params(struct daydream_filter *ctx)
+{
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->nv12_effect, "image"), ctx->nv12_tex_y);
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->nv12_effect, "image_uv"), ctx->nv12_tex_uv);
+}
+
+#define UPSCALE_MAX_SIZE 4096
+#define UPSCALE_LOG_INTERVAL_NS (10 * 1000000000ULL)
+
+// Periodically logs the GPU time of the measured upscales (collected with the render timer) next to the
+// receive bitrate, which is what a smaller stream size saves
+static void upscale_report(struct daydream_filter *ctx, uint32_t src_size, uint32_t dst_size)
+{
+	uint64_t now = daydream_clock_now_ns();
+	if (ctx->upscale_log_ns == 0) {
+		ctx->upscale_log_ns = now;
+		ctx->bytes_received = 0;
+		return;
+	}
+	if (now - ctx->upscale_log_ns < UPSCALE_LOG_INTERVAL_NS)
+		return;
+
+	double seconds = (double)(now - ctx->upscale_log_ns) / 1000000000.0;
+	double gpu_ms = -1.0;
+	if (ctx->upscale_timed > 0)
+		gpu_ms = (double)ctx->upscale_gpu_ns / (double)ctx->upscale_timed / 1000000.0;
+	blog(LOG_INFO,
+	     "[Daydream] Upscale %ux%u -> %ux%u: %.3f ms GPU per frame over %llu samples, receiving %.0f kbps",
+	     src_size, src_size, dst_size, dst_size, gpu_ms, (unsigned long long)ctx->upscale_timed,
+	     (double)ctx->bytes_received * 8.0 / seconds / 1000.0);
+	ctx->upscale_log_ns = now;
+	ctx->upscale_gpu_ns = 0;
+	ctx->upscale_timed = 0;
+	ctx->bytes_received = 0;
+}
+
+// EASU pass: src upscaled into a size x size target. Returns NULL when the frame is not shown
+// larger than it is, in which case plain bilinear is as good and cheaper.
+static gs_texture_t *render_upscale(struct daydream_filter *ctx, gs_texture_t *src, uint32_t size)
+{
+	uint32_t src_size = gs_texture_get_width(src);
+	if (size <= src_size)
+		return NULL;
+	if (size > UPSCALE_MAX_SIZE)
+		size = UPSCALE_MAX_SIZE;
+
+	if (!ctx->upscale_effect) {
+		char *effect_path = obs_module_file("upscale.effect");
+		if (effect_path) {
+			ctx->upscale_effect = gs_effect_create_from_file(effect_path, NULL);
+			bfree(effect_path);
+		}
+	}
+	if (!ctx->upscale_texrender)
+		ctx->upscale_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+	if (!ctx->upscale_effect || !ctx->upscale_texrender)
+		return NULL;
+
+	upscale_report(ctx, src_size, size);
+
+	gs_texrender_reset(ctx->upscale_texrender);
+	if (!gs_texrender_begin(ctx->upscale_texrender, size, size))
+		return NULL;
+
+	// Measured along with the render timer; it covers this pass and the RCAS draw
+	if (ctx->render_timer_running && !ctx->render_timer_cpu) {
+		if (!ctx->upscale_timer)
+			ctx->upscale_timer = gs_timer_create();
+		if (ctx->upscale_timer) {
+			gs_timer_begin(ctx->upscale_timer);
+			ctx->upscale_timer_pending = true;
+			ctx->upscale_timer_running = true;
+		}
+	}
+
+	struct vec4 clear_color;
+	vec4_zero(&clear_color);
+	gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
+	gs_ortho(0.0f, (float)size, 0.0f, (float)size, -100.0f, 100.0f);
+
+	struct vec2 texel;
+	vec2_set(&texel, 1.0f / (float)src_size, 1.0f / (float)gs_texture_get_height(src));
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->upscale_effect, "image"), src);
+	gs_effect_set_vec2(gs_effect_get_param_by_name(ctx->upscale_effect, "texel_size"), &texel);
+
+	gs_technique_t *tech = gs_effect_get_technique(ctx->upscale_effect, "Easu");
+	gs_technique_begin(tech);
+	gs_technique_begin_pass(tech, 0);
+	gs_draw_sprite(src, 0, size, size);
+	gs_technique_end_pass(tech);
+	gs_technique_end(tech);
+
+	gs_texrender_end(ctx->upscale_texrender);
+	gs_texture_t *upscaled = gs_texrender_get_texture(ctx->upscale_texrender);
+	if (!upscaled && ctx->upscale_timer_running) {
+		gs_timer_end(ctx->upscale_timer);
+		ctx->upscale_timer_running = false;
+	}
+	return upscaled;
+}
+
+// RCAS pass, drawn straight to the output at the displayed size. That is the upscaled size unless the display
+// is larger than UPSCALE_MAX_SIZE, in which case the sharpened result is stretched the rest of the way.
+static void draw_sharpened(struct daydream_filter *ctx, gs_texture_t *upscaled, float x, float y, uint32_t draw_size)
+{
+	uint32_t size = gs_texture_get_width(upscaled);
+
+	struct vec2 texel;
+	vec2_set(&texel, 1.0f / (float)size, 1.0f / (float)gs_texture_get_height(upscaled));
+	gs_effect_set_texture(gs_effect_get_param_by_name(ctx->upscale_effect, "image"), upscaled);
+	gs_effect_set_vec2(gs_effect_get_param_by_name(ctx->upscale_effect, "texel_size"), &texel);
+	gs_effect_set_float(gs_effect_get_param_by_name(ctx->upscale_effect, "sharpness"), ctx->upscale_sharpness);
+
+	gs_technique_t *tech = gs_effect_get_technique(ctx->upscale_effect, "Rcas");
+	gs_technique_begin(tech);
+	gs_technique_begin_pass(tech, 0);
+	gs_matrix_push();
+	gs_matrix_translate3f(x, y, 0.0f);
+	gs_draw_sprite(upscaled, 0, draw_size, draw_size);
+	gs_matrix_pop();
+	gs_technique_end_pass(tech);
+	gs_technique_end(tech);
+
+	if (ctx->upscale_timer_running) {
+		gs_timer_end(ctx->upscale_timer);
+		ctx->upscale_timer_running = false;
+	}
+}
+
+// Levels of the render governor that would change anything with the current settings
+static uint32_t useful_render_levels(const struct daydream_filter *ctx)
+{
+	uint32_t levels = 1u << DAYDREAM_RENDER_FULL;
+	if (ctx->render_decimate)
+		levels |= 1u << DAYDREAM_RENDER_DECIMATED;
+	if (ctx->blur_size >= 4)
+		levels |= 1u << DAYDREAM_RENDER_HALF_BLUR;
+	if (ctx->interp_enabled)
+		levels |= 1u << DAYDREAM_RENDER_NO_INTERP;
+	if (ctx->upscale_enabled)
+		levels |= 1u << DAYDREAM_RENDER_NO_UPSCALE;
+	if (ctx->blur_size > 0)
+		levels |= 1u << DAYDREAM_RENDER_NO_BLUR;
+	return levels;
+}
+
+static void render_cost_sample(struct daydream_filter *ctx, uint64_t cost_ns)
+{
+	if (!ctx->render_cost)
+		ctx->render_cost = daydream_render_cost_create();
+	uint64_t budget_ns = ctx->render_budget_ms > 0.0f ? (uint64_t)(ctx->render_budget_ms * 1000000.0f) : 0;
+	ctx->render_level = daydream_render_cost_update(ctx->render_cost, cost_ns, budget_ns,
+							 useful_render_levels(ctx), daydream_clock_now_ns());
+	ctx->render_cost_ms = daydream_render_cost_get_ms(ctx->render_cost);
+}
+
+static uint64_t timer_ticks_to_ns(uint64_t ticks, uint64_t frequency)
+{
+	return (uint64_t)((double)ticks * 1000000000.0 / (double)frequency);
+}
+
+// Reads back the last measurement once the GPU has it: the filter's passes for the render governor, and
+// the upscale passes within them for upscale_report
+static void collect_render_timers(struct daydream_filter *ctx)
+{
+	if (!ctx->render_timer_pending)
+		return;
+
+	bool disjoint = false;
+	uint64_t frequency = 0;
+	uint64_t ticks = 0;
+	if (!gs_timer_range_get_data(ctx->render_timer_range, &disjoint, &frequency) ||
+	    !gs_timer_get_data(ctx->render_timer, &ticks))
+		return;
+	ctx->render_timer_pending = false;
+
+	bool valid = !disjoint && frequency > 0;
+	if (valid && ctx->streaming)
+		render_cost_sample(ctx, timer_ticks_to_ns(ticks, frequency));
+
+	if (ctx->upscale_timer_pending) {
+		// Ended before the range, so ready with it
+		ctx->upscale_timer_pending = false;
+		uint64_t upscale_ticks = 0;
+		if (gs_timer_get_data(ctx->upscale_timer, &upscale_ticks) && valid) {
+			ctx->upscale_gpu_ns += timer_ticks_to_ns(upscale_ticks, frequency);
+			ctx->upscale_timed++;
+		}
+	}
+}
+
+// Called once the parent has rendered; everything up to end_render_timing is the filter's own cost
+static void begin_render_timing(struct daydream_filter *ctx)
+{
+	// A fresh start for the next stream
+	if (!ctx->streaming) {
+		if (ctx->render_cost) {
+			daydream_render_cost_destroy(ctx->render_cost);
+			ctx->render_cost = NULL;
+		}
+		ctx->render_level = DAYDREAM_RENDER_FULL;
+		ctx->render_cost_ms = -1.0;
+	}
 
-	bfree(ctx->negative_prompt);
-	bfree(ctx->model);
-	bfree(ctx->ip_adapter_type);
-	bfree(ctx->style_image_url);
-	bfree(ctx->prompt_interpolation);
-	bfree(ctx->seed_interpolation);
-	for (int i = 0; i < DAYDREAM_MAX_SCHEDULE_SLOTS; i++) {
-		bfree(ctx->prompts[i]);
+	collect_render_timers(ctx);
+	if (ctx->render_timer_pending || !ctx->streaming)
+		return;
+
+	if (!ctx->render_timer_cpu && (!ctx->render_timer || !ctx->render_timer_range)) {
+		if (!ctx->render_timer)
+			ctx->render_timer = gs_timer_create();
+		if (!ctx->render_timer_range)
+			ctx->render_timer_range = gs_timer_range_create();
+		if (!ctx->render_timer || !ctx->render_timer_range) {
+			blog(LOG_INFO, "[Daydream] No GPU timer queries, timing render passes on the CPU");
+			ctx->render_timer_cpu = true;
+		}
 	}
-	bfree(ctx->stream_id);
-	bfree(ctx->whip_url);
-	bfree(ctx->whep_url);
-	bfree(ctx->pending_frame[0]);
-	bfree(ctx->pending_frame[1]);
-	bfree(ctx->decoded_frame[0]);
-	bfree(ctx->decoded_frame[1]);
-	bfree(ctx->nv12_y_data[0]);
-	bfree(ctx->nv12_y_data[1]);
-	bfree(ctx->nv12_uv_data[0]);
-	bfree(ctx->nv12_uv_data[1]);
 
-	pthread_cond_destroy(&ctx->frame_cond);
-	pthread_cond_destroy(&ctx->update_cond);
-	pthread_mutex_destroy(&ctx->mutex);
+	if (ctx->render_timer_cpu) {
+		ctx->render_cpu_start_ns = daydream_clock_now_ns();
+	} else {
+		gs_timer_range_begin(ctx->render_timer_range);
+		gs_timer_begin(ctx->render_timer);
+		ctx->render_timer_pending = true;
+	}
+	ctx->render_timer_running = true;
+}
 
-	bfree(ctx);
+static void end_render_timing(struct daydream_filter *ctx)
+{
+	if (!ctx->render_timer_running)
+		return;
+	ctx->render_timer_running = false;
+
+	if (ctx->render_timer_cpu) {
+		render_cost_sample(ctx, daydream_clock_now_ns() - ctx->render_cpu_start_ns);
+		return;
+	}
+
+	if (ctx->upscale_timer_running) {
+		gs_timer_end(ctx->upscale_timer);
+		ctx->upscale_timer_running = false;
+	}
+	gs_timer_end(ctx->render_timer);
+	gs_timer_range_end(ctx->render_timer_range);
 }
 
 static void daydream_filter_video_render(void *data, gs_effect_t *effect)
@@ -881,7 +2838,7 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 	struct daydream_filter *ctx = data;
 	UNUSED_PARAMETER(effect);
 
-	const uint32_t STREAM_SIZE = 512;
+	const uint32_t STREAM_SIZE = ctx->stream_size;
 
 	obs_source_t *parent = obs_filter_get_parent(ctx->source);
 	if (!parent)
@@ -930,8 +2887,13 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 	if (!tex)
 		return;
 
+	begin_render_timing(ctx);
+	int render_level = ctx->streaming ? ctx->render_level : DAYDREAM_RENDER_FULL;
+	bool interp_enabled = ctx->interp_enabled && render_level < DAYDREAM_RENDER_NO_INTERP;
+	bool upscale_enabled = ctx->upscale_enabled && render_level < DAYDREAM_RENDER_NO_UPSCALE;
+
 	// Capture and send frames when streaming
-	if (ctx->streaming && ctx->encode_thread_running) {
+	if (ctx->streaming && ctx->encode_thread_running && capture_due(ctx)) {
 #if defined(__APPLE__)
 		// Create IOSurface texture on first frame (must be done in render thread)
 		if (ctx->use_zerocopy && !ctx->iosurface_texture && ctx->encoder) {
@@ -986,6 +2948,7 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 
 			// Signal encode thread - no CPU copy needed!
 			pthread_mutex_lock(&ctx->mutex);
+			ctx->pending_capture_ns[ctx->pending_produce_idx] = daydream_clock_now_ns();
 			ctx->pending_frame_ready = true;
 			pthread_cond_signal(&ctx->frame_cond);
 			pthread_mutex_unlock(&ctx->mutex);
@@ -995,6 +2958,11 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 			// Standard path: copy to CPU buffer
 			if (!ctx->crop_texrender)
 				ctx->crop_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
+			if (ctx->crop_stagesurface &&
+			    gs_stagesurface_get_width(ctx->crop_stagesurface) != STREAM_SIZE) {
+				gs_stagesurface_destroy(ctx->crop_stagesurface);
+				ctx->crop_stagesurface = NULL;
+			}
 			if (!ctx->crop_stagesurface)
 				ctx->crop_stagesurface = gs_stagesurface_create(STREAM_SIZE, STREAM_SIZE, GS_BGRA);
 
@@ -1020,7 +2988,14 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 			}
 
 			gs_texture_t *crop_tex = gs_texrender_get_texture(ctx->crop_texrender);
+			uint64_t capture_ns = daydream_clock_now_ns();
+
+			// Keep the original around until the AI frame made from it comes back
+			if (crop_tex && ctx->blend_opacity > 0.0f)
+				history_push(ctx, crop_tex, capture_ns);
+
 			if (crop_tex) {
+				uint64_t stage_start = daydream_clock_now_ns();
 				gs_stage_texture(ctx->crop_stagesurface, crop_tex);
 
 				uint8_t *video_data = NULL;
@@ -1047,6 +3022,7 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 					int write_idx = (ctx->pending_consume_idx == 0) ? 1 : 0;
 					memcpy(ctx->pending_frame[write_idx], video_data, data_size);
 					ctx->pending_frame_linesize = video_linesize;
+					ctx->pending_capture_ns[write_idx] = capture_ns;
 					ctx->pending_produce_idx = write_idx;
 					ctx->pending_frame_ready = true;
 					pthread_cond_signal(&ctx->frame_cond);
@@ -1054,6 +3030,7 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 					pthread_mutex_unlock(&ctx->mutex);
 					gs_stagesurface_unmap(ctx->crop_stagesurface);
 				}
+				note_busy(ctx, &ctx->busy_capture_ns, stage_start);
 			}
 		} // end of else (standard path)
 	}
@@ -1081,6 +3058,17 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 	// Process outside mutex - WHEP can write to other buffer now
 	if (has_decoded_frame && read_idx >= 0) {
 		if (is_nv12 && ctx->nv12_y_data[read_idx] && ctx->nv12_uv_data[read_idx]) {
+			// Keep the outgoing frame as the interpolation source
+			bool interp_on = interp_enabled;
+			if (interp_on) {
+				gs_texture_t *swap_y = ctx->nv12_prev_tex_y;
+				gs_texture_t *swap_uv = ctx->nv12_prev_tex_uv;
+				ctx->nv12_prev_tex_y = ctx->nv12_tex_y;
+				ctx->nv12_prev_tex_uv = ctx->nv12_tex_uv;
+				ctx->nv12_tex_y = swap_y;
+				ctx->nv12_tex_uv = swap_uv;
+			}
+
 			// Create Y texture
 			if (!ctx->nv12_tex_y || gs_texture_get_width(ctx->nv12_tex_y) != w ||
 			    gs_texture_get_height(ctx->nv12_tex_y) != h) {
@@ -1097,10 +3085,6 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 				ctx->nv12_tex_uv = gs_texture_create(w / 2, h / 2, GS_R8G8, 1, NULL, GS_DYNAMIC);
 			}
 
-			// Create texrender
-			if (!ctx->nv12_texrender)
-				ctx->nv12_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
-
 			// Load effect
 			if (!ctx->nv12_effect) {
 				char *effect_path = obs_module_file("nv12_to_rgb.effect");
@@ -1118,35 +3102,52 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 						     ctx->nv12_uv_linesize, false);
 			}
 
-			// Render NV12 to RGB
-			if (ctx->nv12_effect && ctx->nv12_tex_y && ctx->nv12_tex_uv && ctx->nv12_texrender) {
-				gs_texrender_reset(ctx->nv12_texrender);
-				if (gs_texrender_begin(ctx->nv12_texrender, w, h)) {
-					struct vec4 clear_color;
-					vec4_zero(&clear_color);
-					gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
-					gs_ortho(0.0f, (float)w, 0.0f, (float)h, -100.0f, 100.0f);
-
-					gs_eparam_t *param_y = gs_effect_get_param_by_name(ctx->nv12_effect, "image");
-					gs_eparam_t *param_uv =
-						gs_effect_get_param_by_name(ctx->nv12_effect, "image_uv");
-
-					if (param_y && param_uv) {
-						gs_effect_set_texture(param_y, ctx->nv12_tex_y);
-						gs_effect_set_texture(param_uv, ctx->nv12_tex_uv);
-
-						gs_technique_t *tech =
-							gs_effect_get_technique(ctx->nv12_effect, "Draw");
-						gs_technique_begin(tech);
-						gs_technique_begin_pass(tech, 0);
-						gs_draw_sprite(ctx->nv12_tex_y, 0, w, h);
-						gs_technique_end_pass(tech);
-						gs_technique_end(tech);
+			// Motion-compensated interpolation from the previously shown frame, if the
+			// field was estimated against it and the added latency fits the budget
+			ctx->interp_active = false;
+			if (interp_on && ctx->interp_field_valid[read_idx] && ctx->render_has_frame &&
+			    ctx->interp_ref_rtp[read_idx] == ctx->render_rtp_ts && ctx->nv12_prev_tex_y &&
+			    ctx->nv12_prev_tex_uv && gs_texture_get_width(ctx->nv12_prev_tex_y) == w &&
+			    gs_texture_get_height(ctx->nv12_prev_tex_y) == h) {
+				uint32_t rtp_delta = ctx->decoded_rtp_ts[read_idx] - ctx->render_rtp_ts;
+				uint64_t interval_ns = (uint64_t)rtp_delta * 1000000000ULL / 90000;
+				uint64_t budget_ns = (uint64_t)ctx->interp_budget_ms * 1000000ULL;
+				bool over_budget = rtp_delta == 0 || interval_ns > budget_ns;
+
+				if (over_budget != ctx->interp_over_budget) {
+					blog(LOG_INFO,
+					     "[Daydream] Frame interpolation %s: frame interval %.1f ms, budget %d ms",
+					     over_budget ? "paused" : "resumed", (double)interval_ns / 1000000.0,
+					     ctx->interp_budget_ms);
+					ctx->interp_over_budget = over_budget;
+				}
+
+				if (!over_budget) {
+					uint32_t cols = ctx->interp_field_cols;
+					uint32_t rows = ctx->interp_field_rows;
+					if (!ctx->interp_motion_tex ||
+					    gs_texture_get_width(ctx->interp_motion_tex) != cols ||
+					    gs_texture_get_height(ctx->interp_motion_tex) != rows) {
+						if (ctx->interp_motion_tex)
+							gs_texture_destroy(ctx->interp_motion_tex);
+						ctx->interp_motion_tex =
+							gs_texture_create(cols, rows, GS_RG32F, 1, NULL, GS_DYNAMIC);
 					}
 
-					gs_texrender_end(ctx->nv12_texrender);
+					if (ctx->interp_motion_tex) {
+						gs_texture_set_image(ctx->interp_motion_tex,
+								     (const uint8_t *)ctx->interp_field[read_idx],
+								     cols * 2 * sizeof(float), false);
+						ctx->interp_active = true;
+						ctx->interp_start_ns = daydream_clock_now_ns();
+						ctx->interp_interval_ns = interval_ns;
+					}
 				}
 			}
+			ctx->render_rtp_ts = ctx->decoded_rtp_ts[read_idx];
+			ctx->render_has_frame = true;
+			ctx->render_is_nv12 = true;
+			ctx->nv12_rgb_valid = false;
 		} else if (ctx->decoded_frame[read_idx]) {
 			if (!ctx->output_texture || gs_texture_get_width(ctx->output_texture) != w ||
 			    gs_texture_get_height(ctx->output_texture) != h) {
@@ -1158,30 +3159,85 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 			if (ctx->output_texture) {
 				gs_texture_set_image(ctx->output_texture, ctx->decoded_frame[read_idx], w * 4, false);
 			}
+			ctx->render_is_nv12 = false;
+		}
+
+		// Find the original this AI frame was generated from
+		ctx->blend_match_idx = -1;
+		uint32_t frame_rtp = ctx->decoded_rtp_ts[read_idx];
+		uint64_t matched_capture_ns;
+		if (ctx->blend_opacity > 0.0f &&
+		    daydream_latency_get_capture_time(ctx->latency, frame_rtp, &matched_capture_ns)) {
+			ctx->blend_match_idx = history_find(ctx, matched_capture_ns);
+			if (ctx->blend_match_idx >= 0)
+				ctx->blend_match_capture_ns = ctx->history_capture_ns[ctx->blend_match_idx];
 		}
 
+		// The frame becomes fully visible once any interpolation towards it completes
+		uint64_t display_ns = daydream_clock_now_ns() + (ctx->interp_active ? ctx->interp_interval_ns : 0);
+		daydream_latency_mark_displayed(ctx->latency, frame_rtp, display_ns);
+
 		// Release buffer ownership
 		pthread_mutex_lock(&ctx->mutex);
 		ctx->decode_consume_idx = -1;
 		pthread_mutex_unlock(&ctx->mutex);
 	}
 
+	update_av_sync(ctx, parent);
+	update_governor(ctx);
+
+	// Advance an in-flight interpolation; t reaches 1 one frame interval after arrival
+	if (ctx->interp_active) {
+		float t = 1.0f;
+		if (interp_enabled && ctx->interp_interval_ns > 0) {
+			uint64_t elapsed = daydream_clock_now_ns() - ctx->interp_start_ns;
+			t = (float)((double)elapsed / (double)ctx->interp_interval_ns);
+		}
+		if (t >= 1.0f) {
+			t = 1.0f;
+			ctx->interp_active = false;
+		}
+		render_nv12_frame(ctx, gs_texture_get_width(ctx->nv12_tex_y), gs_texture_get_height(ctx->nv12_tex_y),
+				  true, t);
+	}
+
+	// Interpolation, blending and upscaling work on RGB; otherwise NV12 is composited directly
+	// and the intermediate render target is not needed at all
+	bool needs_rgb = interp_enabled || ctx->blend_opacity > 0.0f || upscale_enabled;
+	if (!needs_rgb && ctx->nv12_texrender) {
+		gs_texrender_destroy(ctx->nv12_texrender);
+		ctx->nv12_texrender = NULL;
+		ctx->nv12_rgb_valid = false;
+	}
+	bool direct_nv12 = ctx->streaming && ctx->render_is_nv12 && !needs_rgb && ctx->nv12_effect && ctx->nv12_tex_y &&
+			   ctx->nv12_tex_uv;
+
 	// Use cached decoded texture if streaming (regardless of new frame)
 	if (ctx->streaming) {
-		if (ctx->nv12_texrender) {
-			gs_texture_t *rgb_tex = gs_texrender_get_texture(ctx->nv12_texrender);
-			if (rgb_tex)
-				output = rgb_tex;
+		if (ctx->render_is_nv12) {
+			if (needs_rgb && !ctx->nv12_rgb_valid && !ctx->interp_active && ctx->nv12_tex_y)
+				render_nv12_frame(ctx, gs_texture_get_width(ctx->nv12_tex_y),
+						  gs_texture_get_height(ctx->nv12_tex_y), false, 1.0f);
+
+			if (needs_rgb && ctx->nv12_texrender) {
+				gs_texture_t *rgb_tex = gs_texrender_get_texture(ctx->nv12_texrender);
+				if (rgb_tex)
+					output = rgb_tex;
+			}
 		} else if (ctx->output_texture) {
 			output = ctx->output_texture;
 		}
 	}
 
+	// Blend the latency-matched original over the AI output
+	if (ctx->streaming && output != tex && ctx->blend_opacity > 0.0f)
+		output = render_blend(ctx, output);
+
 	// Final render
 	gs_effect_t *default_effect = obs_get_base_effect(OBS_EFFECT_DEFAULT);
 	gs_technique_t *tech = gs_effect_get_technique(default_effect, "Draw");
 
-	if (ctx->streaming && output != tex) {
+	if (ctx->streaming && (output != tex || direct_nv12)) {
 		float scale = (parent_width < parent_height) ? (float)STREAM_SIZE / (float)parent_width
 							     : (float)STREAM_SIZE / (float)parent_height;
 		float render_size = STREAM_SIZE / scale;
@@ -1191,6 +3247,10 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 		// Simple color blur: downsample then upscale (bilinear filtering does the rest)
 		gs_texture_t *blur_tex = NULL;
 		int blur_size = ctx->blur_size;
+		if (render_level >= DAYDREAM_RENDER_NO_BLUR)
+			blur_size = 0;
+		else if (render_level >= DAYDREAM_RENDER_HALF_BLUR)
+			blur_size /= 2;
 		if (blur_size > 0) {
 			if (!ctx->blur_texrender)
 				ctx->blur_texrender = gs_texrender_create(GS_BGRA, GS_ZS_NONE);
@@ -1203,13 +3263,21 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 					gs_clear(GS_CLEAR_COLOR, &clear_color, 0.0f, 0);
 					gs_ortho(0.0f, (float)blur_size, 0.0f, (float)blur_size, -100.0f, 100.0f);
 
-					gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"),
-							      output);
-					gs_technique_begin(tech);
-					gs_technique_begin_pass(tech, 0);
-					gs_draw_sprite(output, 0, blur_size, blur_size);
-					gs_technique_end_pass(tech);
-					gs_technique_end(tech);
+					gs_technique_t *blur_tech = tech;
+					gs_texture_t *blur_src = output;
+					if (direct_nv12) {
+						set_nv12_params(ctx);
+						blur_tech = gs_effect_get_technique(ctx->nv12_effect, "Draw");
+						blur_src = ctx->nv12_tex_y;
+					} else {
+						gs_effect_set_texture(
+							gs_effect_get_param_by_name(default_effect, "image"), output);
+					}
+					gs_technique_begin(blur_tech);
+					gs_technique_begin_pass(blur_tech, 0);
+					gs_draw_sprite(blur_src, 0, blur_size, blur_size);
+					gs_technique_end_pass(blur_tech);
+					gs_technique_end(blur_tech);
 
 					gs_texrender_end(ctx->blur_texrender);
 					blur_tex = gs_texrender_get_texture(ctx->blur_texrender);
@@ -1217,6 +3285,34 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 			}
 		}
 
+		if (direct_nv12) {
+			// Single full-frame pass: NV12 inside the content rect, blur (or nothing) outside
+			set_nv12_params(ctx);
+			gs_effect_set_texture(gs_effect_get_param_by_name(ctx->nv12_effect, "blur_image"), blur_tex);
+			gs_effect_set_float(gs_effect_get_param_by_name(ctx->nv12_effect, "use_blur"),
+					    blur_tex ? 1.0f : 0.0f);
+
+			struct vec4 content_rect;
+			vec4_set(&content_rect, render_x / (float)ctx->width, render_y / (float)ctx->height,
+				 (render_x + render_size) / (float)ctx->width,
+				 (render_y + render_size) / (float)ctx->height);
+			gs_eparam_t *rect_param = gs_effect_get_param_by_name(ctx->nv12_effect, "content_rect");
+			gs_effect_set_vec4(rect_param, &content_rect);
+
+			gs_technique_t *composite_tech = gs_effect_get_technique(ctx->nv12_effect, "DrawComposite");
+			gs_technique_begin(composite_tech);
+			gs_technique_begin_pass(composite_tech, 0);
+			gs_draw_sprite(ctx->nv12_tex_y, 0, ctx->width, ctx->height);
+			gs_technique_end_pass(composite_tech);
+			gs_technique_end(composite_tech);
+			end_render_timing(ctx);
+			return;
+		}
+
+		gs_texture_t *upscaled = NULL;
+		if (upscale_enabled && output != tex)
+			upscaled = render_upscale(ctx, output, (uint32_t)(render_size + 0.5f));
+
 		gs_technique_begin(tech);
 		gs_technique_begin_pass(tech, 0);
 
@@ -1227,14 +3323,19 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 		}
 
 		// Draw actual output centered
-		gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), output);
-		gs_matrix_push();
-		gs_matrix_translate3f(render_x, render_y, 0.0f);
-		gs_draw_sprite(output, 0, (uint32_t)render_size, (uint32_t)render_size);
-		gs_matrix_pop();
+		if (!upscaled) {
+			gs_effect_set_texture(gs_effect_get_param_by_name(default_effect, "image"), output);
+			gs_matrix_push();
+			gs_matrix_translate3f(render_x, render_y, 0.0f);
+			gs_draw_sprite(output, 0, (uint32_t)render_size, (uint32_t)render_size);
+			gs_matrix_pop();
+		}
 
 		gs_technique_end_pass(tech);
 		gs_technique_end(tech);
+
+		if (upscaled)
+			draw_sharpened(ctx, upscaled, render_x, render_y, (uint32_t)render_size);
 	} else {
 		gs_technique_begin(tech);
 		gs_technique_begin_pass(tech, 0);
@@ -1243,6 +3344,7 @@ static void daydream_filter_video_render(void *data, gs_effect_t *effect)
 		gs_technique_end_pass(tech);
 		gs_technique_end(tech);
 	}
+	end_render_timing(ctx);
 }
 
 static uint32_t daydream_filter_get_width(void *data)
@@ -1420,12 +3522,80 @@ static bool on_step_count_changed(obs_properties_t *props, obs_property_t *prope
 	return true;
 }
 
+static struct daydream_recorder *create_recorder(struct daydream_filter *ctx, uint32_t width, uint32_t height,
+						 enum daydream_video_codec codec)
+{
+	if (!ctx->record_enabled || !ctx->record_path || !*ctx->record_path)
+		return NULL;
+
+	if (os_mkdirs(ctx->record_path) == MKDIR_ERROR) {
+		blog(LOG_WARNING, "[Daydream] Failed to create recording directory: %s", ctx->record_path);
+		return NULL;
+	}
+
+	const char *ext = (ctx->record_format && strcmp(ctx->record_format, "mp4") == 0) ? "mp4" : "mkv";
+
+	char timestamp[32];
+	time_t now = time(NULL);
+	strftime(timestamp, sizeof(timestamp), "%Y-%m-%d_%H-%M-%S", localtime(&now));
+
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/daydream_%s.%s", ctx->record_path, timestamp, ext);
+
+	struct daydream_recorder_config config = {
+		.path = path.array,
+		.width = width,
+		.height = height,
+		.codec = codec,
+	};
+	struct daydream_recorder *recorder = daydream_recorder_create(&config);
+	dstr_free(&path);
+	return recorder;
+}
+
+#define PROBE_MAX_ENDPOINTS 8
+#define PROBE_TIMEOUT_MS 1000
+#define PROBE_INTERVAL_MS 60000
+
+// Probe url together with copies of it moved onto each comma-separated origin in hosts, and return the
+// fastest as a new string. The same set keeps being re-probed in the background through *prober. Callers
+// fall back to url if the endpoint picked here then fails to connect.
+static char *select_endpoint(const char *url, const char *hosts, const char *label,
+			     struct daydream_prober **prober)
+{
+	*prober = NULL;
+	if (!url)
+		return NULL;
+	if (!hosts || !*hosts)
+		return bstrdup(url);
+
+	char *urls[PROBE_MAX_ENDPOINTS] = {NULL};
+	int64_t rtt_us[PROBE_MAX_ENDPOINTS];
+	size_t count = 0;
+	int best = daydream_probe_select(url, hosts, PROBE_TIMEOUT_MS, urls, rtt_us, PROBE_MAX_ENDPOINTS, &count);
+	for (size_t i = 0; i < count; i++) {
+		if (rtt_us[i] >= 0)
+			blog(LOG_INFO, "[Daydream] %s endpoint %s: %.1f ms", label, urls[i],
+			     (double)rtt_us[i] / 1000.0);
+		else
+			blog(LOG_INFO, "[Daydream] %s endpoint %s: unreachable", label, urls[i]);
+	}
+
+	char *selected = bstrdup(urls[best]);
+	*prober = daydream_prober_create((const char *const *)urls, count, best, PROBE_INTERVAL_MS);
+
+	for (size_t i = 0; i < count; i++)
+		bfree(urls[i]);
+	return selected;
+}
+
 static void *start_streaming_thread_func(void *data)
 {
 	struct daydream_filter *ctx = data;
-	const uint32_t STREAM_SIZE = 512;
-
 	pthread_mutex_lock(&ctx->mutex);
+	// The stream is created with what controllers have set so far
+	take_direct_params(ctx);
+	const uint32_t STREAM_SIZE = ctx->stream_size;
 	const char *api_key = daydream_auth_get_api_key(ctx->auth);
 	char *api_key_copy = api_key ? bstrdup(api_key) : NULL;
 
@@ -1481,6 +3651,8 @@ static void *start_streaming_thread_func(void *data)
 	}
 
 	uint32_t target_fps = ctx->target_fps;
+	char *ingest_hosts = bstrdup(ctx->ingest_hosts);
+	char *playback_hosts = bstrdup(ctx->playback_hosts);
 	pthread_mutex_unlock(&ctx->mutex);
 
 	struct daydream_stream_result result = daydream_api_create_stream(api_key_copy, &params);
@@ -1495,9 +3667,18 @@ static void *start_streaming_thread_func(void *data)
 	bfree((char *)params.prompt_interpolation_method);
 	bfree((char *)params.seed_interpolation_method);
 
+	struct daydream_prober *ingest_prober = NULL;
+	char *whip_url = NULL;
+	if (result.success)
+		whip_url = select_endpoint(result.whip_url, ingest_hosts, "Ingest", &ingest_prober);
+	bfree(ingest_hosts);
+
 	pthread_mutex_lock(&ctx->mutex);
 
 	if (ctx->stopping || !result.success) {
+		daydream_prober_destroy(ingest_prober);
+		bfree(whip_url);
+		bfree(playback_hosts);
 		bfree(api_key_copy);
 		daydream_api_free_result(&result);
 		ctx->start_thread_running = false;
@@ -1510,44 +3691,24 @@ static void *start_streaming_thread_func(void *data)
 	bfree(ctx->whep_url);
 
 	ctx->stream_id = bstrdup(result.stream_id);
-	ctx->whip_url = bstrdup(result.whip_url);
+	ctx->whip_url = whip_url;
 	ctx->whep_url = NULL;
+	ctx->ingest_prober = ingest_prober;
 
-	struct daydream_encoder_config enc_config = {
-		.width = STREAM_SIZE,
-		.height = STREAM_SIZE,
-		.fps = target_fps,
-		.bitrate = 500000,
-#if defined(__APPLE__)
-		// Zero-copy requires Metal backend (OBS 31+), disabled for now due to OpenGL render target issues
-		.use_zerocopy = false,
-#endif
-	};
-	ctx->encoder = daydream_encoder_create(&enc_config);
-	if (!ctx->encoder) {
-		bfree(api_key_copy);
-		daydream_api_free_result(&result);
-		ctx->start_thread_running = false;
-		pthread_mutex_unlock(&ctx->mutex);
-		return NULL;
-	}
-
-#if defined(__APPLE__)
-	// Mark that we want to use zero-copy, texture will be created in render thread
-	if (daydream_encoder_is_zerocopy(ctx->encoder)) {
-		ctx->use_zerocopy = true;
-		blog(LOG_INFO, "[Daydream] Zero-copy encoding requested, texture will be created in render thread");
-	}
-#endif
+	// Offered on both legs in the same order; the decoder starts on the first and follows the WHEP answer
+	enum daydream_video_codec codecs[DAYDREAM_CODEC_COUNT];
+	size_t codec_count = daydream_video_codec_offer(ctx->video_codec, codecs);
 
 	struct daydream_decoder_config dec_config = {
 		.width = STREAM_SIZE,
 		.height = STREAM_SIZE,
+		.codec = codecs[0],
 	};
-	ctx->decoder = daydream_decoder_create(&dec_config);
+	ctx->decoder = daydream_decoder_acquire(&dec_config);
 	if (!ctx->decoder) {
-		daydream_encoder_destroy(ctx->encoder);
-		ctx->encoder = NULL;
+		daydream_prober_destroy(ctx->ingest_prober);
+		ctx->ingest_prober = NULL;
+		bfree(playback_hosts);
 		bfree(api_key_copy);
 		daydream_api_free_result(&result);
 		ctx->start_thread_running = false;
@@ -1561,20 +3722,44 @@ static void *start_streaming_thread_func(void *data)
 		.width = STREAM_SIZE,
 		.height = STREAM_SIZE,
 		.fps = target_fps,
+		.codecs = codecs,
+		.codec_count = codec_count,
+		.stun_server = ctx->stun_server,
 		.on_state = on_whip_state,
 		.userdata = ctx,
 	};
 	ctx->whip = daydream_whip_create(&whip_config);
 	pthread_mutex_unlock(&ctx->mutex);
 
-	if (!daydream_whip_connect(ctx->whip)) {
+	bool connected = daydream_whip_connect(ctx->whip);
+	if (!connected && !ctx->stopping && strcmp(whip_config.whip_url, result.whip_url) != 0) {
+		blog(LOG_WARNING, "[Daydream] Ingest endpoint %s failed, falling back to %s", whip_config.whip_url,
+		     result.whip_url);
+
+		// The prober would keep reporting the endpoint that just failed as the fastest
+		pthread_mutex_lock(&ctx->mutex);
+		struct daydream_prober *failed_prober = ctx->ingest_prober;
+		ctx->ingest_prober = NULL;
+		daydream_whip_destroy(ctx->whip);
+		bfree(ctx->whip_url);
+		ctx->whip_url = bstrdup(result.whip_url);
+		whip_config.whip_url = ctx->whip_url;
+		ctx->whip = daydream_whip_create(&whip_config);
+		pthread_mutex_unlock(&ctx->mutex);
+
+		daydream_prober_destroy(failed_prober);
+		connected = daydream_whip_connect(ctx->whip);
+	}
+
+	if (!connected) {
 		pthread_mutex_lock(&ctx->mutex);
 		daydream_whip_destroy(ctx->whip);
 		ctx->whip = NULL;
-		daydream_encoder_destroy(ctx->encoder);
-		ctx->encoder = NULL;
-		daydream_decoder_destroy(ctx->decoder);
+		daydream_decoder_release(ctx->decoder);
 		ctx->decoder = NULL;
+		daydream_prober_destroy(ctx->ingest_prober);
+		ctx->ingest_prober = NULL;
+		bfree(playback_hosts);
 		bfree(api_key_copy);
 		daydream_api_free_result(&result);
 		ctx->start_thread_running = false;
@@ -1582,11 +3767,87 @@ static void *start_streaming_thread_func(void *data)
 		return NULL;
 	}
 
+	struct daydream_prober *playback_prober = NULL;
+	char *whep_url =
+		select_endpoint(daydream_whip_get_whep_url(ctx->whip), playback_hosts, "Playback", &playback_prober);
+
+	char *network_key = daydream_bitrate_network_key(daydream_whip_get_public_address(ctx->whip),
+							 daydream_whip_get_local_address(ctx->whip));
+	uint32_t start_bitrate = daydream_bitrate_initial(network_key);
+	if (start_bitrate != DAYDREAM_BITRATE_DEFAULT)
+		blog(LOG_INFO, "[Daydream] Starting at %u kbps from history for %s", start_bitrate / 1000,
+		     network_key);
+	else
+		blog(LOG_INFO, "[Daydream] Starting at %u kbps, no history for %s", start_bitrate / 1000,
+		     network_key ? network_key : "this network");
+
 	pthread_mutex_lock(&ctx->mutex);
+
+	// The encoder is created after the SDP answer so it can use the codec and profile the gateway accepted;
+	// this also overlaps encoder setup with the DTLS handshake
+	struct daydream_encoder_config enc_config = {
+		.width = STREAM_SIZE,
+		.height = STREAM_SIZE,
+		.fps = target_fps,
+		.bitrate = start_bitrate,
+		.codec = daydream_whip_get_codec(ctx->whip),
+		.profile = daydream_whip_get_h264_profile(ctx->whip),
+#if defined(__APPLE__)
+		// Zero-copy requires Metal backend (OBS 31+), disabled for now due to OpenGL render target issues
+		.use_zerocopy = false,
+#endif
+		.keyint_ms = ctx->low_power ? LOW_POWER_KEYINT_MS : 0,
+		.on_slice = ctx->sliced_encode_enabled ? on_encoded_slice : NULL,
+		.slice_userdata = ctx,
+	};
+	ctx->encoder = daydream_encoder_acquire(&enc_config);
+	if (!ctx->encoder) {
+		bfree(network_key);
+		daydream_prober_destroy(playback_prober);
+		bfree(whep_url);
+		daydream_whip_destroy(ctx->whip);
+		ctx->whip = NULL;
+		daydream_decoder_release(ctx->decoder);
+		ctx->decoder = NULL;
+		daydream_prober_destroy(ctx->ingest_prober);
+		ctx->ingest_prober = NULL;
+		bfree(playback_hosts);
+		bfree(api_key_copy);
+		daydream_api_free_result(&result);
+		ctx->start_thread_running = false;
+		pthread_mutex_unlock(&ctx->mutex);
+		return NULL;
+	}
+
+#if defined(__APPLE__)
+	// Mark that we want to use zero-copy, texture will be created in render thread
+	if (daydream_encoder_is_zerocopy(ctx->encoder)) {
+		ctx->use_zerocopy = true;
+		blog(LOG_INFO, "[Daydream] Zero-copy encoding requested, texture will be created in render thread");
+	}
+#endif
+
+	ctx->network_key = network_key;
+	ctx->rate_controller = daydream_rate_controller_create(start_bitrate);
+	ctx->feedback_reports = 0;
+	ctx->last_rate_update_ns = 0;
+
 	ctx->streaming = true;
 	ctx->stopping = false;
 	ctx->frame_count = 0;
-	ctx->last_encode_time = os_gettime_ns();
+	ctx->last_encode_time = daydream_clock_now_ns();
+	ctx->stream_start_ns = ctx->last_encode_time;
+	ctx->first_packet_total_ns = 0;
+	ctx->first_packet_count = 0;
+	ctx->last_timestamp_ms = 0;
+	ctx->next_capture_ns = 0;
+	ctx->busy_capture_ns = 0;
+	ctx->busy_encode_ns = 0;
+	ctx->busy_decode_ns = 0;
+	ctx->power_window_start_ns = ctx->last_encode_time;
+	ctx->busy_ms_per_min = -1.0;
+	ctx->upscale_log_ns = 0;
+	daydream_latency_reset(ctx->latency);
 
 	// Reset frame skip stats
 	ctx->frames_received = 0;
@@ -1600,16 +3861,20 @@ static void *start_streaming_thread_func(void *data)
 	ctx->update_thread_running = true;
 	pthread_create(&ctx->update_thread, NULL, update_thread_func, ctx);
 
-	const char *whep_url = daydream_whip_get_whep_url(ctx->whip);
 	if (whep_url) {
-		ctx->whep_url = bstrdup(whep_url);
+		ctx->whep_url = whep_url;
+		ctx->playback_prober = playback_prober;
+		ctx->recorder = create_recorder(ctx, STREAM_SIZE, STREAM_SIZE, codecs[0]);
 
 		struct daydream_whep_config whep_config = {
 			.whep_url = ctx->whep_url,
 			.api_key = NULL,
+			.codecs = codecs,
+			.codec_count = codec_count,
 			.on_frame = on_whep_frame,
 			.on_state = on_whep_state,
 			.userdata = ctx,
+			.bitrate_feedback = ctx->bitrate_feedback_enabled,
 		};
 		ctx->whep = daydream_whep_create(&whep_config);
 
@@ -1617,6 +3882,7 @@ static void *start_streaming_thread_func(void *data)
 		pthread_create(&ctx->whep_thread, NULL, whep_connect_thread_func, ctx);
 	}
 
+	bfree(playback_hosts);
 	bfree(api_key_copy);
 	daydream_api_free_result(&result);
 	ctx->start_thread_running = false;
@@ -1701,6 +3967,97 @@ static bool on_streaming_toggle_clicked(obs_properties_t *props, obs_property_t
 	return true;
 }
 
+// Drop the named preset from the settings array; returns the array, which the caller releases
+static obs_data_array_t *remove_preset_entry(obs_data_t *settings, const char *name)
+{
+	obs_data_array_t *array = obs_data_get_array(settings, PROP_PRESETS);
+	if (!array) {
+		array = obs_data_array_create();
+		obs_data_set_array(settings, PROP_PRESETS, array);
+	}
+	for (size_t i = obs_data_array_count(array); i > 0; i--) {
+		obs_data_t *item = obs_data_array_item(array, i - 1);
+		if (strcmp(obs_data_get_string(item, "name"), name) == 0)
+			obs_data_array_erase(array, i - 1);
+		obs_data_release(item);
+	}
+	return array;
+}
+
+static bool on_preset_save_clicked(obs_properties_t *props, obs_property_t *property, void *data)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct daydream_filter *ctx = data;
+	obs_data_t *settings = obs_source_get_settings(ctx->source);
+	// The preset captures what is live, including values a controller set since the last update
+	sync_direct_params(ctx, settings);
+
+	const char *name = obs_data_get_string(settings, PROP_PRESET_NAME);
+	if (!*name) {
+		obs_data_release(settings);
+		return false;
+	}
+
+	obs_data_array_t *array = remove_preset_entry(settings, name);
+	obs_data_t *item = obs_data_create();
+	obs_data_t *snapshot = preset_snapshot(settings);
+	obs_data_set_string(item, "name", name);
+	obs_data_set_string(item, "scene", obs_data_get_string(settings, PROP_PRESET_SCENE));
+	obs_data_set_obj(item, "settings", snapshot);
+	obs_data_array_push_back(array, item);
+	obs_data_release(snapshot);
+	obs_data_release(item);
+	obs_data_array_release(array);
+
+	obs_data_set_string(settings, PROP_PRESET_ARMED, name);
+	blog(LOG_INFO, "[Daydream] Saved preset '%s'", name);
+	obs_data_release(settings);
+
+	// Rebuilds the payloads and refreshes the armed list
+	obs_source_update(ctx->source, NULL);
+	return true;
+}
+
+static bool on_preset_apply_clicked(obs_properties_t *props, obs_property_t *property, void *data)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct daydream_filter *ctx = data;
+	obs_data_t *settings = obs_source_get_settings(ctx->source);
+	char *name = bstrdup(obs_data_get_string(settings, PROP_PRESET_ARMED));
+	obs_data_release(settings);
+
+	if (*name)
+		apply_preset(ctx, name);
+	bfree(name);
+	return true;
+}
+
+static bool on_preset_delete_clicked(obs_properties_t *props, obs_property_t *property, void *data)
+{
+	UNUSED_PARAMETER(props);
+	UNUSED_PARAMETER(property);
+
+	struct daydream_filter *ctx = data;
+	obs_data_t *settings = obs_source_get_settings(ctx->source);
+	const char *name = obs_data_get_string(settings, PROP_PRESET_ARMED);
+	if (!*name) {
+		obs_data_release(settings);
+		return false;
+	}
+
+	blog(LOG_INFO, "[Daydream] Deleted preset '%s'", name);
+	obs_data_array_release(remove_preset_entry(settings, name));
+	obs_data_set_string(settings, PROP_PRESET_ARMED, "");
+	obs_data_release(settings);
+
+	obs_source_update(ctx->source, NULL);
+	return true;
+}
+
 static obs_properties_t *daydream_filter_get_properties(void *data)
 {
 	struct daydream_filter *ctx = data;
@@ -1708,6 +4065,10 @@ static obs_properties_t *daydream_filter_get_properties(void *data)
 	bool logged_in = daydream_auth_is_logged_in(ctx->auth);
 	bool is_streaming = ctx->streaming;
 
+	obs_data_t *settings = obs_source_get_settings(ctx->source);
+	sync_direct_params(ctx, settings);
+	obs_data_release(settings);
+
 	obs_properties_add_text(props, "title_header", "✦ Daydream ✦", OBS_TEXT_INFO);
 
 	const char *auth_label = logged_in ? "Logout" : "Login with Daydream";
@@ -1854,6 +4215,33 @@ static obs_properties_t *daydream_filter_get_properties(void *data)
 	obs_property_set_enabled(st4, logged_in);
 	obs_property_set_visible(st4, false);
 
+	// Drops step schedule entries from the end, then the weakest ControlNets, while output misses the target
+	obs_property_t *governor = obs_properties_add_bool(props, PROP_GOVERNOR_ENABLED, "Hold Output FPS");
+	obs_property_set_enabled(governor, logged_in);
+
+	obs_property_t *governor_target =
+		obs_properties_add_int_slider(props, PROP_GOVERNOR_TARGET_FPS, "Target Output FPS", 5, 30, 1);
+	obs_property_set_enabled(governor_target, logged_in);
+
+	obs_property_t *governor_min_steps =
+		obs_properties_add_int_slider(props, PROP_GOVERNOR_MIN_STEPS, "Minimum Step Count", 1, 4, 1);
+	obs_property_set_enabled(governor_min_steps, logged_in);
+
+	obs_property_t *governor_controlnet_max = obs_properties_add_float_slider(
+		props, PROP_GOVERNOR_CONTROLNET_MAX, "May Disable ControlNets Up To Scale (0=never)", 0.0, 1.0, 0.01);
+	obs_property_set_enabled(governor_controlnet_max, logged_in);
+
+	// The governor is destroyed under the mutex when switched off or reset by a preset
+	pthread_mutex_lock(&ctx->mutex);
+	bool governor_active = ctx->governor != NULL;
+	int governor_level = ctx->governor_level;
+	pthread_mutex_unlock(&ctx->mutex);
+	if (is_streaming && governor_active) {
+		char governor_buf[128];
+		snprintf(governor_buf, sizeof(governor_buf), "Governor level %d (0 = your settings)", governor_level);
+		obs_properties_add_text(props, "governor_status", governor_buf, OBS_TEXT_INFO);
+	}
+
 	// --- Generation ---
 	obs_properties_add_text(props, "gen_header", "\n\n【 Generation 】", OBS_TEXT_INFO);
 
@@ -1917,6 +4305,106 @@ static obs_properties_t *daydream_filter_get_properties(void *data)
 	obs_property_set_enabled(color_scale, logged_in);
 	obs_property_set_visible(color_scale, false);
 
+	// --- Presets ---
+	obs_properties_add_text(props, "presets_header", "\n\n【 Presets 】", OBS_TEXT_INFO);
+
+	obs_property_t *preset_name = obs_properties_add_text(props, PROP_PRESET_NAME, "Preset Name", OBS_TEXT_DEFAULT);
+	obs_property_set_enabled(preset_name, logged_in);
+
+	obs_property_t *preset_scene =
+		obs_properties_add_text(props, PROP_PRESET_SCENE, "Apply With Scene (optional)", OBS_TEXT_DEFAULT);
+	obs_property_set_enabled(preset_scene, logged_in);
+
+	obs_property_t *preset_save = obs_properties_add_button(props, PROP_PRESET_SAVE, "Save Current as Preset",
+								 on_preset_save_clicked);
+	obs_property_set_enabled(preset_save, logged_in);
+
+	// Armed for the "Apply Armed Daydream Preset" hotkey and the Apply button
+	obs_property_t *preset_armed = obs_properties_add_list(props, PROP_PRESET_ARMED, "Armed Preset",
+								OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(preset_armed, "None", "");
+	pthread_mutex_lock(&ctx->mutex);
+	for (size_t i = 0; i < ctx->preset_count; i++) {
+		struct dstr label = {0};
+		if (ctx->presets[i].scene && *ctx->presets[i].scene)
+			dstr_printf(&label, "%s (scene: %s)", ctx->presets[i].name, ctx->presets[i].scene);
+		else
+			dstr_copy(&label, ctx->presets[i].name);
+		obs_property_list_add_string(preset_armed, label.array, ctx->presets[i].name);
+		dstr_free(&label);
+	}
+	pthread_mutex_unlock(&ctx->mutex);
+	obs_property_set_enabled(preset_armed, logged_in);
+
+	obs_property_t *preset_apply =
+		obs_properties_add_button(props, PROP_PRESET_APPLY, "Apply Armed Preset", on_preset_apply_clicked);
+	obs_property_set_enabled(preset_apply, logged_in);
+
+	obs_property_t *preset_delete =
+		obs_properties_add_button(props, PROP_PRESET_DELETE, "Delete Armed Preset", on_preset_delete_clicked);
+	obs_property_set_enabled(preset_delete, logged_in);
+
+	// --- Recording ---
+	obs_properties_add_text(props, "recording_header", "\n\n【 Recording 】", OBS_TEXT_INFO);
+
+	// Cold parameters: the file is opened when streaming starts
+	obs_property_t *record_enabled = obs_properties_add_bool(props, PROP_RECORD_ENABLED, "Record AI Output");
+	obs_property_set_enabled(record_enabled, logged_in && !is_streaming);
+
+	obs_property_t *record_path =
+		obs_properties_add_path(props, PROP_RECORD_PATH, "Recording Folder", OBS_PATH_DIRECTORY, NULL, NULL);
+	obs_property_set_enabled(record_path, logged_in && !is_streaming);
+
+	obs_property_t *record_format = obs_properties_add_list(props, PROP_RECORD_FORMAT, "Recording Format",
+								OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(record_format, "Matroska (.mkv)", "mkv");
+	obs_property_list_add_string(record_format, "Fragmented MP4 (.mp4)", "mp4");
+	obs_property_set_enabled(record_format, logged_in && !is_streaming);
+
+	// Cold parameter: send rate and encoder settings are fixed when streaming starts
+	obs_property_t *power_profile = obs_properties_add_list(props, PROP_POWER_PROFILE, "Power Profile",
+								OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(power_profile, "Balanced (30 fps)", POWER_PROFILE_BALANCED);
+	obs_property_list_add_string(power_profile, "Low Power (15 fps, no blur/interpolation/blend)",
+				     POWER_PROFILE_LOW);
+	obs_property_set_enabled(power_profile, logged_in && !is_streaming);
+
+	// Cold parameter: sent with the stream create request
+	obs_property_t *stream_size = obs_properties_add_list(props, PROP_STREAM_SIZE, "Stream Resolution",
+							      OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_INT);
+	obs_property_list_add_int(stream_size, "512x512", 512);
+	obs_property_list_add_int(stream_size, "384x384 (about half the server cost)", 384);
+	obs_property_list_add_int(stream_size, "256x256 (about a quarter)", 256);
+	obs_property_set_enabled(stream_size, logged_in && !is_streaming);
+
+	// Cold parameter: offered in the WHIP/WHEP SDP, with H.264 always there as the fallback
+	obs_property_t *video_codec = obs_properties_add_list(props, PROP_VIDEO_CODEC, "Video Codec",
+							      OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+	obs_property_list_add_string(video_codec, "Auto (AV1, VP9, H.264, VP8)", "auto");
+	obs_property_list_add_string(video_codec, "H.264", "h264");
+	const struct {
+		const char *name;
+		const char *value;
+		enum daydream_video_codec codec;
+	} codec_items[] = {
+		{"VP9", "vp9", DAYDREAM_CODEC_VP9},
+		{"AV1", "av1", DAYDREAM_CODEC_AV1},
+		{"VP8", "vp8", DAYDREAM_CODEC_VP8},
+	};
+	for (size_t i = 0; i < sizeof(codec_items) / sizeof(codec_items[0]); i++) {
+		size_t idx = obs_property_list_add_string(video_codec, codec_items[i].name, codec_items[i].value);
+		obs_property_list_item_disable(video_codec, idx,
+					       !daydream_encoder_supports(codec_items[i].codec) ||
+						       !daydream_decoder_supports(codec_items[i].codec));
+	}
+	obs_property_set_enabled(video_codec, logged_in && !is_streaming);
+
+	if (is_streaming && ctx->busy_ms_per_min >= 0.0) {
+		char usage[96];
+		snprintf(usage, sizeof(usage), "Estimated pipeline CPU: %.0f ms per minute", ctx->busy_ms_per_min);
+		obs_properties_add_text(props, "power_usage", usage, OBS_TEXT_INFO);
+	}
+
 	// --- Experimental ---
 	obs_properties_add_text(props, "experimental_header", "\n\n【 Experimental 】", OBS_TEXT_INFO);
 
@@ -1928,6 +4416,102 @@ static obs_properties_t *daydream_filter_get_properties(void *data)
 		obs_properties_add_int_slider(props, PROP_BLUR_SIZE, "Background Blur (0=off)", 0, 64, 4);
 	obs_property_set_enabled(blur_size, logged_in);
 
+	obs_property_t *interp_enabled = obs_properties_add_bool(props, PROP_INTERP_ENABLED, "Frame Interpolation");
+	obs_property_set_enabled(interp_enabled, logged_in);
+
+	obs_property_t *interp_budget = obs_properties_add_int_slider(
+		props, PROP_INTERP_BUDGET, "Interpolation Latency Budget (ms)", 0, 200, 5);
+	obs_property_set_enabled(interp_budget, logged_in);
+
+	obs_property_t *blend_opacity =
+		obs_properties_add_float_slider(props, PROP_BLEND_OPACITY, "Original Blend Opacity", 0.0, 1.0, 0.01);
+	obs_property_set_enabled(blend_opacity, logged_in);
+
+	obs_property_t *blend_mask = obs_properties_add_path(props, PROP_BLEND_MASK, "Blend Mask (white = original)",
+							     OBS_PATH_FILE, "Images (*.png *.jpg *.jpeg *.bmp)", NULL);
+	obs_property_set_enabled(blend_mask, logged_in);
+
+	obs_property_t *upscale_enabled =
+		obs_properties_add_bool(props, PROP_UPSCALE_ENABLED, "Edge-Adaptive Upscaling (EASU/RCAS)");
+	obs_property_set_enabled(upscale_enabled, logged_in);
+
+	obs_property_t *upscale_sharpness = obs_properties_add_float_slider(props, PROP_UPSCALE_SHARPNESS,
+									    "Upscale Sharpening", 0.0, 1.0, 0.05);
+	obs_property_set_enabled(upscale_sharpness, logged_in);
+
+	obs_property_t *render_budget = obs_properties_add_float_slider(
+		props, PROP_RENDER_BUDGET, "Render Budget (ms per frame, 0=unlimited)", 0.0, 10.0, 0.5);
+	obs_property_set_enabled(render_budget, logged_in);
+
+	// Halves what is sent, and so the returned frame rate, so only on request
+	obs_property_t *render_decimate =
+		obs_properties_add_bool(props, PROP_RENDER_DECIMATE, "Render Budget May Halve Capture Rate");
+	obs_property_set_enabled(render_decimate, logged_in);
+
+	if (is_streaming && ctx->render_cost_ms >= 0.0) {
+		char render_cost[128];
+		snprintf(render_cost, sizeof(render_cost), "Render passes: %.2f ms per frame, quality: %s",
+			 ctx->render_cost_ms, daydream_render_level_name(ctx->render_level));
+		obs_properties_add_text(props, "render_cost", render_cost, OBS_TEXT_INFO);
+	}
+
+	obs_property_t *av_sync =
+		obs_properties_add_bool(props, PROP_AV_SYNC_ENABLED, "Auto A/V Sync (delay source audio)");
+	obs_property_set_enabled(av_sync, logged_in);
+
+#if defined(DAYDREAM_X264_DIRECT)
+	// Cold parameter: picks the encoder backend when streaming starts
+	obs_property_t *sliced_encode =
+		obs_properties_add_bool(props, PROP_SLICED_ENCODE, "Sliced x264 Encoding (lower send latency, CPU)");
+	obs_property_set_enabled(sliced_encode, logged_in && !is_streaming);
+#endif
+
+	// Cold parameters: endpoints are probed and chosen when streaming starts
+	obs_property_t *ingest_hosts = obs_properties_add_text(
+		props, PROP_INGEST_HOSTS, "Alternative Ingest Hosts (comma-separated)", OBS_TEXT_DEFAULT);
+	obs_property_set_enabled(ingest_hosts, logged_in && !is_streaming);
+
+	obs_property_t *playback_hosts = obs_properties_add_text(
+		props, PROP_PLAYBACK_HOSTS, "Alternative Playback Hosts (comma-separated)", OBS_TEXT_DEFAULT);
+	obs_property_set_enabled(playback_hosts, logged_in && !is_streaming);
+
+	// Off by default: it contacts a third party and delays connecting if STUN is blocked
+	obs_property_t *stun_server = obs_properties_add_text(
+		props, PROP_STUN_SERVER, "STUN Server for Bitrate History (stun:host:port)", OBS_TEXT_DEFAULT);
+	obs_property_set_enabled(stun_server, logged_in && !is_streaming);
+
+	// Cold parameter: the RTCP session is chained onto the WHEP track at connect time
+	obs_property_t *bitrate_feedback =
+		obs_properties_add_bool(props, PROP_BITRATE_FEEDBACK, "Receiver Bitrate Feedback (REMB)");
+	obs_property_set_enabled(bitrate_feedback, logged_in && !is_streaming);
+
+	if (is_streaming && (ctx->ingest_prober || ctx->playback_prober)) {
+		struct daydream_prober *probers[2] = {ctx->ingest_prober, ctx->playback_prober};
+		const char *labels[2] = {"Ingest", "Playback"};
+		struct dstr probe_status = {0};
+		for (int i = 0; i < 2; i++) {
+			int64_t rtt_us = -1;
+			int best = daydream_prober_get_fastest(probers[i], &rtt_us);
+			if (best < 0)
+				continue;
+			dstr_catf(&probe_status, "%s%s fastest: %s", probe_status.len ? "\n" : "", labels[i],
+				  daydream_prober_get_url(probers[i], best));
+			if (rtt_us >= 0)
+				dstr_catf(&probe_status, " (%.1f ms)", (double)rtt_us / 1000.0);
+		}
+		if (probe_status.len)
+			obs_properties_add_text(props, "probe_status", probe_status.array, OBS_TEXT_INFO);
+		dstr_free(&probe_status);
+	}
+
+	if (is_streaming && ctx->av_sync_applied) {
+		char av_sync_buf[128];
+		snprintf(av_sync_buf, sizeof(av_sync_buf), "Measured latency %lld ms, audio delayed by %lld ms",
+			 (long long)(daydream_latency_get_ns(ctx->latency) / 1000000),
+			 (long long)(ctx->av_sync_offset_ns / 1000000));
+		obs_properties_add_text(props, "av_sync_status", av_sync_buf, OBS_TEXT_INFO);
+	}
+
 	// --- About ---
 	obs_properties_add_text(props, "about_header", "\n\n【 About 】", OBS_TEXT_INFO);
 
@@ -1982,6 +4566,15 @@ static void daydream_filter_get_defaults(obs_data_t *settings)
 	obs_data_set_default_int(settings, PROP_STEP_2, 0);
 	obs_data_set_default_int(settings, PROP_STEP_3, 0);
 	obs_data_set_default_int(settings, PROP_STEP_4, 0);
+	obs_data_set_default_bool(settings, PROP_GOVERNOR_ENABLED, false);
+	obs_data_set_default_int(settings, PROP_GOVERNOR_TARGET_FPS, 20);
+	obs_data_set_default_int(settings, PROP_GOVERNOR_MIN_STEPS, 1);
+	obs_data_set_default_double(settings, PROP_GOVERNOR_CONTROLNET_MAX, 0.0);
+
+	// Presets defaults
+	obs_data_set_default_string(settings, PROP_PRESET_NAME, "");
+	obs_data_set_default_string(settings, PROP_PRESET_SCENE, "");
+	obs_data_set_default_string(settings, PROP_PRESET_ARMED, "");
 
 	// IP Adapter defaults
 	obs_data_set_default_bool(settings, PROP_IP_ADAPTER_ENABLED, true);
@@ -1997,9 +4590,32 @@ static void daydream_filter_get_defaults(obs_data_t *settings)
 	obs_data_set_default_double(settings, PROP_HED_SCALE, 0.0);
 	obs_data_set_default_double(settings, PROP_COLOR_SCALE, 0.0);
 
+	// Recording defaults
+	obs_data_set_default_bool(settings, PROP_RECORD_ENABLED, false);
+	obs_data_set_default_string(settings, PROP_RECORD_PATH, "");
+	obs_data_set_default_string(settings, PROP_RECORD_FORMAT, "mkv");
+
+	obs_data_set_default_string(settings, PROP_POWER_PROFILE, POWER_PROFILE_BALANCED);
+	obs_data_set_default_int(settings, PROP_STREAM_SIZE, DEFAULT_STREAM_SIZE);
+	obs_data_set_default_string(settings, PROP_VIDEO_CODEC, "auto");
+
 	// Experimental defaults
 	obs_data_set_default_bool(settings, PROP_FRAME_SKIP_ENABLED, true);
 	obs_data_set_default_int(settings, PROP_BLUR_SIZE, 2);
+	obs_data_set_default_bool(settings, PROP_INTERP_ENABLED, false);
+	obs_data_set_default_int(settings, PROP_INTERP_BUDGET, 70);
+	obs_data_set_default_bool(settings, PROP_AV_SYNC_ENABLED, false);
+	obs_data_set_default_double(settings, PROP_BLEND_OPACITY, 0.0);
+	obs_data_set_default_string(settings, PROP_BLEND_MASK, "");
+	obs_data_set_default_bool(settings, PROP_UPSCALE_ENABLED, false);
+	obs_data_set_default_double(settings, PROP_UPSCALE_SHARPNESS, 0.5);
+	obs_data_set_default_double(settings, PROP_RENDER_BUDGET, 0.0);
+	obs_data_set_default_bool(settings, PROP_RENDER_DECIMATE, false);
+	obs_data_set_default_bool(settings, PROP_SLICED_ENCODE, false);
+	obs_data_set_default_string(settings, PROP_INGEST_HOSTS, "");
+	obs_data_set_default_string(settings, PROP_STUN_SERVER, "");
+	obs_data_set_default_string(settings, PROP_PLAYBACK_HOSTS, "");
+	obs_data_set_default_bool(settings, PROP_BITRATE_FEEDBACK, false);
 }
 
 static struct obs_source_info daydream_filter_info = {
@@ -2015,6 +4631,7 @@ static struct obs_source_info daydream_filter_info = {
 	.video_render = daydream_filter_video_render,
 	.get_properties = daydream_filter_get_properties,
 	.get_defaults = daydream_filter_get_defaults,
+	.save = daydream_filter_save,
 };
 
 void daydream_filter_register(void)
@@ -0,0 +1,159 @@
+#include "daydream-governor.h"
+#include "daydream-hysteresis.h"
+#include <obs-module.h>
+
+// Long enough to average out jitter at low frame rates, short enough to react within a few seconds.
+// The window after a change includes the time the live update takes to reach the pipeline.
+#define WINDOW_NS (5 * 1000000000ULL)
+#define SHORTFALL 0.9          // Below this fraction of the target counts as missing it
+#define RECOVER_WINDOWS 6      // Windows on target before trying the level above
+#define RECOVER_WINDOWS_MAX 24 // Backoff limit after failed attempts
+
+struct daydream_governor {
+	double target_fps;
+	struct daydream_hysteresis levels;
+
+	uint64_t window_start_ns;
+	uint64_t window_frames;
+
+	// Measured in the window before the last change
+	double before_fps;
+	uint64_t before_latency_ns;
+};
+
+struct daydream_governor *daydream_governor_create(double target_fps)
+{
+	struct daydream_governor *gov = bzalloc(sizeof(struct daydream_governor));
+	gov->target_fps = target_fps;
+	daydream_hysteresis_init(&gov->levels, RECOVER_WINDOWS, RECOVER_WINDOWS_MAX);
+	return gov;
+}
+
+void daydream_governor_destroy(struct daydream_governor *gov)
+{
+	bfree(gov);
+}
+
+void daydream_governor_set_target(struct daydream_governor *gov, double target_fps)
+{
+	gov->target_fps = target_fps;
+}
+
+static const char *change_reasons[] = {
+	[DAYDREAM_LEVEL_LOWERED] = "Output below target",
+	[DAYDREAM_LEVEL_RAISED] = "Output on target",
+	[DAYDREAM_LEVEL_BACKED_OFF] = "Recovery fell short",
+};
+
+int daydream_governor_update(struct daydream_governor *gov, uint64_t frames_received, uint64_t latency_ns,
+			     int max_level, uint64_t now_ns)
+{
+	struct daydream_hysteresis *levels = &gov->levels;
+
+	// Nothing to judge until the pipeline has warmed up and frames are coming back
+	if (frames_received == 0)
+		return levels->level;
+	if (gov->window_start_ns == 0) {
+		gov->window_start_ns = now_ns;
+		gov->window_frames = frames_received;
+		return levels->level;
+	}
+	if (now_ns - gov->window_start_ns < WINDOW_NS)
+		return levels->level;
+
+	double fps = (double)(frames_received - gov->window_frames) * 1000000000.0 /
+		     (double)(now_ns - gov->window_start_ns);
+	gov->window_start_ns = now_ns;
+	gov->window_frames = frames_received;
+
+	// The operator may have changed the settings the levels are counted from
+	if (levels->level > max_level)
+		levels->level = max_level;
+
+	bool short_of_target = fps < gov->target_fps * SHORTFALL;
+	int lower = levels->level < max_level ? levels->level + 1 : levels->level;
+	int higher = levels->level > 0 ? levels->level - 1 : 0;
+	struct daydream_level_step step = daydream_hysteresis_update(
+		levels, short_of_target ? DAYDREAM_WINDOW_BAD : DAYDREAM_WINDOW_GOOD, lower, higher);
+
+	if (step.reported)
+		blog(LOG_INFO, "[Daydream Governor] Level %d -> %d: %.1f -> %.1f fps, latency %llu -> %llu ms",
+		     step.reported_from, step.reported_to, gov->before_fps, fps,
+		     (unsigned long long)(gov->before_latency_ns / 1000000),
+		     (unsigned long long)(latency_ns / 1000000));
+
+	if (step.change != DAYDREAM_LEVEL_KEPT) {
+		blog(LOG_INFO, "[Daydream Governor] %s at %.1f fps (target %.1f), level %d -> %d",
+		     change_reasons[step.change], fps, gov->target_fps, step.changed_from, levels->level);
+		gov->before_fps = fps;
+		gov->before_latency_ns = latency_ns;
+	}
+	return levels->level;
+}
+
+int daydream_governor_get_level(const struct daydream_governor *gov)
+{
+	return gov ? gov->levels.level : 0;
+}
+
+static int removable_steps(const struct daydream_stream_params *params, const struct daydream_governor_limits *limits)
+{
+	int min_steps = limits->min_steps > 1 ? limits->min_steps : 1;
+	return params->step_schedule.count > min_steps ? params->step_schedule.count - min_steps : 0;
+}
+
+static float *controlnet_scale(struct daydream_controlnet_params *controlnets, size_t offset)
+{
+	return (float *)((char *)controlnets + offset);
+}
+
+// Enabled ControlNets of the model that the limits allow disabling
+static size_t sheddable_controlnets(struct daydream_controlnet_params *controlnets, const char *model_id,
+				    const struct daydream_governor_limits *limits, float *scales[], size_t max)
+{
+	size_t offsets[8];
+	size_t field_count = daydream_api_controlnet_fields(model_id, offsets, 8);
+	size_t count = 0;
+	for (size_t i = 0; i < field_count && count < max; i++) {
+		float *scale = controlnet_scale(controlnets, offsets[i]);
+		if (*scale >= DAYDREAM_CONTROLNET_MIN_SCALE && *scale <= limits->controlnet_max_scale)
+			scales[count++] = scale;
+	}
+	return count;
+}
+
+int daydream_governor_max_level(const struct daydream_stream_params *params,
+				const struct daydream_governor_limits *limits)
+{
+	struct daydream_controlnet_params controlnets = params->controlnets;
+	float *scales[8];
+	return removable_steps(params, limits) +
+	       (int)sheddable_controlnets(&controlnets, params->model_id, limits, scales, 8);
+}
+
+void daydream_governor_apply(struct daydream_stream_params *params, const struct daydream_governor_limits *limits,
+			     int level)
+{
+	if (level <= 0)
+		return;
+
+	// Later t_index_list entries are the finest refinement passes, so they go first
+	int steps = removable_steps(params, limits);
+	if (steps > level)
+		steps = level;
+	params->step_schedule.count -= steps;
+	level -= steps;
+
+	// Then the weakest ControlNets, whose preprocessors cost as much as the strongest
+	float *scales[8];
+	size_t count = sheddable_controlnets(&params->controlnets, params->model_id, limits, scales, 8);
+	for (; level > 0 && count > 0; level--) {
+		size_t weakest = 0;
+		for (size_t i = 1; i < count; i++) {
+			if (*scales[i] < *scales[weakest])
+				weakest = i;
+		}
+		*scales[weakest] = 0.0f;
+		scales[weakest] = scales[--count];
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "daydream-api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Output frame rate governor. When the gateway delivers fewer frames than the target, it lowers the
+// pipeline cost one level at a time: first by dropping t_index_list entries from the end of the step
+// schedule, then by disabling the weakest ControlNets. Once the target has held for a while, it tries
+// the level above again and backs off longer if that falls short. Not thread-safe.
+struct daydream_governor;
+
+// How far the governor may go, set by the operator
+struct daydream_governor_limits {
+	int min_steps;              // Never fewer t_index_list entries than this
+	float controlnet_max_scale; // Only ControlNets at or below this scale may be disabled; 0 disables none
+};
+
+struct daydream_governor *daydream_governor_create(double target_fps);
+void daydream_governor_destroy(struct daydream_governor *gov);
+void daydream_governor_set_target(struct daydream_governor *gov, double target_fps);
+
+// Feed the running count of frames received and the current capture->display latency, from any
+// periodic caller. Returns the level to run at, 0 being the operator's own settings. Every change,
+// and the frame rate and latency seen after it, is logged.
+int daydream_governor_update(struct daydream_governor *gov, uint64_t frames_received, uint64_t latency_ns,
+			     int max_level, uint64_t now_ns);
+
+int daydream_governor_get_level(const struct daydream_governor *gov);
+
+// Number of levels params can be lowered by within limits
+int daydream_governor_max_level(const struct daydream_stream_params *params,
+				const struct daydream_governor_limits *limits);
+
+// Lower params to level, clamped to daydream_governor_max_level
+void daydream_governor_apply(struct daydream_stream_params *params, const struct daydream_governor_limits *limits,
+			     int level);
+
+#ifdef __cplusplus
+}
+#endif
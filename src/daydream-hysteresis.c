@@ -0,0 +1,71 @@
+#include "daydream-hysteresis.h"
+
+void daydream_hysteresis_init(struct daydream_hysteresis *h, int recover_windows, int recover_windows_max)
+{
+	h->recover_windows_min = recover_windows;
+	h->recover_windows_max = recover_windows_max;
+	daydream_hysteresis_reset(h);
+}
+
+void daydream_hysteresis_reset(struct daydream_hysteresis *h)
+{
+	h->level = 0;
+	h->good_windows = 0;
+	h->recover_windows = h->recover_windows_min;
+	h->reporting = false;
+	h->probing = false;
+	h->previous_level = 0;
+}
+
+static void change_level(struct daydream_hysteresis *h, struct daydream_level_step *step, int level,
+			 enum daydream_level_change change)
+{
+	step->change = change;
+	step->changed_from = h->level;
+	h->previous_level = h->level;
+	h->level = level;
+	h->reporting = true;
+	h->good_windows = 0;
+}
+
+struct daydream_level_step daydream_hysteresis_update(struct daydream_hysteresis *h,
+						      enum daydream_window_verdict verdict, int lower, int higher)
+{
+	struct daydream_level_step step = {0};
+
+	if (h->reporting) {
+		h->reporting = false;
+		step.reported = true;
+		step.reported_from = h->previous_level;
+		step.reported_to = h->level;
+
+		if (h->probing) {
+			h->probing = false;
+			if (verdict == DAYDREAM_WINDOW_BAD && lower != h->level) {
+				h->recover_windows *= 2;
+				if (h->recover_windows > h->recover_windows_max)
+					h->recover_windows = h->recover_windows_max;
+				change_level(h, &step, lower, DAYDREAM_LEVEL_BACKED_OFF);
+			}
+		}
+		return step;
+	}
+
+	if (verdict == DAYDREAM_WINDOW_BAD) {
+		h->good_windows = 0;
+		if (lower != h->level)
+			change_level(h, &step, lower, DAYDREAM_LEVEL_LOWERED);
+		return step;
+	}
+
+	if (verdict == DAYDREAM_WINDOW_HOLD) {
+		h->good_windows = 0;
+		return step;
+	}
+
+	if (higher != h->level && ++h->good_windows >= h->recover_windows) {
+		h->probing = true;
+		change_level(h, &step, higher, DAYDREAM_LEVEL_RAISED);
+	}
+	return step;
+}
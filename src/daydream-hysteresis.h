@@ -0,0 +1,63 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Level stepping shared by the governors. Level 0 is full quality and higher levels cost less. A bad
+// window moves one level down in quality; a run of good windows tries the level above, and if the window
+// right after that is bad, the run needed next time doubles up to a limit. Callers measure the windows,
+// pick the neighbouring levels and do the logging. Not thread-safe.
+struct daydream_hysteresis {
+	int level;
+	int good_windows;
+	int recover_windows;
+	int recover_windows_min;
+	int recover_windows_max;
+
+	// The last change, reported once the window after it completes
+	bool reporting;
+	bool probing; // The last change raised quality and is on trial
+	int previous_level;
+};
+
+enum daydream_window_verdict {
+	DAYDREAM_WINDOW_BAD,  // Missed the target
+	DAYDREAM_WINDOW_HOLD, // Met it, without room for the level above
+	DAYDREAM_WINDOW_GOOD, // Met it with room to spare
+};
+
+enum daydream_level_change {
+	DAYDREAM_LEVEL_KEPT,
+	DAYDREAM_LEVEL_LOWERED,   // Bad window
+	DAYDREAM_LEVEL_RAISED,    // Enough good windows
+	DAYDREAM_LEVEL_BACKED_OFF // The level just raised to was bad at once
+};
+
+struct daydream_level_step {
+	// Set when this window was the first after a change, whose result the caller reports
+	bool reported;
+	int reported_from;
+	int reported_to;
+
+	enum daydream_level_change change; // Made in this window, from changed_from to the current level
+	int changed_from;
+};
+
+void daydream_hysteresis_init(struct daydream_hysteresis *h, int recover_windows, int recover_windows_max);
+
+// Back to level 0 with no change pending
+void daydream_hysteresis_reset(struct daydream_hysteresis *h);
+
+// Judge one completed window. lower and higher are the neighbouring levels in each direction (lower cost
+// first), or the current level where there is none.
+struct daydream_level_step daydream_hysteresis_update(struct daydream_hysteresis *h,
+						      enum daydream_window_verdict verdict, int lower, int higher);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,250 @@
+#include "daydream-interp.h"
+#include <obs-module.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define INTERP_USE_SSE2
+#elif defined(__ARM_NEON) || defined(__aarch64__) || defined(_M_ARM64)
+#include <arm_neon.h>
+#define INTERP_USE_NEON
+#endif
+
+// Motion search runs on 2x downscaled luma: 8x8 blocks there cover 16x16
+// source pixels, and the +/-8 search window covers +/-16 source pixels.
+#define BLOCK_SIZE 8
+#define SEARCH_RANGE 8
+#define MOTION_LAMBDA 4 // SAD penalty per pixel of vector length, favors smooth fields
+
+struct daydream_interp {
+	uint32_t width; // Source (full resolution) size
+	uint32_t height;
+
+	// Downscaled luma, current and reference
+	uint8_t *luma[2];
+	uint32_t luma_width;
+	uint32_t luma_height;
+	int cur_idx;
+	bool has_reference;
+
+	// Per-block vectors in downscaled pixels, then the normalized output field
+	int8_t *vectors;
+	float *field;
+	uint32_t cols;
+	uint32_t rows;
+};
+
+static uint32_t sad_8x8(const uint8_t *a, uint32_t a_stride, const uint8_t *b, uint32_t b_stride)
+{
+#if defined(INTERP_USE_SSE2)
+	__m128i acc = _mm_setzero_si128();
+	for (int y = 0; y < BLOCK_SIZE; y += 2) {
+		__m128i ra = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)a),
+						_mm_loadl_epi64((const __m128i *)(a + a_stride)));
+		__m128i rb = _mm_unpacklo_epi64(_mm_loadl_epi64((const __m128i *)b),
+						_mm_loadl_epi64((const __m128i *)(b + b_stride)));
+		acc = _mm_add_epi64(acc, _mm_sad_epu8(ra, rb));
+		a += a_stride * 2;
+		b += b_stride * 2;
+	}
+	return (uint32_t)(_mm_cvtsi128_si32(acc) + _mm_extract_epi16(acc, 4));
+#elif defined(INTERP_USE_NEON)
+	uint16x8_t acc = vabdl_u8(vld1_u8(a), vld1_u8(b));
+	for (int y = 1; y < BLOCK_SIZE; y++) {
+		a += a_stride;
+		b += b_stride;
+		acc = vabal_u8(acc, vld1_u8(a), vld1_u8(b));
+	}
+	uint32x4_t sum4 = vpaddlq_u16(acc);
+	uint64x2_t sum2 = vpaddlq_u32(sum4);
+	return (uint32_t)(vgetq_lane_u64(sum2, 0) + vgetq_lane_u64(sum2, 1));
+#else
+	uint32_t sum = 0;
+	for (int y = 0; y < BLOCK_SIZE; y++) {
+		for (int x = 0; x < BLOCK_SIZE; x++)
+			sum += (uint32_t)abs((int)a[x] - (int)b[x]);
+		a += a_stride;
+		b += b_stride;
+	}
+	return sum;
+#endif
+}
+
+static void downscale_luma(uint8_t *dst, uint32_t dst_width, uint32_t dst_height, const uint8_t *src,
+			   uint32_t src_linesize)
+{
+	for (uint32_t y = 0; y < dst_height; y++) {
+		const uint8_t *r0 = src + (size_t)(y * 2) * src_linesize;
+		const uint8_t *r1 = r0 + src_linesize;
+		uint8_t *out = dst + (size_t)y * dst_width;
+		for (uint32_t x = 0; x < dst_width; x++) {
+			uint32_t sum = r0[x * 2] + r0[x * 2 + 1] + r1[x * 2] + r1[x * 2 + 1];
+			out[x] = (uint8_t)((sum + 2) >> 2);
+		}
+	}
+}
+
+static int median5(int a, int b, int c, int d, int e)
+{
+	int v[5] = {a, b, c, d, e};
+	for (int i = 1; i < 5; i++) {
+		int key = v[i];
+		int j = i - 1;
+		while (j >= 0 && v[j] > key) {
+			v[j + 1] = v[j];
+			j--;
+		}
+		v[j + 1] = key;
+	}
+	return v[2];
+}
+
+static void estimate_motion(struct daydream_interp *interp)
+{
+	const uint8_t *cur = interp->luma[interp->cur_idx];
+	const uint8_t *ref = interp->luma[interp->cur_idx ^ 1];
+	const uint32_t stride = interp->luma_width;
+	const int max_x = (int)(interp->luma_width - BLOCK_SIZE);
+	const int max_y = (int)(interp->luma_height - BLOCK_SIZE);
+
+	for (uint32_t by = 0; by < interp->rows; by++) {
+		for (uint32_t bx = 0; bx < interp->cols; bx++) {
+			const int x0 = (int)(bx * BLOCK_SIZE);
+			const int y0 = (int)(by * BLOCK_SIZE);
+			const uint8_t *block = cur + (size_t)y0 * stride + x0;
+
+			int best_dx = 0;
+			int best_dy = 0;
+			uint32_t best_cost = sad_8x8(block, stride, ref + (size_t)y0 * stride + x0, stride);
+
+			// Static blocks are common (background); skip the search when already near-perfect
+			if (best_cost > BLOCK_SIZE * BLOCK_SIZE) {
+				int y_lo = y0 - SEARCH_RANGE < 0 ? -y0 : -SEARCH_RANGE;
+				int y_hi = y0 + SEARCH_RANGE > max_y ? max_y - y0 : SEARCH_RANGE;
+				int x_lo = x0 - SEARCH_RANGE < 0 ? -x0 : -SEARCH_RANGE;
+				int x_hi = x0 + SEARCH_RANGE > max_x ? max_x - x0 : SEARCH_RANGE;
+
+				for (int dy = y_lo; dy <= y_hi; dy++) {
+					const uint8_t *ref_row = ref + (size_t)(y0 + dy) * stride + x0;
+					for (int dx = x_lo; dx <= x_hi; dx++) {
+						uint32_t penalty = MOTION_LAMBDA * (uint32_t)(abs(dx) + abs(dy));
+						if (penalty >= best_cost)
+							continue;
+						uint32_t cost = sad_8x8(block, stride, ref_row + dx, stride) + penalty;
+						if (cost < best_cost) {
+							best_cost = cost;
+							best_dx = dx;
+							best_dy = dy;
+						}
+					}
+				}
+			}
+
+			int8_t *v = &interp->vectors[(by * interp->cols + bx) * 2];
+			v[0] = (int8_t)best_dx;
+			v[1] = (int8_t)best_dy;
+		}
+	}
+
+	// Component-wise median over the block and its 4 neighbours removes isolated outliers
+	const float scale_x = 2.0f / (float)interp->width;
+	const float scale_y = 2.0f / (float)interp->height;
+	const int cols = (int)interp->cols;
+	const int rows = (int)interp->rows;
+
+	for (int by = 0; by < rows; by++) {
+		for (int bx = 0; bx < cols; bx++) {
+			const int8_t *c = &interp->vectors[(by * cols + bx) * 2];
+			const int8_t *l = &interp->vectors[(by * cols + (bx > 0 ? bx - 1 : bx)) * 2];
+			const int8_t *r = &interp->vectors[(by * cols + (bx < cols - 1 ? bx + 1 : bx)) * 2];
+			const int8_t *u = &interp->vectors[((by > 0 ? by - 1 : by) * cols + bx) * 2];
+			const int8_t *d = &interp->vectors[((by < rows - 1 ? by + 1 : by) * cols + bx) * 2];
+
+			float *out = &interp->field[(by * cols + bx) * 2];
+			out[0] = (float)median5(c[0], l[0], r[0], u[0], d[0]) * scale_x;
+			out[1] = (float)median5(c[1], l[1], r[1], u[1], d[1]) * scale_y;
+		}
+	}
+}
+
+struct daydream_interp *daydream_interp_create(void)
+{
+	return bzalloc(sizeof(struct daydream_interp));
+}
+
+static void free_buffers(struct daydream_interp *interp)
+{
+	bfree(interp->luma[0]);
+	bfree(interp->luma[1]);
+	bfree(interp->vectors);
+	bfree(interp->field);
+	interp->luma[0] = NULL;
+	interp->luma[1] = NULL;
+	interp->vectors = NULL;
+	interp->field = NULL;
+}
+
+void daydream_interp_destroy(struct daydream_interp *interp)
+{
+	if (!interp)
+		return;
+
+	free_buffers(interp);
+	bfree(interp);
+}
+
+void daydream_interp_reset(struct daydream_interp *interp)
+{
+	if (interp)
+		interp->has_reference = false;
+}
+
+bool daydream_interp_push_frame(struct daydream_interp *interp, const uint8_t *y_data, uint32_t y_linesize,
+				uint32_t width, uint32_t height)
+{
+	if (!interp || !y_data || width < BLOCK_SIZE * 2 || height < BLOCK_SIZE * 2)
+		return false;
+
+	if (interp->width != width || interp->height != height || !interp->luma[0]) {
+		free_buffers(interp);
+
+		interp->width = width;
+		interp->height = height;
+		interp->luma_width = width / 2;
+		interp->luma_height = height / 2;
+		interp->cols = interp->luma_width / BLOCK_SIZE;
+		interp->rows = interp->luma_height / BLOCK_SIZE;
+
+		size_t luma_size = (size_t)interp->luma_width * interp->luma_height;
+		interp->luma[0] = bmalloc(luma_size);
+		interp->luma[1] = bmalloc(luma_size);
+		interp->vectors = bzalloc((size_t)interp->cols * interp->rows * 2);
+		interp->field = bzalloc((size_t)interp->cols * interp->rows * 2 * sizeof(float));
+		interp->cur_idx = 0;
+		interp->has_reference = false;
+	}
+
+	interp->cur_idx ^= 1;
+	downscale_luma(interp->luma[interp->cur_idx], interp->luma_width, interp->luma_height, y_data, y_linesize);
+
+	if (!interp->has_reference) {
+		interp->has_reference = true;
+		return false;
+	}
+
+	estimate_motion(interp);
+	return true;
+}
+
+const float *daydream_interp_get_field(const struct daydream_interp *interp, uint32_t *cols, uint32_t *rows)
+{
+	if (!interp || !interp->field)
+		return NULL;
+
+	if (cols)
+		*cols = interp->cols;
+	if (rows)
+		*rows = interp->rows;
+	return interp->field;
+}
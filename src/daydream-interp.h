@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct daydream_interp;
+
+struct daydream_interp *daydream_interp_create(void);
+void daydream_interp_destroy(struct daydream_interp *interp);
+
+// Drop the reference frame, e.g. after a stream restart
+void daydream_interp_reset(struct daydream_interp *interp);
+
+// Estimate block motion from the previously pushed luma plane to this one.
+// Returns false when there is no usable reference (first frame, size change).
+bool daydream_interp_push_frame(struct daydream_interp *interp, const uint8_t *y_data, uint32_t y_linesize,
+				uint32_t width, uint32_t height);
+
+// Motion field from the last successful push: cols x rows pairs of (dx, dy)
+// in normalized texture coordinates, pointing from the current frame into the
+// previous one. Suitable for upload as a GS_RG32F texture.
+const float *daydream_interp_get_field(const struct daydream_interp *interp, uint32_t *cols, uint32_t *rows);
+
+#ifdef __cplusplus
+}
+#endif
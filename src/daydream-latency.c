@@ -0,0 +1,155 @@
+#include "daydream-latency.h"
+#include <obs-module.h>
+#include <util/threading.h>
+#include <string.h>
+
+// ~8.5 s of history at 30 fps, comfortably above the worst observed round trip
+#define LATENCY_RING_SIZE 256
+
+// EWMA weight per matched frame; ~1 s time constant at 30 fps
+#define LATENCY_ALPHA 0.03
+
+// Samples further than this from the estimate are clamped, so a single stall
+// does not yank the average
+#define LATENCY_OUTLIER_NS (500 * 1000000LL)
+
+struct latency_entry {
+	uint32_t rtp_timestamp;
+	uint64_t capture_ns;
+	bool used;
+};
+
+struct daydream_latency {
+	pthread_mutex_t mutex;
+
+	struct latency_entry ring[LATENCY_RING_SIZE];
+	size_t write_pos;
+
+	double smoothed_ns;
+	uint64_t samples;
+};
+
+struct daydream_latency *daydream_latency_create(void)
+{
+	struct daydream_latency *latency = bzalloc(sizeof(struct daydream_latency));
+	pthread_mutex_init(&latency->mutex, NULL);
+	return latency;
+}
+
+void daydream_latency_destroy(struct daydream_latency *latency)
+{
+	if (!latency)
+		return;
+
+	pthread_mutex_destroy(&latency->mutex);
+	bfree(latency);
+}
+
+void daydream_latency_reset(struct daydream_latency *latency)
+{
+	if (!latency)
+		return;
+
+	pthread_mutex_lock(&latency->mutex);
+	memset(latency->ring, 0, sizeof(latency->ring));
+	latency->write_pos = 0;
+	latency->smoothed_ns = 0.0;
+	latency->samples = 0;
+	pthread_mutex_unlock(&latency->mutex);
+}
+
+void daydream_latency_mark_sent(struct daydream_latency *latency, uint32_t rtp_timestamp, uint64_t capture_ns)
+{
+	if (!latency)
+		return;
+
+	pthread_mutex_lock(&latency->mutex);
+	struct latency_entry *entry = &latency->ring[latency->write_pos];
+	entry->rtp_timestamp = rtp_timestamp;
+	entry->capture_ns = capture_ns;
+	entry->used = true;
+	latency->write_pos = (latency->write_pos + 1) % LATENCY_RING_SIZE;
+	pthread_mutex_unlock(&latency->mutex);
+}
+
+// Caller holds the mutex. Searches newest first, since returned frames are recent.
+static const struct latency_entry *find_entry(struct daydream_latency *latency, uint32_t rtp_timestamp)
+{
+	for (size_t i = 1; i <= LATENCY_RING_SIZE; i++) {
+		size_t pos = (latency->write_pos + LATENCY_RING_SIZE - i) % LATENCY_RING_SIZE;
+		const struct latency_entry *entry = &latency->ring[pos];
+		if (!entry->used)
+			break;
+		if (entry->rtp_timestamp == rtp_timestamp)
+			return entry;
+	}
+	return NULL;
+}
+
+bool daydream_latency_get_capture_time(struct daydream_latency *latency, uint32_t rtp_timestamp,
+				       uint64_t *capture_ns)
+{
+	if (!latency)
+		return false;
+
+	pthread_mutex_lock(&latency->mutex);
+	const struct latency_entry *entry = find_entry(latency, rtp_timestamp);
+	if (entry && capture_ns)
+		*capture_ns = entry->capture_ns;
+	pthread_mutex_unlock(&latency->mutex);
+
+	return entry != NULL;
+}
+
+bool daydream_latency_mark_displayed(struct daydream_latency *latency, uint32_t rtp_timestamp, uint64_t display_ns)
+{
+	if (!latency)
+		return false;
+
+	pthread_mutex_lock(&latency->mutex);
+
+	const struct latency_entry *entry = find_entry(latency, rtp_timestamp);
+	if (!entry || display_ns < entry->capture_ns) {
+		pthread_mutex_unlock(&latency->mutex);
+		return false;
+	}
+
+	double sample = (double)(display_ns - entry->capture_ns);
+	if (latency->samples == 0) {
+		latency->smoothed_ns = sample;
+	} else {
+		double lo = latency->smoothed_ns - (double)LATENCY_OUTLIER_NS;
+		double hi = latency->smoothed_ns + (double)LATENCY_OUTLIER_NS;
+		if (sample < lo)
+			sample = lo;
+		if (sample > hi)
+			sample = hi;
+		latency->smoothed_ns += LATENCY_ALPHA * (sample - latency->smoothed_ns);
+	}
+	latency->samples++;
+
+	pthread_mutex_unlock(&latency->mutex);
+	return true;
+}
+
+uint64_t daydream_latency_get_ns(struct daydream_latency *latency)
+{
+	if (!latency)
+		return 0;
+
+	pthread_mutex_lock(&latency->mutex);
+	uint64_t value = latency->smoothed_ns > 0.0 ? (uint64_t)latency->smoothed_ns : 0;
+	pthread_mutex_unlock(&latency->mutex);
+	return value;
+}
+
+uint64_t daydream_latency_get_samples(struct daydream_latency *latency)
+{
+	if (!latency)
+		return 0;
+
+	pthread_mutex_lock(&latency->mutex);
+	uint64_t samples = latency->samples;
+	pthread_mutex_unlock(&latency->mutex);
+	return samples;
+}
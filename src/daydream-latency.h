@@ -0,0 +1,40 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Capture->display latency tracker. Outgoing frames are remembered by their
+// RTP timestamp; frames coming back over WHEP carry the same timestamp, which
+// is matched to produce a smoothed latency estimate. Thread-safe.
+struct daydream_latency;
+
+struct daydream_latency *daydream_latency_create(void);
+void daydream_latency_destroy(struct daydream_latency *latency);
+
+void daydream_latency_reset(struct daydream_latency *latency);
+
+// Record that the frame sent with rtp_timestamp was captured at capture_ns
+void daydream_latency_mark_sent(struct daydream_latency *latency, uint32_t rtp_timestamp, uint64_t capture_ns);
+
+// Look up the capture time of a sent frame. Returns false if it has aged out.
+bool daydream_latency_get_capture_time(struct daydream_latency *latency, uint32_t rtp_timestamp,
+				       uint64_t *capture_ns);
+
+// Match a returned frame and fold its latency into the estimate.
+// Returns false if the timestamp is unknown.
+bool daydream_latency_mark_displayed(struct daydream_latency *latency, uint32_t rtp_timestamp, uint64_t display_ns);
+
+// Smoothed latency in nanoseconds, or 0 before the first match
+uint64_t daydream_latency_get_ns(struct daydream_latency *latency);
+
+// Number of matched frames since the last reset
+uint64_t daydream_latency_get_samples(struct daydream_latency *latency);
+
+#ifdef __cplusplus
+}
+#endif
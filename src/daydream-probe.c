@@ -0,0 +1,268 @@
+#include "daydream-probe.h"
+#include <obs-module.h>
+#include <util/threading.h>
+#include <util/platform.h>
+#include <util/dstr.h>
+#include <curl/curl.h>
+#include <string.h>
+
+// A faster endpoint has to beat the current one by this much before it is reported, so
+// jitter between similar nodes does not cause churn
+#define PROBE_SWITCH_MARGIN 0.8
+
+static char *probe_ca_pem;
+
+void daydream_probe_set_ca_pem(const char *pem)
+{
+	bfree(probe_ca_pem);
+	probe_ca_pem = pem ? bstrdup(pem) : NULL;
+}
+
+int daydream_probe_run(const char *const *urls, size_t count, uint32_t timeout_ms, int64_t *rtt_us)
+{
+	if (!urls || count == 0 || !rtt_us)
+		return -1;
+
+	for (size_t i = 0; i < count; i++)
+		rtt_us[i] = -1;
+
+	CURLM *multi = curl_multi_init();
+	if (!multi)
+		return -1;
+
+	CURL **handles = bzalloc(count * sizeof(CURL *));
+	for (size_t i = 0; i < count; i++) {
+		if (!urls[i] || !*urls[i])
+			continue;
+
+		CURL *curl = curl_easy_init();
+		if (!curl)
+			continue;
+
+		// Connect and handshake only; no request is sent and the connection is not kept
+		curl_easy_setopt(curl, CURLOPT_URL, urls[i]);
+		curl_easy_setopt(curl, CURLOPT_CONNECT_ONLY, 1L);
+		curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, 1L);
+		curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, 1L);
+		curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)timeout_ms);
+		curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+		if (probe_ca_pem) {
+			struct curl_blob blob = {probe_ca_pem, strlen(probe_ca_pem), CURL_BLOB_COPY};
+			curl_easy_setopt(curl, CURLOPT_CAINFO_BLOB, &blob);
+		}
+
+		curl_multi_add_handle(multi, curl);
+		handles[i] = curl;
+	}
+
+	int running = 0;
+	do {
+		if (curl_multi_perform(multi, &running) != CURLM_OK)
+			break;
+		if (running)
+			curl_multi_poll(multi, NULL, 0, 100, NULL);
+	} while (running);
+
+	CURLMsg *msg;
+	int msgs_left = 0;
+	while ((msg = curl_multi_info_read(multi, &msgs_left))) {
+		if (msg->msg != CURLMSG_DONE || msg->data.result != CURLE_OK)
+			continue;
+
+		for (size_t i = 0; i < count; i++) {
+			if (handles[i] != msg->easy_handle)
+				continue;
+
+			curl_off_t lookup = 0;
+			curl_off_t connect = 0;
+			curl_off_t appconnect = 0;
+			curl_easy_getinfo(handles[i], CURLINFO_NAMELOOKUP_TIME_T, &lookup);
+			curl_easy_getinfo(handles[i], CURLINFO_CONNECT_TIME_T, &connect);
+			curl_easy_getinfo(handles[i], CURLINFO_APPCONNECT_TIME_T, &appconnect);
+
+			// Plain http:// endpoints have no TLS stage
+			curl_off_t done = appconnect > 0 ? appconnect : connect;
+			rtt_us[i] = (int64_t)(done - lookup);
+			break;
+		}
+	}
+
+	int best = -1;
+	for (size_t i = 0; i < count; i++) {
+		if (handles[i]) {
+			curl_multi_remove_handle(multi, handles[i]);
+			curl_easy_cleanup(handles[i]);
+		}
+		if (rtt_us[i] >= 0 && (best < 0 || rtt_us[i] < rtt_us[best]))
+			best = (int)i;
+	}
+
+	bfree(handles);
+	curl_multi_cleanup(multi);
+	return best;
+}
+
+char *daydream_probe_rebase_url(const char *url, const char *origin)
+{
+	if (!url || !origin || !*origin)
+		return NULL;
+
+	const char *scheme_end = strstr(url, "://");
+	if (!scheme_end)
+		return NULL;
+
+	const char *path = strchr(scheme_end + 3, '/');
+	if (!path)
+		path = "";
+
+	// Accept "host" as shorthand for "https://host", and ignore a trailing slash
+	size_t origin_len = strlen(origin);
+	while (origin_len > 0 && origin[origin_len - 1] == '/')
+		origin_len--;
+	const char *prefix = strstr(origin, "://") ? "" : "https://";
+
+	size_t len = strlen(prefix) + origin_len + strlen(path) + 1;
+	char *rebased = bmalloc(len);
+	snprintf(rebased, len, "%s%.*s%s", prefix, (int)origin_len, origin, path);
+	return rebased;
+}
+
+int daydream_probe_select(const char *url, const char *hosts, uint32_t timeout_ms, char **urls, int64_t *rtt_us,
+			  size_t max, size_t *count)
+{
+	*count = 0;
+	if (!url || max == 0)
+		return -1;
+
+	urls[(*count)++] = bstrdup(url);
+
+	char **origins = hosts ? strlist_split(hosts, ',', false) : NULL;
+	for (char **origin = origins; origin && *origin && *count < max; origin++) {
+		struct dstr trimmed = {0};
+		dstr_copy(&trimmed, *origin);
+		dstr_depad(&trimmed);
+		char *rebased = daydream_probe_rebase_url(url, trimmed.array);
+		dstr_free(&trimmed);
+		if (rebased)
+			urls[(*count)++] = rebased;
+	}
+	strlist_free(origins);
+
+	int best = daydream_probe_run((const char *const *)urls, *count, timeout_ms, rtt_us);
+	return best >= 0 ? best : 0;
+}
+
+struct daydream_prober {
+	char **urls;
+	size_t count;
+	uint32_t interval_ms;
+
+	pthread_t thread;
+	os_event_t *stop_event;
+
+	pthread_mutex_t mutex;
+	int64_t *rtt_us;
+	int best;
+};
+
+static void *prober_thread_func(void *data)
+{
+	struct daydream_prober *prober = data;
+	int64_t *rtt_us = bzalloc(prober->count * sizeof(int64_t));
+
+	os_set_thread_name("daydream-probe");
+
+	// The session starts on an endpoint that was just probed, so the first round waits a full interval
+	while (os_event_timedwait(prober->stop_event, prober->interval_ms) != 0) {
+		int best = daydream_probe_run((const char *const *)prober->urls, prober->count, 2000, rtt_us);
+
+		pthread_mutex_lock(&prober->mutex);
+		int current = prober->best;
+		if (best >= 0 && best != current) {
+			// Stay with the current endpoint unless the new one is clearly faster
+			bool current_alive = current >= 0 && rtt_us[current] >= 0;
+			if (!current_alive || (double)rtt_us[best] < (double)rtt_us[current] * PROBE_SWITCH_MARGIN) {
+				blog(LOG_INFO, "[Daydream Probe] Fastest endpoint now %s (%.1f ms)", prober->urls[best],
+				     (double)rtt_us[best] / 1000.0);
+				prober->best = best;
+			}
+		}
+		memcpy(prober->rtt_us, rtt_us, prober->count * sizeof(int64_t));
+		pthread_mutex_unlock(&prober->mutex);
+	}
+
+	bfree(rtt_us);
+	return NULL;
+}
+
+struct daydream_prober *daydream_prober_create(const char *const *urls, size_t count, int current,
+					       uint32_t interval_ms)
+{
+	if (!urls || count == 0)
+		return NULL;
+
+	struct daydream_prober *prober = bzalloc(sizeof(struct daydream_prober));
+	prober->count = count;
+	prober->interval_ms = interval_ms > 0 ? interval_ms : 60000;
+	prober->best = current >= 0 && (size_t)current < count ? current : -1;
+	prober->urls = bzalloc(count * sizeof(char *));
+	prober->rtt_us = bzalloc(count * sizeof(int64_t));
+	for (size_t i = 0; i < count; i++) {
+		prober->urls[i] = bstrdup(urls[i]);
+		prober->rtt_us[i] = -1;
+	}
+
+	pthread_mutex_init(&prober->mutex, NULL);
+	if (os_event_init(&prober->stop_event, OS_EVENT_TYPE_MANUAL) != 0 ||
+	    pthread_create(&prober->thread, NULL, prober_thread_func, prober) != 0) {
+		blog(LOG_WARNING, "[Daydream Probe] Failed to start background prober");
+		if (prober->stop_event)
+			os_event_destroy(prober->stop_event);
+		pthread_mutex_destroy(&prober->mutex);
+		for (size_t i = 0; i < count; i++)
+			bfree(prober->urls[i]);
+		bfree(prober->urls);
+		bfree(prober->rtt_us);
+		bfree(prober);
+		return NULL;
+	}
+
+	return prober;
+}
+
+void daydream_prober_destroy(struct daydream_prober *prober)
+{
+	if (!prober)
+		return;
+
+	os_event_signal(prober->stop_event);
+	pthread_join(prober->thread, NULL);
+	os_event_destroy(prober->stop_event);
+	pthread_mutex_destroy(&prober->mutex);
+
+	for (size_t i = 0; i < prober->count; i++)
+		bfree(prober->urls[i]);
+	bfree(prober->urls);
+	bfree(prober->rtt_us);
+	bfree(prober);
+}
+
+int daydream_prober_get_fastest(struct daydream_prober *prober, int64_t *rtt_us)
+{
+	if (!prober)
+		return -1;
+
+	pthread_mutex_lock(&prober->mutex);
+	int best = prober->best;
+	if (best >= 0 && rtt_us)
+		*rtt_us = prober->rtt_us[best];
+	pthread_mutex_unlock(&prober->mutex);
+	return best;
+}
+
+const char *daydream_prober_get_url(struct daydream_prober *prober, int index)
+{
+	if (!prober || index < 0 || (size_t)index >= prober->count)
+		return NULL;
+	return prober->urls[index];
+}
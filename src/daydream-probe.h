@@ -0,0 +1,50 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Measure the HTTPS handshake time (TCP + TLS, DNS excluded) to each URL in
+// parallel. rtt_us[i] is set to -1 for endpoints that failed or timed out.
+// Returns the index of the fastest endpoint, or -1 if none answered.
+int daydream_probe_run(const char *const *urls, size_t count, uint32_t timeout_ms, int64_t *rtt_us);
+
+// Probe url together with copies of it moved onto each comma-separated origin
+// in hosts, url first and at most max endpoints in all. urls receives new
+// strings to bfree and rtt_us their handshake times, and *count how many there
+// are. Returns the index of the fastest, or 0 if none answered, so the caller
+// keeps the URL it was given and lets the connection report the error.
+int daydream_probe_select(const char *url, const char *hosts, uint32_t timeout_ms, char **urls, int64_t *rtt_us,
+			  size_t max, size_t *count);
+
+// Verify endpoints against the PEM certificates in pem instead of the system
+// store, for local stand-ins with self-signed certificates. NULL restores the
+// default. Set it before probing starts.
+void daydream_probe_set_ca_pem(const char *pem);
+
+// Replace the scheme and host of url with origin ("https://host[:port]"),
+// keeping the path and query. Returns a new string to bfree, or NULL.
+char *daydream_probe_rebase_url(const char *url, const char *origin);
+
+// Re-probes a fixed set of endpoints on a background thread for the length
+// of a session. current is the index of the endpoint in use.
+struct daydream_prober;
+
+struct daydream_prober *daydream_prober_create(const char *const *urls, size_t count, int current,
+					       uint32_t interval_ms);
+void daydream_prober_destroy(struct daydream_prober *prober);
+
+// Fastest endpoint so far, or -1 if none is known. rtt_us is -1 until the
+// first background round completes.
+int daydream_prober_get_fastest(struct daydream_prober *prober, int64_t *rtt_us);
+
+// URL of an endpoint passed to daydream_prober_create
+const char *daydream_prober_get_url(struct daydream_prober *prober, int index);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,74 @@
+#include "daydream-rate-control.h"
+#include "daydream-bitrate.h"
+#include <obs-module.h>
+
+#define STARTUP_NS (3000 * 1000000ULL)
+#define STARTUP_INCREASE 1.25
+#define STEADY_INCREASE 1.05
+#define LOSS_LOW 0.02
+#define LOSS_HIGH 0.10
+#define SETTLED_ALPHA 0.1
+#define SETTLED_MIN_UPDATES 10 // ~10 s of feedback after startup
+
+struct daydream_rate_controller {
+	double rate;
+	double settled;
+	uint64_t settled_updates;
+	uint64_t start_ns;
+	bool startup;
+};
+
+struct daydream_rate_controller *daydream_rate_controller_create(uint32_t start_bitrate)
+{
+	struct daydream_rate_controller *ctl = bzalloc(sizeof(struct daydream_rate_controller));
+	ctl->rate = start_bitrate;
+	ctl->startup = true;
+	return ctl;
+}
+
+void daydream_rate_controller_destroy(struct daydream_rate_controller *ctl)
+{
+	bfree(ctl);
+}
+
+uint32_t daydream_rate_controller_update(struct daydream_rate_controller *ctl, double loss_fraction,
+					 uint32_t remb_bitrate, uint64_t now_ns)
+{
+	if (ctl->start_ns == 0)
+		ctl->start_ns = now_ns;
+	if (ctl->startup && now_ns - ctl->start_ns >= STARTUP_NS)
+		ctl->startup = false;
+
+	if (loss_fraction >= 0.0) {
+		if (loss_fraction > LOSS_HIGH) {
+			ctl->rate *= 1.0 - 0.5 * loss_fraction;
+			ctl->startup = false;
+		} else if (loss_fraction < LOSS_LOW) {
+			ctl->rate *= ctl->startup ? STARTUP_INCREASE : STEADY_INCREASE;
+		}
+	}
+
+	if (remb_bitrate > 0 && ctl->rate > remb_bitrate)
+		ctl->rate = remb_bitrate;
+	if (ctl->rate < DAYDREAM_BITRATE_MIN)
+		ctl->rate = DAYDREAM_BITRATE_MIN;
+	if (ctl->rate > DAYDREAM_BITRATE_MAX)
+		ctl->rate = DAYDREAM_BITRATE_MAX;
+
+	if (!ctl->startup && loss_fraction >= 0.0 && loss_fraction <= LOSS_HIGH) {
+		if (ctl->settled_updates == 0)
+			ctl->settled = ctl->rate;
+		else
+			ctl->settled += (ctl->rate - ctl->settled) * SETTLED_ALPHA;
+		ctl->settled_updates++;
+	}
+
+	return (uint32_t)ctl->rate;
+}
+
+uint32_t daydream_rate_controller_get_settled(struct daydream_rate_controller *ctl)
+{
+	if (!ctl || ctl->settled_updates < SETTLED_MIN_UPDATES)
+		return 0;
+	return (uint32_t)ctl->settled;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Loss-based send rate controller, fed with the gateway's RTCP feedback about once a second.
+// Starts with a short fast-increase phase that ends after 3 s or at the first report above 10% loss,
+// so a session that started low finds the available rate in a few seconds. Kept apart from the bitrate
+// history, which needs the plugin's config folder, so the headless tools can drive it too. Not thread-safe.
+struct daydream_rate_controller;
+
+struct daydream_rate_controller *daydream_rate_controller_create(uint32_t start_bitrate);
+void daydream_rate_controller_destroy(struct daydream_rate_controller *ctl);
+
+// loss_fraction is negative when no new receiver report arrived; remb_bitrate is 0 without REMB.
+// Returns the new target bitrate.
+uint32_t daydream_rate_controller_update(struct daydream_rate_controller *ctl, double loss_fraction,
+					 uint32_t remb_bitrate, uint64_t now_ns);
+
+// Average rate over updates after the startup phase with at most 10% loss, or 0 if the session was
+// too short
+uint32_t daydream_rate_controller_get_settled(struct daydream_rate_controller *ctl);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,383 @@
+#include "daydream-recorder.h"
+#include <obs-module.h>
+#include <libavformat/avformat.h>
+#include <libavutil/opt.h>
+#include <string.h>
+
+#define RTP_CLOCK_RATE 90000
+
+struct daydream_recorder {
+	char *path;
+	uint32_t width;
+	uint32_t height;
+	enum daydream_video_codec codec;
+	bool is_mp4;
+
+	AVFormatContext *fmt_ctx;
+	AVStream *stream;
+	AVPacket *packet;
+	bool header_written;
+	bool failed;
+
+	// RTP timestamp unwrapping (32-bit 90 kHz clock -> 64-bit pts)
+	bool have_rtp_base;
+	uint32_t last_rtp;
+	int64_t ext_rtp;
+	int64_t last_pts;
+
+	uint64_t frames_written;
+	uint64_t frames_dropped;
+	uint64_t bytes_written;
+};
+
+// Find the next Annex B start code at or after pos. Returns the offset of the
+// first byte after the start code, or size if none; *sc_len receives its length.
+static size_t find_start_code(const uint8_t *data, size_t size, size_t pos, size_t *sc_len)
+{
+	for (size_t i = pos; i + 3 <= size; i++) {
+		if (data[i] == 0 && data[i + 1] == 0) {
+			if (data[i + 2] == 1) {
+				*sc_len = 3;
+				return i + 3;
+			}
+			if (i + 4 <= size && data[i + 2] == 0 && data[i + 3] == 1) {
+				*sc_len = 4;
+				return i + 4;
+			}
+		}
+	}
+	*sc_len = 0;
+	return size;
+}
+
+// Scan an access unit for SPS/PPS/IDR NAL units. When extradata is non-NULL the
+// parameter sets are copied into it (with 4-byte start codes).
+static bool scan_access_unit(const uint8_t *data, size_t size, bool *has_idr, uint8_t *extradata,
+			     size_t *extradata_size)
+{
+	bool has_sps = false;
+	bool has_pps = false;
+	size_t out = 0;
+	size_t sc_len;
+
+	*has_idr = false;
+
+	size_t nal_start = find_start_code(data, size, 0, &sc_len);
+	while (nal_start < size) {
+		size_t next = find_start_code(data, size, nal_start, &sc_len);
+		size_t nal_end = next < size ? next - sc_len : size;
+
+		// Trailing zero bytes belong to the next start code
+		while (nal_end > nal_start && data[nal_end - 1] == 0)
+			nal_end--;
+
+		if (nal_end > nal_start) {
+			uint8_t nal_type = data[nal_start] & 0x1F;
+			if (nal_type == 5)
+				*has_idr = true;
+
+			if (nal_type == 7 || nal_type == 8) {
+				if (nal_type == 7)
+					has_sps = true;
+				else
+					has_pps = true;
+
+				if (extradata) {
+					size_t nal_size = nal_end - nal_start;
+					static const uint8_t start_code[4] = {0, 0, 0, 1};
+					memcpy(extradata + out, start_code, 4);
+					memcpy(extradata + out + 4, data + nal_start, nal_size);
+					out += 4 + nal_size;
+				}
+			}
+		}
+
+		nal_start = next;
+	}
+
+	if (extradata_size)
+		*extradata_size = out;
+
+	return has_sps && has_pps;
+}
+
+// The frame tag's first bit is 0 on keyframes
+static bool vp8_is_keyframe(const uint8_t *data, size_t size)
+{
+	return size > 0 && (data[0] & 0x01) == 0;
+}
+
+// Uncompressed header: frame_marker (2), profile (2), a reserved bit in profile 3,
+// show_existing_frame (1), frame_type (1) with 0 for keyframes
+static bool vp9_is_keyframe(const uint8_t *data, size_t size)
+{
+	if (size == 0 || (data[0] >> 6) != 2)
+		return false;
+	int profile = ((data[0] >> 5) & 1) | (((data[0] >> 4) & 1) << 1);
+	int show_existing = profile == 3 ? 2 : 3;
+	if ((data[0] >> show_existing) & 1)
+		return false;
+	return ((data[0] >> (show_existing - 1)) & 1) == 0;
+}
+
+#define AV1_OBU_SEQUENCE_HEADER 1
+
+// Scan a temporal unit for a sequence header OBU, which encoders repeat on every keyframe, so its
+// presence is what marks a starting point. When extradata is non-NULL the OBU is copied into it.
+static bool scan_av1_temporal_unit(const uint8_t *data, size_t size, uint8_t *extradata, size_t *extradata_size)
+{
+	size_t pos = 0;
+	while (pos < size) {
+		uint8_t header = data[pos];
+		size_t payload = pos + 1 + ((header >> 2) & 1);
+		size_t end = size;
+		if (header & 0x02) {
+			uint64_t obu_size = 0;
+			for (int i = 0; i < 8; i++) {
+				if (payload >= size)
+					return false;
+				uint8_t byte = data[payload++];
+				obu_size |= (uint64_t)(byte & 0x7F) << (i * 7);
+				if (!(byte & 0x80))
+					break;
+			}
+			if (obu_size > size - payload)
+				return false;
+			end = payload + (size_t)obu_size;
+		}
+
+		if (((header >> 3) & 0x0F) == AV1_OBU_SEQUENCE_HEADER) {
+			if (extradata) {
+				memcpy(extradata, data + pos, end - pos);
+				*extradata_size = end - pos;
+			}
+			return true;
+		}
+		pos = end;
+	}
+	return false;
+}
+
+// Whether the frame is a keyframe the recording can start at. When extradata is non-NULL the
+// codec configuration carried in the frame is copied into it.
+static bool scan_frame(enum daydream_video_codec codec, const uint8_t *data, size_t size, bool *is_keyframe,
+		       uint8_t *extradata, size_t *extradata_size)
+{
+	if (extradata_size)
+		*extradata_size = 0;
+
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		*is_keyframe = vp8_is_keyframe(data, size);
+		return *is_keyframe;
+	case DAYDREAM_CODEC_VP9:
+		*is_keyframe = vp9_is_keyframe(data, size);
+		return *is_keyframe;
+	case DAYDREAM_CODEC_AV1:
+		*is_keyframe = scan_av1_temporal_unit(data, size, extradata, extradata_size);
+		return *is_keyframe;
+	default: {
+		bool has_params = scan_access_unit(data, size, is_keyframe, extradata, extradata_size);
+		return *is_keyframe && has_params;
+	}
+	}
+}
+
+static enum AVCodecID codec_id(enum daydream_video_codec codec)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		return AV_CODEC_ID_VP8;
+	case DAYDREAM_CODEC_VP9:
+		return AV_CODEC_ID_VP9;
+	case DAYDREAM_CODEC_AV1:
+		return AV_CODEC_ID_AV1;
+	default:
+		return AV_CODEC_ID_H264;
+	}
+}
+
+static bool open_output(struct daydream_recorder *recorder, const uint8_t *data, size_t size)
+{
+	const char *format_name = recorder->is_mp4 ? "mp4" : "matroska";
+
+	if (recorder->is_mp4 && recorder->codec == DAYDREAM_CODEC_VP8) {
+		blog(LOG_ERROR, "[Daydream Recorder] VP8 cannot be stored in MP4, record to .mkv instead");
+		return false;
+	}
+
+	int ret = avformat_alloc_output_context2(&recorder->fmt_ctx, NULL, format_name, recorder->path);
+	if (ret < 0 || !recorder->fmt_ctx) {
+		blog(LOG_ERROR, "[Daydream Recorder] Failed to allocate %s output context", format_name);
+		return false;
+	}
+
+	recorder->stream = avformat_new_stream(recorder->fmt_ctx, NULL);
+	if (!recorder->stream) {
+		blog(LOG_ERROR, "[Daydream Recorder] Failed to create stream");
+		return false;
+	}
+
+	// SPS/PPS or sequence header extradata taken straight from the received bitstream
+	uint8_t *extradata = av_mallocz(size + AV_INPUT_BUFFER_PADDING_SIZE);
+	if (!extradata)
+		return false;
+
+	size_t extradata_size = 0;
+	bool is_keyframe;
+	scan_frame(recorder->codec, data, size, &is_keyframe, extradata, &extradata_size);
+
+	AVCodecParameters *par = recorder->stream->codecpar;
+	par->codec_type = AVMEDIA_TYPE_VIDEO;
+	par->codec_id = codec_id(recorder->codec);
+	par->width = (int)recorder->width;
+	par->height = (int)recorder->height;
+	par->extradata = extradata;
+	par->extradata_size = (int)extradata_size;
+
+	recorder->stream->time_base = (AVRational){1, RTP_CLOCK_RATE};
+
+	if (!(recorder->fmt_ctx->oformat->flags & AVFMT_NOFILE)) {
+		ret = avio_open(&recorder->fmt_ctx->pb, recorder->path, AVIO_FLAG_WRITE);
+		if (ret < 0) {
+			blog(LOG_ERROR, "[Daydream Recorder] Failed to open %s: %s", recorder->path, av_err2str(ret));
+			return false;
+		}
+	}
+
+	AVDictionary *opts = NULL;
+	if (recorder->is_mp4) {
+		// Fragmented MP4 stays playable if OBS exits without finalizing the file
+		av_dict_set(&opts, "movflags", "frag_keyframe+empty_moov+default_base_moof", 0);
+	}
+
+	ret = avformat_write_header(recorder->fmt_ctx, &opts);
+	av_dict_free(&opts);
+	if (ret < 0) {
+		blog(LOG_ERROR, "[Daydream Recorder] Failed to write header: %s", av_err2str(ret));
+		return false;
+	}
+
+	recorder->header_written = true;
+	blog(LOG_INFO, "[Daydream Recorder] Recording to %s (%s, %s, extradata %zu bytes)", recorder->path,
+	     format_name, daydream_video_codec_name(recorder->codec), extradata_size);
+	return true;
+}
+
+struct daydream_recorder *daydream_recorder_create(const struct daydream_recorder_config *config)
+{
+	if (!config || !config->path || !*config->path)
+		return NULL;
+
+	struct daydream_recorder *recorder = bzalloc(sizeof(struct daydream_recorder));
+	recorder->path = bstrdup(config->path);
+	recorder->width = config->width > 0 ? config->width : 512;
+	recorder->height = config->height > 0 ? config->height : 512;
+	recorder->codec = config->codec;
+
+	size_t len = strlen(recorder->path);
+	recorder->is_mp4 = len > 4 && (strcmp(recorder->path + len - 4, ".mp4") == 0 ||
+				       strcmp(recorder->path + len - 4, ".MP4") == 0);
+
+	recorder->packet = av_packet_alloc();
+	if (!recorder->packet) {
+		blog(LOG_ERROR, "[Daydream Recorder] Failed to allocate packet");
+		bfree(recorder->path);
+		bfree(recorder);
+		return NULL;
+	}
+
+	// The output file is opened lazily on the first keyframe, once the codec configuration is known
+	return recorder;
+}
+
+void daydream_recorder_destroy(struct daydream_recorder *recorder)
+{
+	if (!recorder)
+		return;
+
+	if (recorder->fmt_ctx) {
+		if (recorder->header_written)
+			av_write_trailer(recorder->fmt_ctx);
+		if (!(recorder->fmt_ctx->oformat->flags & AVFMT_NOFILE))
+			avio_closep(&recorder->fmt_ctx->pb);
+		avformat_free_context(recorder->fmt_ctx);
+	}
+
+	if (recorder->header_written) {
+		blog(LOG_INFO, "[Daydream Recorder] Closed %s: %llu frames, %llu KB, %llu dropped", recorder->path,
+		     (unsigned long long)recorder->frames_written, (unsigned long long)(recorder->bytes_written / 1024),
+		     (unsigned long long)recorder->frames_dropped);
+	}
+
+	if (recorder->packet)
+		av_packet_free(&recorder->packet);
+	bfree(recorder->path);
+	bfree(recorder);
+}
+
+bool daydream_recorder_write(struct daydream_recorder *recorder, const uint8_t *data, size_t size,
+			     uint32_t rtp_timestamp)
+{
+	if (!recorder || recorder->failed || !data || size == 0)
+		return false;
+
+	bool is_keyframe;
+	bool can_start = scan_frame(recorder->codec, data, size, &is_keyframe, NULL, NULL);
+
+	if (!recorder->header_written) {
+		// Wait for a decodable starting point
+		if (!can_start) {
+			recorder->frames_dropped++;
+			return false;
+		}
+
+		if (!open_output(recorder, data, size)) {
+			recorder->failed = true;
+			return false;
+		}
+	}
+
+	// Unwrap the 32-bit RTP clock; signed delta tolerates wraparound
+	if (!recorder->have_rtp_base) {
+		recorder->have_rtp_base = true;
+		recorder->last_rtp = rtp_timestamp;
+		recorder->ext_rtp = 0;
+		recorder->last_pts = -1;
+	} else {
+		recorder->ext_rtp += (int32_t)(rtp_timestamp - recorder->last_rtp);
+		recorder->last_rtp = rtp_timestamp;
+	}
+
+	int64_t pts = recorder->ext_rtp;
+	if (pts <= recorder->last_pts) {
+		// Containers require strictly increasing timestamps without B-frames
+		recorder->frames_dropped++;
+		return false;
+	}
+	recorder->last_pts = pts;
+
+	AVPacket *pkt = recorder->packet;
+	pkt->data = (uint8_t *)data;
+	pkt->size = (int)size;
+	pkt->stream_index = recorder->stream->index;
+	pkt->pts = av_rescale_q(pts, (AVRational){1, RTP_CLOCK_RATE}, recorder->stream->time_base);
+	pkt->dts = pkt->pts;
+	pkt->duration = 0;
+	pkt->flags = is_keyframe ? AV_PKT_FLAG_KEY : 0;
+
+	// Not reference counted: libavformat copies what it needs to keep
+	int ret = av_write_frame(recorder->fmt_ctx, pkt);
+	pkt->data = NULL;
+	pkt->size = 0;
+
+	if (ret < 0) {
+		blog(LOG_WARNING, "[Daydream Recorder] Failed to write frame: %s", av_err2str(ret));
+		recorder->frames_dropped++;
+		return false;
+	}
+
+	recorder->frames_written++;
+	recorder->bytes_written += size;
+	return true;
+}
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include "daydream-codec.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct daydream_recorder;
+
+struct daydream_recorder_config {
+	const char *path; // Output file; ".mp4" writes fragmented MP4, anything else Matroska
+	uint32_t width;   // Coded size reported in the container
+	uint32_t height;
+	enum daydream_video_codec codec; // VP8 needs Matroska
+};
+
+struct daydream_recorder *daydream_recorder_create(const struct daydream_recorder_config *config);
+void daydream_recorder_destroy(struct daydream_recorder *recorder);
+
+// Write one access unit as received from the network (no re-encode): Annex B for H.264,
+// a frame for VP8/VP9, a temporal unit for AV1. Frames before the first keyframe (carrying
+// SPS/PPS for H.264, a sequence header for AV1) are dropped, as are frames whose RTP
+// timestamp does not advance.
+bool daydream_recorder_write(struct daydream_recorder *recorder, const uint8_t *data, size_t size,
+			     uint32_t rtp_timestamp);
+
+#ifdef __cplusplus
+}
+#endif
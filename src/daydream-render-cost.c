@@ -0,0 +1,134 @@
+#include "daydream-render-cost.h"
+#include "daydream-hysteresis.h"
+#include <obs-module.h>
+
+// Short next to the output governor's: render cost shows up as dropped program frames within a second,
+// and a measured frame is available every few render ticks.
+#define WINDOW_NS 1000000000ULL
+#define HEADROOM 0.7           // Below this fraction of the budget counts as room for the level above
+#define RECOVER_WINDOWS 5      // Windows with headroom before trying the level above
+#define RECOVER_WINDOWS_MAX 40 // Backoff limit after failed attempts
+#define MAX_LEVEL (DAYDREAM_RENDER_LEVEL_COUNT - 1)
+
+struct daydream_render_cost {
+	struct daydream_hysteresis levels;
+
+	uint64_t window_start_ns;
+	uint64_t window_cost_ns;
+	uint64_t window_samples;
+	double last_ms;
+	double before_ms; // Measured in the window before the last change
+};
+
+static const char *level_names[DAYDREAM_RENDER_LEVEL_COUNT] = {
+	"full", "half blur", "no interpolation", "no upscale", "no blur", "half capture rate",
+};
+
+const char *daydream_render_level_name(int level)
+{
+	if (level < 0 || level >= DAYDREAM_RENDER_LEVEL_COUNT)
+		return "unknown";
+	return level_names[level];
+}
+
+struct daydream_render_cost *daydream_render_cost_create(void)
+{
+	struct daydream_render_cost *rc = bzalloc(sizeof(struct daydream_render_cost));
+	daydream_hysteresis_init(&rc->levels, RECOVER_WINDOWS, RECOVER_WINDOWS_MAX);
+	rc->last_ms = -1.0;
+	return rc;
+}
+
+void daydream_render_cost_destroy(struct daydream_render_cost *rc)
+{
+	bfree(rc);
+}
+
+static int next_level(int level, uint32_t useful_levels)
+{
+	for (int next = level + 1; next <= MAX_LEVEL; next++) {
+		if (useful_levels & (1u << next))
+			return next;
+	}
+	return level;
+}
+
+static int previous_level(int level, uint32_t useful_levels)
+{
+	for (int previous = level - 1; previous > 0; previous--) {
+		if (useful_levels & (1u << previous))
+			return previous;
+	}
+	return 0;
+}
+
+static const char *change_reasons[] = {
+	[DAYDREAM_LEVEL_LOWERED] = "Render passes over budget",
+	[DAYDREAM_LEVEL_RAISED] = "Render passes under budget",
+	[DAYDREAM_LEVEL_BACKED_OFF] = "Recovery went over budget",
+};
+
+int daydream_render_cost_update(struct daydream_render_cost *rc, uint64_t cost_ns, uint64_t budget_ns,
+				uint32_t useful_levels, uint64_t now_ns)
+{
+	struct daydream_hysteresis *levels = &rc->levels;
+
+	if (budget_ns == 0) {
+		if (levels->level != DAYDREAM_RENDER_FULL)
+			blog(LOG_INFO, "[Daydream Render] Budget removed, level %s -> %s", level_names[levels->level],
+			     level_names[DAYDREAM_RENDER_FULL]);
+		daydream_hysteresis_reset(levels);
+	}
+
+	if (rc->window_start_ns == 0)
+		rc->window_start_ns = now_ns;
+	rc->window_cost_ns += cost_ns;
+	rc->window_samples++;
+	if (now_ns - rc->window_start_ns < WINDOW_NS)
+		return levels->level;
+
+	double ms = (double)rc->window_cost_ns / (double)rc->window_samples / 1000000.0;
+	rc->last_ms = ms;
+	rc->window_start_ns = now_ns;
+	rc->window_cost_ns = 0;
+	rc->window_samples = 0;
+	if (budget_ns == 0)
+		return levels->level;
+
+	// The operator may have turned off what the current level saves
+	if (levels->level != DAYDREAM_RENDER_FULL && !(useful_levels & (1u << levels->level)))
+		levels->level = previous_level(levels->level, useful_levels);
+
+	// Just under budget is not enough to try the level above: it would go over
+	double budget_ms = (double)budget_ns / 1000000.0;
+	enum daydream_window_verdict verdict = DAYDREAM_WINDOW_GOOD;
+	if (ms > budget_ms)
+		verdict = DAYDREAM_WINDOW_BAD;
+	else if (ms >= budget_ms * HEADROOM)
+		verdict = DAYDREAM_WINDOW_HOLD;
+	struct daydream_level_step step =
+		daydream_hysteresis_update(levels, verdict, next_level(levels->level, useful_levels),
+					   previous_level(levels->level, useful_levels));
+
+	if (step.reported)
+		blog(LOG_INFO, "[Daydream Render] Level %s -> %s: %.2f -> %.2f ms", level_names[step.reported_from],
+		     level_names[step.reported_to], rc->before_ms, ms);
+
+	if (step.change != DAYDREAM_LEVEL_KEPT) {
+		blog(LOG_INFO, "[Daydream Render] %s at %.2f ms (budget %.2f), level %s -> %s",
+		     change_reasons[step.change], ms, budget_ms, level_names[step.changed_from],
+		     level_names[levels->level]);
+		rc->before_ms = ms;
+	}
+	return levels->level;
+}
+
+int daydream_render_cost_get_level(const struct daydream_render_cost *rc)
+{
+	return rc ? rc->levels.level : 0;
+}
+
+double daydream_render_cost_get_ms(const struct daydream_render_cost *rc)
+{
+	return rc ? rc->last_ms : -1.0;
+}
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Render cost governor. Fed the measured cost of the filter's own render passes, it drops optional passes
+// one level at a time while the average over a window is over budget, so the filter does not push OBS's
+// render thread into dropping program frames. Once there has been headroom for a while, it tries the level
+// above again and backs off longer if that goes over. Render thread only.
+struct daydream_render_cost;
+
+// Each level includes the ones before it
+enum daydream_render_level {
+	DAYDREAM_RENDER_FULL = 0,
+	DAYDREAM_RENDER_HALF_BLUR,  // Background blur downsampled to half the configured size
+	DAYDREAM_RENDER_NO_INTERP,  // Frame interpolation off
+	DAYDREAM_RENDER_NO_UPSCALE, // EASU/RCAS off, bilinear instead
+	DAYDREAM_RENDER_NO_BLUR,    // Background blur off
+	DAYDREAM_RENDER_DECIMATED,  // Every other frame captured and sent
+	DAYDREAM_RENDER_LEVEL_COUNT,
+};
+
+const char *daydream_render_level_name(int level);
+
+struct daydream_render_cost *daydream_render_cost_create(void);
+void daydream_render_cost_destroy(struct daydream_render_cost *rc);
+
+// Feed the cost of one measured frame. useful_levels has bit n set when level n would change anything with
+// the current settings; levels without it are skipped. A budget of 0 turns the governor off. Returns the
+// level to render at. Every change, and the cost seen after it, is logged.
+int daydream_render_cost_update(struct daydream_render_cost *rc, uint64_t cost_ns, uint64_t budget_ns,
+				uint32_t useful_levels, uint64_t now_ns);
+
+int daydream_render_cost_get_level(const struct daydream_render_cost *rc);
+
+// Mean cost per measured frame over the last completed window, negative until there is one
+double daydream_render_cost_get_ms(const struct daydream_render_cost *rc);
+
+#ifdef __cplusplus
+}
+#endif
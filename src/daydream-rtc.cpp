@@ -0,0 +1,61 @@
+#include "daydream-rtc.h"
+#include <obs-module.h>
+
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+// Each streaming filter has one WHIP and one WHEP connection, and WHEP decodes inside its callbacks.
+// Half the cores within these bounds, instead of libdatachannel's default of one thread per core.
+#define RTC_MIN_THREADS 2
+#define RTC_MAX_THREADS 4
+#define RTC_CLEANUP_TIMEOUT_S 2
+
+static std::thread warm_thread;
+
+rtc::Configuration daydream_rtc_config()
+{
+	rtc::Configuration config;
+	config.disableAutoNegotiation = true; // Manual negotiation for faster setup
+	config.certificateType = rtc::CertificateType::Ecdsa;
+	return config;
+}
+
+static void warm_up()
+{
+	auto start = std::chrono::steady_clock::now();
+	try {
+		rtc::Preload();
+
+		// libdatachannel generates the DTLS certificate when a peer connection is created and caches
+		// it per certificate type for the life of the process, so this one seeds it for all later
+		// connections
+		rtc::PeerConnection pc(daydream_rtc_config());
+		pc.close();
+	} catch (const std::exception &e) {
+		blog(LOG_WARNING, "[Daydream RTC] Warm-up failed: %s", e.what());
+		return;
+	}
+
+	auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+	blog(LOG_INFO, "[Daydream RTC] Runtime warmed up in %.1f ms", (double)elapsed.count() / 1000.0);
+}
+
+void daydream_rtc_init(void)
+{
+	unsigned int cores = std::thread::hardware_concurrency();
+	unsigned int threads = std::clamp(cores / 2, (unsigned int)RTC_MIN_THREADS, (unsigned int)RTC_MAX_THREADS);
+	rtc::SetThreadPoolSize(threads);
+	blog(LOG_INFO, "[Daydream RTC] Thread pool: %u threads", threads);
+
+	warm_thread = std::thread(warm_up);
+}
+
+void daydream_rtc_cleanup(void)
+{
+	if (warm_thread.joinable())
+		warm_thread.join();
+
+	if (rtc::Cleanup().wait_for(std::chrono::seconds(RTC_CLEANUP_TIMEOUT_S)) != std::future_status::ready)
+		blog(LOG_WARNING, "[Daydream RTC] Cleanup timed out");
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#ifdef __cplusplus
+#include <rtc/rtc.hpp>
+
+extern "C" {
+#endif
+
+// Process-wide libdatachannel setup shared by the WHIP and WHEP clients.
+// Call daydream_rtc_init once before the first connection and daydream_rtc_cleanup after the last.
+
+// Sizes the thread pool, then starts the runtime and the DTLS certificate in the background so the
+// first connection does not pay for either
+void daydream_rtc_init(void);
+void daydream_rtc_cleanup(void);
+
+#ifdef __cplusplus
+}
+
+// Base configuration for every peer connection. All use the same certificate type, so they share the
+// certificate libdatachannel generated during warm-up.
+rtc::Configuration daydream_rtc_config();
+#endif
@@ -0,0 +1,525 @@
+#include "daydream-rtp.h"
+#include "daydream-whip.h"
+#include <obs-module.h>
+
+#include <rtc/rtc.hpp>
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Same as libdatachannel's default for H.264 and AV1, so every codec leaves the same room for SRTP and headers
+#define MAX_PAYLOAD_SIZE 1220
+#define MAX_FRAME_PACKETS 4096
+
+#define PAYLOAD_TYPE_AV1 45
+#define PAYLOAD_TYPE_VP9 100
+#define PAYLOAD_TYPE_VP8 101
+
+#define AV1_OBU_TEMPORAL_DELIMITER 2
+#define AV1_OBU_TILE_LIST 8
+
+static const uint8_t *bytes(const rtc::binary &data)
+{
+	return reinterpret_cast<const uint8_t *>(data.data());
+}
+
+static void append(rtc::binary &out, const uint8_t *data, size_t size)
+{
+	const std::byte *begin = reinterpret_cast<const std::byte *>(data);
+	out.insert(out.end(), begin, begin + size);
+}
+
+// Uncompressed header: frame_marker (2), profile (2), a reserved bit in profile 3,
+// show_existing_frame (1), frame_type (1) with 0 for keyframes
+static bool vp9_is_keyframe(const uint8_t *data, size_t size)
+{
+	if (size == 0 || (data[0] >> 6) != 2)
+		return false;
+	int profile = ((data[0] >> 5) & 1) | (((data[0] >> 4) & 1) << 1);
+	int show_existing = profile == 3 ? 2 : 3;
+	if ((data[0] >> show_existing) & 1)
+		return false;
+	return ((data[0] >> (show_existing - 1)) & 1) == 0;
+}
+
+static bool read_leb128(const uint8_t *data, size_t size, size_t *pos, uint64_t *value)
+{
+	*value = 0;
+	for (int i = 0; i < 8; i++) {
+		if (*pos >= size)
+			return false;
+		uint8_t byte = data[(*pos)++];
+		*value |= (uint64_t)(byte & 0x7F) << (i * 7);
+		if (!(byte & 0x80))
+			return true;
+	}
+	return false;
+}
+
+static void write_leb128(rtc::binary &out, uint64_t value)
+{
+	do {
+		uint8_t byte = value & 0x7F;
+		value >>= 7;
+		if (value)
+			byte |= 0x80;
+		out.push_back(std::byte{byte});
+	} while (value);
+}
+
+// RFC 7741. Every packet carries a 15-bit picture ID so the receiver can tell frames apart across losses.
+class Vp8RtpPacketizer : public rtc::RtpPacketizer {
+public:
+	Vp8RtpPacketizer(std::shared_ptr<rtc::RtpPacketizationConfig> config) : rtc::RtpPacketizer(config) {}
+
+protected:
+	std::vector<rtc::binary> fragment(rtc::binary data) override
+	{
+		// X and S (start of partition 0) in the first byte, I in the extension, then M and the picture ID
+		uint8_t descriptor[4] = {0x90, 0x80, (uint8_t)(0x80 | (picture_id >> 8)), (uint8_t)(picture_id & 0xFF)};
+		picture_id = (picture_id + 1) & 0x7FFF;
+
+		std::vector<rtc::binary> fragments;
+		const size_t max = MAX_PAYLOAD_SIZE - sizeof(descriptor);
+		for (size_t pos = 0; pos < data.size(); pos += max) {
+			rtc::binary fragment;
+			append(fragment, descriptor, sizeof(descriptor));
+			append(fragment, bytes(data) + pos, std::min(max, data.size() - pos));
+			fragments.push_back(std::move(fragment));
+			descriptor[0] &= ~0x10;
+		}
+		return fragments;
+	}
+
+private:
+	uint16_t picture_id = 0;
+};
+
+// RFC 9628, non-flexible mode with a single spatial and temporal layer. Keyframes carry the scalability
+// structure with the frame size so the receiver can set up its decoder before the bitstream says so.
+class Vp9RtpPacketizer : public rtc::RtpPacketizer {
+public:
+	Vp9RtpPacketizer(std::shared_ptr<rtc::RtpPacketizationConfig> config, uint32_t width, uint32_t height)
+		: rtc::RtpPacketizer(config),
+		  width(width),
+		  height(height)
+	{
+	}
+
+protected:
+	std::vector<rtc::binary> fragment(rtc::binary data) override
+	{
+		bool keyframe = vp9_is_keyframe(bytes(data), data.size());
+		uint16_t id = picture_id;
+		picture_id = (picture_id + 1) & 0x7FFF;
+
+		std::vector<rtc::binary> fragments;
+		size_t pos = 0;
+		while (pos < data.size()) {
+			bool first = pos == 0;
+			// I, and P on frames that reference earlier ones; B and V are added on the first packet
+			uint8_t flags = keyframe ? 0x80 : 0xC0;
+			if (first)
+				flags |= keyframe ? 0x0A : 0x08;
+
+			rtc::binary fragment;
+			uint8_t header[3] = {flags, (uint8_t)(0x80 | (id >> 8)), (uint8_t)(id & 0xFF)};
+			append(fragment, header, sizeof(header));
+			if (first && keyframe) {
+				// N_S = 0 (one spatial layer), Y = 1 (sizes follow), G = 0
+				uint8_t ss[5] = {0x10, (uint8_t)(width >> 8), (uint8_t)width, (uint8_t)(height >> 8),
+						 (uint8_t)height};
+				append(fragment, ss, sizeof(ss));
+			}
+
+			size_t length = std::min(MAX_PAYLOAD_SIZE - fragment.size(), data.size() - pos);
+			append(fragment, bytes(data) + pos, length);
+			pos += length;
+			if (pos == data.size())
+				fragment[0] |= std::byte{0x04}; // E
+			fragments.push_back(std::move(fragment));
+		}
+		return fragments;
+	}
+
+private:
+	uint32_t width;
+	uint32_t height;
+	uint16_t picture_id = 0;
+};
+
+struct rtp_packet {
+	uint16_t seq;
+	rtc::binary payload;
+};
+
+// Collects the packets of one RTP timestamp and, on the marker bit, hands them to assemble in sequence
+// order. A frame with a missing packet is dropped whole; the decoder recovers at the next keyframe.
+class FrameDepacketizer : public rtc::MediaHandler {
+public:
+	void incoming(rtc::message_vector &messages, const rtc::message_callback &send) override
+	{
+		(void)send;
+		rtc::message_vector result;
+		for (const auto &message : messages) {
+			if (message->type == rtc::Message::Control) {
+				result.push_back(message);
+				continue;
+			}
+			receive(bytes(*message), message->size(), result);
+		}
+		messages.swap(result);
+	}
+
+protected:
+	virtual bool assemble(const std::vector<rtp_packet> &packets, rtc::binary &frame) = 0;
+
+private:
+	std::vector<rtp_packet> packets;
+	uint32_t timestamp = 0;
+
+	void receive(const uint8_t *p, size_t size, rtc::message_vector &result)
+	{
+		if (size < 12 || (p[0] >> 6) != 2)
+			return;
+
+		size_t header = 12 + (size_t)(p[0] & 0x0F) * 4;
+		if (p[0] & 0x10) {
+			if (size < header + 4)
+				return;
+			header += 4 + (size_t)(p[header + 2] << 8 | p[header + 3]) * 4;
+		}
+		size_t end = size;
+		if (p[0] & 0x20)
+			end -= std::min<size_t>(p[size - 1], size);
+		if (header >= end)
+			return;
+
+		bool marker = (p[1] & 0x80) != 0;
+		uint16_t seq = (uint16_t)(p[2] << 8 | p[3]);
+		uint32_t ts = (uint32_t)p[4] << 24 | (uint32_t)p[5] << 16 | (uint32_t)p[6] << 8 | p[7];
+
+		// The previous frame's last packet never arrived
+		if (!packets.empty() && (ts != timestamp || packets.size() >= MAX_FRAME_PACKETS))
+			packets.clear();
+		timestamp = ts;
+
+		rtp_packet packet{seq, {}};
+		append(packet.payload, p + header, end - header);
+		packets.push_back(std::move(packet));
+		if (!marker)
+			return;
+
+		std::sort(packets.begin(), packets.end(), [seq](const rtp_packet &a, const rtp_packet &b) {
+			return (int16_t)(a.seq - seq) < (int16_t)(b.seq - seq);
+		});
+		packets.erase(std::unique(packets.begin(), packets.end(),
+					  [](const rtp_packet &a, const rtp_packet &b) { return a.seq == b.seq; }),
+			      packets.end());
+
+		bool complete = true;
+		for (size_t i = 1; i < packets.size() && complete; i++)
+			complete = (uint16_t)(packets[i].seq - packets[i - 1].seq) == 1;
+
+		rtc::binary frame;
+		if (complete && assemble(packets, frame) && !frame.empty())
+			result.push_back(rtc::make_message(std::move(frame), std::make_shared<rtc::FrameInfo>(ts)));
+		packets.clear();
+	}
+};
+
+class Vp8RtpDepacketizer : public FrameDepacketizer {
+protected:
+	bool assemble(const std::vector<rtp_packet> &packets, rtc::binary &frame) override
+	{
+		for (size_t i = 0; i < packets.size(); i++) {
+			const uint8_t *p = bytes(packets[i].payload);
+			size_t size = packets[i].payload.size();
+			size_t offset = 1;
+			if (p[0] & 0x80) {
+				if (size < 2)
+					return false;
+				uint8_t extension = p[1];
+				offset = 2;
+				if (extension & 0x80) {
+					if (offset >= size)
+						return false;
+					offset += (p[offset] & 0x80) ? 2 : 1;
+				}
+				if (extension & 0x40)
+					offset++; // TL0PICIDX
+				if (extension & 0x30)
+					offset++; // TID/KEYIDX
+			}
+			if (offset > size)
+				return false;
+			// The frame has to start at the beginning of partition 0
+			if (i == 0 && (!(p[0] & 0x10) || (p[0] & 0x07) != 0))
+				return false;
+			append(frame, p + offset, size - offset);
+		}
+		return true;
+	}
+};
+
+class Vp9RtpDepacketizer : public FrameDepacketizer {
+protected:
+	bool assemble(const std::vector<rtp_packet> &packets, rtc::binary &frame) override
+	{
+		for (size_t i = 0; i < packets.size(); i++) {
+			const uint8_t *p = bytes(packets[i].payload);
+			size_t size = packets[i].payload.size();
+			uint8_t flags = p[0];
+			if ((i == 0 && !(flags & 0x08)) || (i + 1 == packets.size() && !(flags & 0x04)))
+				return false;
+
+			size_t offset = 1;
+			if (flags & 0x80) {
+				if (offset >= size)
+					return false;
+				offset += (p[offset] & 0x80) ? 2 : 1;
+			}
+			if (flags & 0x20)
+				offset += (flags & 0x10) ? 1 : 2; // Layer indices, plus TL0PICIDX in non-flexible mode
+			if ((flags & 0x10) && (flags & 0x40)) {
+				// Up to three reference indices, each with N set if another follows
+				for (int n = 0; n < 3; n++) {
+					if (offset >= size)
+						return false;
+					if (!(p[offset++] & 0x01))
+						break;
+				}
+			}
+			if (flags & 0x02) {
+				if (offset >= size)
+					return false;
+				uint8_t ss = p[offset++];
+				if (ss & 0x10)
+					offset += 4 * (size_t)((ss >> 5) + 1);
+				if (ss & 0x08) {
+					if (offset >= size)
+						return false;
+					int groups = p[offset++];
+					for (int g = 0; g < groups; g++) {
+						if (offset >= size)
+							return false;
+						offset += 1 + ((p[offset] >> 2) & 0x03);
+					}
+				}
+			}
+			if (offset > size)
+				return false;
+			append(frame, p + offset, size - offset);
+		}
+		return true;
+	}
+};
+
+// AV1 RTP payload: OBU elements without size fields, possibly split across packets. Rebuilt as a
+// temporal unit in the low-overhead format FFmpeg's decoders and muxers take.
+class Av1RtpDepacketizer : public FrameDepacketizer {
+protected:
+	bool assemble(const std::vector<rtp_packet> &packets, rtc::binary &frame) override
+	{
+		static const uint8_t temporal_delimiter[2] = {0x12, 0x00};
+		append(frame, temporal_delimiter, sizeof(temporal_delimiter));
+
+		rtc::binary obu;
+		for (size_t i = 0; i < packets.size(); i++) {
+			const uint8_t *p = bytes(packets[i].payload);
+			size_t size = packets[i].payload.size();
+			uint8_t aggregation = p[0];
+			bool continues = (aggregation & 0x80) != 0;  // Z
+			bool continued = (aggregation & 0x40) != 0;  // Y
+			int element_count = (aggregation >> 4) & 0x03; // W, 0 when every element has a length
+			if ((i == 0 && continues) || (i + 1 == packets.size() && continued))
+				return false;
+
+			size_t pos = 1;
+			for (int element = 1; pos < size; element++) {
+				uint64_t length = size - pos;
+				bool sized = element_count == 0 || element < element_count;
+				if (sized && !read_leb128(p, size, &pos, &length))
+					return false;
+				if (length > size - pos)
+					return false;
+
+				if (!(element == 1 && continues))
+					obu.clear();
+				append(obu, p + pos, (size_t)length);
+				pos += (size_t)length;
+
+				if (!(pos == size && continued))
+					write_obu(obu, frame);
+			}
+		}
+		return true;
+	}
+
+private:
+	static void write_obu(const rtc::binary &obu, rtc::binary &frame)
+	{
+		if (obu.empty())
+			return;
+		const uint8_t *p = bytes(obu);
+		uint8_t type = (p[0] >> 3) & 0x0F;
+		size_t header = 1 + ((p[0] >> 2) & 1);
+		if (type == AV1_OBU_TEMPORAL_DELIMITER || type == AV1_OBU_TILE_LIST || obu.size() < header)
+			return;
+
+		if (p[0] & 0x02) {
+			append(frame, p, obu.size());
+			return;
+		}
+		frame.push_back(std::byte{(uint8_t)(p[0] | 0x02)});
+		append(frame, p + 1, header - 1);
+		write_leb128(frame, obu.size() - header);
+		append(frame, p + header, obu.size() - header);
+	}
+};
+
+void daydream_rtp_add_codec(rtc::Description::Video &media, enum daydream_video_codec codec)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		media.addVP8Codec(PAYLOAD_TYPE_VP8);
+		break;
+	case DAYDREAM_CODEC_VP9:
+		media.addVP9Codec(PAYLOAD_TYPE_VP9, std::string("profile-id=0"));
+		break;
+	case DAYDREAM_CODEC_AV1:
+		media.addAV1Codec(PAYLOAD_TYPE_AV1);
+		break;
+	default:
+		break;
+	}
+}
+
+bool daydream_rtp_codec_from_format(const std::string &format, enum daydream_video_codec *codec)
+{
+	std::string name = format;
+	for (char &c : name)
+		c = (char)tolower((unsigned char)c);
+	return daydream_video_codec_parse(name.c_str(), codec);
+}
+
+std::shared_ptr<rtc::MediaHandler> daydream_rtp_packetizer(enum daydream_video_codec codec,
+							   std::shared_ptr<rtc::RtpPacketizationConfig> config,
+							   uint32_t width, uint32_t height)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		return std::make_shared<Vp8RtpPacketizer>(config);
+	case DAYDREAM_CODEC_VP9:
+		return std::make_shared<Vp9RtpPacketizer>(config, width, height);
+	case DAYDREAM_CODEC_AV1:
+		return std::make_shared<rtc::AV1RtpPacketizer>(rtc::AV1RtpPacketizer::Packetization::TemporalUnit,
+							       config);
+	default:
+		return std::make_shared<rtc::H264RtpPacketizer>(rtc::NalUnit::Separator::StartSequence, config);
+	}
+}
+
+std::shared_ptr<rtc::MediaHandler> daydream_rtp_depacketizer(enum daydream_video_codec codec)
+{
+	switch (codec) {
+	case DAYDREAM_CODEC_VP8:
+		return std::make_shared<Vp8RtpDepacketizer>();
+	case DAYDREAM_CODEC_VP9:
+		return std::make_shared<Vp9RtpDepacketizer>();
+	case DAYDREAM_CODEC_AV1:
+		return std::make_shared<Av1RtpDepacketizer>();
+	default:
+		return std::make_shared<rtc::H264RtpDepacketizer>();
+	}
+}
+
+void DaydreamFrameMarker::outgoing(rtc::message_vector &messages, const rtc::message_callback &send)
+{
+	(void)send;
+	if (end_of_frame)
+		return;
+	for (const auto &message : messages) {
+		// RTCP packet types 192-223 read as payload types 64-95 with the marker set (RFC 5761)
+		if (message->type == rtc::Message::Control || message->size() < 12)
+			continue;
+		uint8_t type = bytes(*message)[1] & 0x7F;
+		if (type >= 64 && type <= 95)
+			continue;
+		(*message)[1] &= std::byte{0x7F};
+	}
+}
+
+struct daydream_rtp_loopback {
+	std::shared_ptr<rtc::RtpPacketizationConfig> config;
+	std::shared_ptr<rtc::MediaHandler> packetizer;
+	std::shared_ptr<DaydreamFrameMarker> marker;
+	std::shared_ptr<rtc::MediaHandler> depacketizer;
+	daydream_rtp_frame_callback on_frame;
+	void *userdata;
+};
+
+struct daydream_rtp_loopback *daydream_rtp_loopback_create(enum daydream_video_codec codec, uint32_t width,
+							   uint32_t height, daydream_rtp_frame_callback on_frame,
+							   void *userdata)
+{
+	daydream_rtp_loopback *loopback = new daydream_rtp_loopback();
+	loopback->config = std::make_shared<rtc::RtpPacketizationConfig>(12345678, "daydream", 96,
+									  rtc::RtpPacketizer::defaultClockRate);
+	loopback->packetizer = daydream_rtp_packetizer(codec, loopback->config, width, height);
+	loopback->marker = std::make_shared<DaydreamFrameMarker>();
+	loopback->depacketizer = daydream_rtp_depacketizer(codec);
+	loopback->on_frame = on_frame;
+	loopback->userdata = userdata;
+	blog(LOG_INFO, "[Daydream RTP] Loopback using %s payload format", daydream_video_codec_name(codec));
+	return loopback;
+}
+
+void daydream_rtp_loopback_destroy(struct daydream_rtp_loopback *loopback)
+{
+	delete loopback;
+}
+
+bool daydream_rtp_loopback_send(struct daydream_rtp_loopback *loopback, const uint8_t *data, size_t size,
+				uint32_t timestamp_ms)
+{
+	return daydream_rtp_loopback_send_slice(loopback, data, size, timestamp_ms, true);
+}
+
+bool daydream_rtp_loopback_send_slice(struct daydream_rtp_loopback *loopback, const uint8_t *data, size_t size,
+				      uint32_t timestamp_ms, bool last_slice)
+{
+	if (!loopback || !data || size == 0)
+		return false;
+
+	try {
+		rtc::binary frame;
+		append(frame, data, size);
+		rtc::message_vector messages;
+		messages.push_back(rtc::make_message(std::move(frame)));
+
+		auto discard = [](rtc::message_ptr message) { (void)message; };
+		loopback->config->timestamp = daydream_whip_rtp_timestamp(timestamp_ms);
+		loopback->packetizer->outgoing(messages, discard);
+		loopback->marker->end_of_frame = last_slice;
+		loopback->marker->outgoing(messages, discard);
+		loopback->depacketizer->incoming(messages, discard);
+
+		bool delivered = !last_slice;
+		for (const auto &message : messages) {
+			if (!message->frameInfo || !loopback->on_frame)
+				continue;
+			loopback->on_frame(bytes(*message), message->size(), message->frameInfo->timestamp,
+					   loopback->userdata);
+			delivered = true;
+		}
+		return delivered;
+	} catch (const std::exception &e) {
+		blog(LOG_ERROR, "[Daydream RTP] Loopback failed: %s", e.what());
+		return false;
+	}
+}
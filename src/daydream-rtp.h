@@ -0,0 +1,65 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "daydream-codec.h"
+
+#ifdef __cplusplus
+#include <rtc/rtc.hpp>
+
+extern "C" {
+#endif
+
+// RTP payload formats for the codecs WHIP and WHEP negotiate. libdatachannel packetizes H.264 and AV1
+// itself; VP8 (RFC 7741) and VP9 (RFC 9628) packetizing, and all depacketizing other than H.264, is ours.
+
+// In-process stand-in for the gateway: each frame is packetized the way WHIP sends it and reassembled the
+// way WHEP receives it, so the headless tools can exercise the payload formats without a network
+struct daydream_rtp_loopback;
+
+typedef void (*daydream_rtp_frame_callback)(const uint8_t *data, size_t size, uint32_t timestamp, void *userdata);
+
+struct daydream_rtp_loopback *daydream_rtp_loopback_create(enum daydream_video_codec codec, uint32_t width,
+							   uint32_t height, daydream_rtp_frame_callback on_frame,
+							   void *userdata);
+void daydream_rtp_loopback_destroy(struct daydream_rtp_loopback *loopback);
+
+// Delivers the reassembled frame through on_frame before returning
+bool daydream_rtp_loopback_send(struct daydream_rtp_loopback *loopback, const uint8_t *data, size_t size,
+				uint32_t timestamp_ms);
+
+// One slice of a frame; the frame is delivered with its last slice
+bool daydream_rtp_loopback_send_slice(struct daydream_rtp_loopback *loopback, const uint8_t *data, size_t size,
+				      uint32_t timestamp_ms, bool last_slice);
+
+#ifdef __cplusplus
+}
+
+// Adds codec to an offer, with the payload type we use for it. H.264 is left to the callers, which offer
+// their own profiles.
+void daydream_rtp_add_codec(rtc::Description::Video &media, enum daydream_video_codec codec);
+
+// Codec of an rtpmap encoding name such as "VP9"; false for codecs we do not handle
+bool daydream_rtp_codec_from_format(const std::string &format, enum daydream_video_codec *codec);
+
+// Send side: first handler of the track's chain. width and height go into the VP9 scalability structure.
+std::shared_ptr<rtc::MediaHandler> daydream_rtp_packetizer(enum daydream_video_codec codec,
+							   std::shared_ptr<rtc::RtpPacketizationConfig> config,
+							   uint32_t width, uint32_t height);
+
+// Receive side: turns the track's RTP packets into whole frames for onFrame, dropping frames with gaps
+std::shared_ptr<rtc::MediaHandler> daydream_rtp_depacketizer(enum daydream_video_codec codec);
+
+// Chained right after the packetizer, which marks the last packet of every send as the end of a frame.
+// An access unit sent slice by slice must carry one marker, on the last packet of its last slice, or
+// receivers that split frames on the marker see one partial frame per slice. Set end_of_frame before
+// each send, from the sending thread.
+class DaydreamFrameMarker final : public rtc::MediaHandler {
+public:
+	void outgoing(rtc::message_vector &messages, const rtc::message_callback &send) override;
+
+	bool end_of_frame = true;
+};
+#endif
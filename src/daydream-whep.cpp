@@ -1,7 +1,9 @@
 #include "daydream-whep.h"
+#include "daydream-clock.h"
+#include "daydream-rtc.h"
+#include "daydream-rtp.h"
 #include <obs-module.h>
 #include <util/threading.h>
-#include <util/platform.h>
 #include <curl/curl.h>
 
 #include <rtc/rtc.hpp>
@@ -11,6 +13,33 @@
 #include <vector>
 #include <cstring>
 #include <memory>
+#include <algorithm>
+#include <variant>
+
+// Receiver-side rate control, evaluated once per window on the track's frame thread
+#define FEEDBACK_WINDOW_NS (1000 * 1000000ULL)
+#define FEEDBACK_MIN_BITRATE 150000
+#define FEEDBACK_DELAY_OVERUSE_MS 15.0 // Growth of the minimum one-way delay that signals a standing queue
+#define FEEDBACK_BUSY_OVERLOAD 0.85    // Fraction of wall time spent in on_frame that means decode can't keep up
+#define FEEDBACK_DECREASE 0.85
+#define FEEDBACK_INCREASE 1.08
+
+struct receive_estimator {
+	uint64_t window_start_ns;
+	uint64_t window_bytes;
+	uint64_t window_busy_ns;
+	uint32_t window_frames;
+
+	// One-way delay relative to the first frame; only its trend matters
+	bool have_base;
+	uint32_t base_rtp;
+	uint64_t base_arrival_ns;
+	double window_min_delay_ms;
+	double prev_min_delay_ms;
+	bool have_prev;
+
+	uint32_t target_bps;
+};
 
 struct daydream_whep {
 	std::string whep_url;
@@ -26,6 +55,13 @@ struct daydream_whep {
 
 	std::atomic<bool> connected;
 	std::atomic<bool> gathering_done;
+
+	std::vector<daydream_video_codec> codecs;
+	daydream_video_codec codec;
+
+	bool bitrate_feedback;
+	uint32_t max_bitrate;
+	receive_estimator estimator;
 };
 
 struct http_response {
@@ -67,6 +103,41 @@ static size_t header_callback(char *buffer, size_t size, size_t nitems, void *us
 	return realsize;
 }
 
+// First payload type in the answer that we offered; the depacketizer has to match it
+static daydream_video_codec answer_codec(daydream_whep *whep, rtc::Description &answer)
+{
+	for (int i = 0; i < answer.mediaCount(); i++) {
+		auto entry = answer.media(i);
+		auto *media = std::get_if<rtc::Description::Media *>(&entry);
+		if (!media || !*media || (*media)->type() != "video")
+			continue;
+
+		for (int payload_type : (*media)->payloadTypes()) {
+			const auto *rtp_map = (*media)->rtpMap(payload_type);
+			daydream_video_codec codec;
+			if (rtp_map && daydream_rtp_codec_from_format(rtp_map->format, &codec) &&
+			    std::find(whep->codecs.begin(), whep->codecs.end(), codec) != whep->codecs.end()) {
+				blog(LOG_INFO, "[Daydream WHEP] Negotiated %s (payload type %d)",
+				     daydream_video_codec_name(codec), payload_type);
+				return codec;
+			}
+		}
+	}
+
+	blog(LOG_WARNING, "[Daydream WHEP] Answer did not select an offered codec, expecting H.264");
+	return DAYDREAM_CODEC_H264;
+}
+
+static void attach_media_handlers(daydream_whep *whep)
+{
+	whep->track->setMediaHandler(daydream_rtp_depacketizer(whep->codec));
+
+	if (whep->bitrate_feedback) {
+		// Receiver reports plus the REMB channel used by update_feedback
+		whep->track->chainMediaHandler(std::make_shared<rtc::RtcpReceivingSession>());
+	}
+}
+
 static bool send_whep_request_once(daydream_whep *whep, const std::string &sdp_offer, long *out_http_code)
 {
 	CURL *curl = curl_easy_init();
@@ -118,7 +189,10 @@ static bool send_whep_request_once(daydream_whep *whep, const std::string &sdp_o
 
 	if (!response->data.empty()) {
 		blog(LOG_INFO, "[Daydream WHEP] Setting remote description (answer)");
-		whep->pc->setRemoteDescription(rtc::Description(response->data, rtc::Description::Type::Answer));
+		rtc::Description answer(response->data, rtc::Description::Type::Answer);
+		whep->codec = answer_codec(whep, answer);
+		attach_media_handlers(whep);
+		whep->pc->setRemoteDescription(answer);
 	}
 
 	delete response;
@@ -143,12 +217,12 @@ static bool send_whep_request(daydream_whep *whep, const std::string &sdp_offer)
 
 		if (http_code == 429) {
 			blog(LOG_INFO, "[Daydream WHEP] Rate limited, waiting %dms...", rate_limit_delay_ms);
-			os_sleep_ms(rate_limit_delay_ms);
+			daydream_clock_sleep_ms(rate_limit_delay_ms);
 			continue;
 		}
 
 		if (http_code == 404 || http_code == 503 || http_code == 0) {
-			os_sleep_ms(retry_delay_ms);
+			daydream_clock_sleep_ms(retry_delay_ms);
 			continue;
 		}
 
@@ -173,6 +247,12 @@ struct daydream_whep *daydream_whep_create(const struct daydream_whep_config *co
 	whep->userdata = config->userdata;
 	whep->connected = false;
 	whep->gathering_done = false;
+	whep->bitrate_feedback = config->bitrate_feedback;
+	whep->max_bitrate = config->max_bitrate > 0 ? config->max_bitrate : 4000000;
+	whep->codecs.assign(config->codecs, config->codecs + config->codec_count);
+	if (whep->codecs.empty())
+		whep->codecs.push_back(DAYDREAM_CODEC_H264);
+	whep->codec = DAYDREAM_CODEC_H264;
 
 	return whep;
 }
@@ -186,6 +266,82 @@ void daydream_whep_destroy(struct daydream_whep *whep)
 	delete whep;
 }
 
+void daydream_whep_set_url(struct daydream_whep *whep, const char *whep_url)
+{
+	if (!whep || !whep_url)
+		return;
+
+	whep->whep_url = whep_url;
+}
+
+static void update_feedback(daydream_whep *whep, size_t size, uint32_t rtp_timestamp, uint64_t arrival_ns,
+			    uint64_t busy_ns)
+{
+	receive_estimator &est = whep->estimator;
+
+	if (!est.have_base || (uint32_t)(rtp_timestamp - est.base_rtp) > 0x40000000u) {
+		// First frame, or far enough along that the 32-bit delta would become ambiguous
+		est.have_base = true;
+		est.have_prev = false;
+		est.base_rtp = rtp_timestamp;
+		est.base_arrival_ns = arrival_ns;
+		est.window_start_ns = arrival_ns;
+		est.window_min_delay_ms = 0.0;
+		est.window_frames = 0;
+	}
+
+	double media_ms = (double)(int32_t)(rtp_timestamp - est.base_rtp) / 90.0;
+	double arrival_ms = (double)(arrival_ns - est.base_arrival_ns) / 1000000.0;
+	double delay_ms = arrival_ms - media_ms;
+	if (est.window_frames == 0 || delay_ms < est.window_min_delay_ms)
+		est.window_min_delay_ms = delay_ms;
+
+	est.window_bytes += size;
+	est.window_busy_ns += busy_ns;
+	est.window_frames++;
+
+	uint64_t elapsed = arrival_ns - est.window_start_ns;
+	if (elapsed < FEEDBACK_WINDOW_NS)
+		return;
+
+	double received_bps = (double)est.window_bytes * 8.0 * 1e9 / (double)elapsed;
+	double busy = (double)est.window_busy_ns / (double)elapsed;
+	double delay_trend_ms = est.have_prev ? est.window_min_delay_ms - est.prev_min_delay_ms : 0.0;
+
+	bool overuse = delay_trend_ms > FEEDBACK_DELAY_OVERUSE_MS;
+	bool overload = busy > FEEDBACK_BUSY_OVERLOAD;
+	uint32_t previous = est.target_bps ? est.target_bps : whep->max_bitrate;
+
+	double target;
+	if (overuse || overload)
+		target = std::min((double)previous, received_bps) * FEEDBACK_DECREASE;
+	else
+		target = (double)previous * FEEDBACK_INCREASE;
+	target = std::clamp(target, (double)FEEDBACK_MIN_BITRATE, (double)whep->max_bitrate);
+	est.target_bps = (uint32_t)target;
+
+	if (overuse || overload || est.target_bps != previous) {
+		blog(LOG_INFO,
+		     "[Daydream WHEP] Feedback: recv %.0f kbps, delay trend %+.1f ms, decode busy %.0f%%, REMB %u kbps",
+		     received_bps / 1000.0, delay_trend_ms, busy * 100.0, est.target_bps / 1000);
+	}
+
+	// REMB is sent every window, not just on change, as senders expire stale estimates
+	try {
+		if (whep->track)
+			whep->track->requestBitrate(est.target_bps);
+	} catch (const std::exception &e) {
+		blog(LOG_WARNING, "[Daydream WHEP] Failed to send REMB: %s", e.what());
+	}
+
+	est.prev_min_delay_ms = est.window_min_delay_ms;
+	est.have_prev = true;
+	est.window_start_ns = arrival_ns;
+	est.window_bytes = 0;
+	est.window_busy_ns = 0;
+	est.window_frames = 0;
+}
+
 bool daydream_whep_connect(struct daydream_whep *whep)
 {
 	if (!whep)
@@ -193,10 +349,7 @@ bool daydream_whep_connect(struct daydream_whep *whep)
 
 	blog(LOG_INFO, "[Daydream WHEP] Connecting to %s", whep->whep_url.c_str());
 
-	rtc::Configuration config;
-	config.disableAutoNegotiation = true; // Manual negotiation for faster setup
-
-	whep->pc = std::make_shared<rtc::PeerConnection>(config);
+	whep->pc = std::make_shared<rtc::PeerConnection>(daydream_rtc_config());
 
 	whep->pc->onStateChange([whep](rtc::PeerConnection::State state) {
 		const char *state_str = "unknown";
@@ -255,7 +408,12 @@ bool daydream_whep_connect(struct daydream_whep *whep)
 	});
 
 	rtc::Description::Video media("video", rtc::Description::Direction::RecvOnly);
-	media.addH264Codec(96);
+	for (daydream_video_codec codec : whep->codecs) {
+		if (codec == DAYDREAM_CODEC_H264)
+			media.addH264Codec(96);
+		else
+			daydream_rtp_add_codec(media, codec);
+	}
 
 	whep->track = whep->pc->addTrack(media);
 
@@ -264,8 +422,10 @@ bool daydream_whep_connect(struct daydream_whep *whep)
 	audioMedia.addOpusCodec(111);
 	(void)whep->pc->addTrack(audioMedia);
 
-	auto depacketizer = std::make_shared<rtc::H264RtpDepacketizer>();
-	whep->track->setMediaHandler(depacketizer);
+	// The depacketizer is attached once the answer says which codec to expect
+	whep->codec = DAYDREAM_CODEC_H264;
+	if (whep->bitrate_feedback)
+		whep->estimator = receive_estimator{};
 
 	whep->track->onFrame([whep](rtc::binary data, rtc::FrameInfo info) {
 		int size = static_cast<int>(data.size());
@@ -274,8 +434,15 @@ bool daydream_whep_connect(struct daydream_whep *whep)
 
 		const uint8_t *frame_data = reinterpret_cast<const uint8_t *>(data.data());
 
+		uint64_t arrival_ns = daydream_clock_now_ns();
 		if (whep->on_frame)
 			whep->on_frame(frame_data, size, info.timestamp, false, whep->userdata);
+
+		// Time spent in on_frame (decode and everything after it) is our measure of local capacity
+		if (whep->bitrate_feedback) {
+			uint64_t busy_ns = daydream_clock_now_ns() - arrival_ns;
+			update_feedback(whep, data.size(), info.timestamp, arrival_ns, busy_ns);
+		}
 	});
 
 	whep->pc->setLocalDescription();
@@ -283,7 +450,7 @@ bool daydream_whep_connect(struct daydream_whep *whep)
 	whep->gathering_done = false;
 	int timeout = 100;
 	while (!whep->gathering_done && timeout > 0) {
-		os_sleep_ms(100);
+		daydream_clock_sleep_ms(100);
 		timeout--;
 	}
 
@@ -335,3 +502,8 @@ bool daydream_whep_is_connected(struct daydream_whep *whep)
 		return false;
 	return whep->connected;
 }
+
+enum daydream_video_codec daydream_whep_get_codec(struct daydream_whep *whep)
+{
+	return whep ? whep->codec : DAYDREAM_CODEC_H264;
+}
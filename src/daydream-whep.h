@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "daydream-codec.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,18 +20,35 @@ typedef void (*daydream_whep_state_callback)(bool connected, const char *error,
 struct daydream_whep_config {
 	const char *whep_url;
 	const char *api_key;
+
+	// Codecs to offer, most preferred first; H.264 alone when empty
+	const enum daydream_video_codec *codecs;
+	size_t codec_count;
+
 	daydream_whep_frame_callback on_frame;
 	daydream_whep_state_callback on_state;
 	void *userdata;
+
+	// Send REMB so the server's output encoder backs off when the downlink or
+	// local decoding falls behind
+	bool bitrate_feedback;
+	uint32_t max_bitrate; // Ceiling for the requested rate in bps, 0 for 4 Mbps
 };
 
 struct daydream_whep *daydream_whep_create(const struct daydream_whep_config *config);
 void daydream_whep_destroy(struct daydream_whep *whep);
 
+// Endpoint for the next connect, to fall back to another after a failed one
+void daydream_whep_set_url(struct daydream_whep *whep, const char *whep_url);
+
 bool daydream_whep_connect(struct daydream_whep *whep);
 void daydream_whep_disconnect(struct daydream_whep *whep);
 bool daydream_whep_is_connected(struct daydream_whep *whep);
 
+// Codec of the frames on_frame receives, from the SDP answer. H.264 before connect and if the answer
+// did not pick one of the offered codecs.
+enum daydream_video_codec daydream_whep_get_codec(struct daydream_whep *whep);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,7 +1,9 @@
 #include "daydream-whip.h"
+#include "daydream-clock.h"
+#include "daydream-rtc.h"
+#include "daydream-rtp.h"
 #include <obs-module.h>
 #include <util/threading.h>
-#include <util/platform.h>
 #include <curl/curl.h>
 
 #include <rtc/rtc.hpp>
@@ -13,6 +15,18 @@
 #include <cstring>
 #include <memory>
 #include <chrono>
+#include <cstdlib>
+#include <variant>
+#include <algorithm>
+
+// Gateway RTCP seen on the send track. Written from the libdatachannel thread, read by the encode thread.
+struct send_feedback {
+	std::mutex mutex;
+	double loss_fraction = -1.0; // From the latest receiver report block for our SSRC
+	uint32_t remb_bitrate = 0;
+	int32_t rtt_ms = -1;
+	uint64_t reports = 0;
+};
 
 struct daydream_whip {
 	std::string whip_url;
@@ -30,13 +44,152 @@ struct daydream_whip {
 	std::shared_ptr<rtc::PeerConnection> pc;
 	std::shared_ptr<rtc::Track> track;
 	std::shared_ptr<rtc::RtpPacketizationConfig> rtpConfig;
+	std::shared_ptr<DaydreamFrameMarker> marker;
+	std::shared_ptr<send_feedback> feedback;
+	std::string local_address;
+	std::string public_address;
+	std::string stun_server;
 
 	std::atomic<bool> connected;
 	std::atomic<bool> gathering_done;
 
 	uint32_t ssrc;
+	std::vector<daydream_video_codec> codecs;
+	daydream_video_codec codec;
+	daydream_h264_profile h264_profile;
+};
+
+struct h264_offer {
+	int payload_type;
+	const char *profile_level_id;
+	daydream_h264_profile profile;
+};
+
+// Offered in preference order. All are constrained (no B-frames) at level 3.1, which covers 512x512 at 30 fps
+// with plenty of headroom; CABAC and the 8x8 transform in Main/High save bitrate at the rates we stream at.
+static const h264_offer h264_offers[] = {
+	{96, "640c1f", DAYDREAM_H264_HIGH},
+	{97, "4d001f", DAYDREAM_H264_MAIN},
+	{98, "42e01f", DAYDREAM_H264_BASELINE},
 };
 
+// Middle 32 bits of the current NTP time, the unit of the LSR/DLSR fields in receiver reports.
+// RtcpSrReporter stamps its sender reports from the same wall clock.
+static uint32_t ntp_middle_now()
+{
+	auto since_epoch = std::chrono::system_clock::now().time_since_epoch();
+	uint64_t us = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(since_epoch).count();
+	uint64_t seconds = us / 1000000 + 2208988800ULL; // 1900 epoch
+	uint64_t fraction = ((us % 1000000) << 32) / 1000000;
+	return (uint32_t)((seconds & 0xFFFF) << 16) | (uint32_t)(fraction >> 16);
+}
+
+static uint32_t read_be32(const uint8_t *p)
+{
+	return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3];
+}
+
+// Reads receiver report blocks (in SR and RR) and REMB out of the compound RTCP the gateway sends back.
+// Messages are left in place for the rest of the chain.
+class FeedbackHandler : public rtc::MediaHandler {
+public:
+	FeedbackHandler(uint32_t ssrc, std::shared_ptr<send_feedback> feedback) : ssrc(ssrc), feedback(feedback) {}
+
+	void incoming(rtc::message_vector &messages, const rtc::message_callback &send) override
+	{
+		(void)send;
+		for (const auto &message : messages) {
+			if (message->type == rtc::Message::Control)
+				parse(reinterpret_cast<const uint8_t *>(message->data()), message->size());
+		}
+	}
+
+private:
+	uint32_t ssrc;
+	std::shared_ptr<send_feedback> feedback;
+
+	void parse(const uint8_t *data, size_t size)
+	{
+		while (size >= 8) {
+			uint8_t count = data[0] & 0x1F;
+			uint8_t type = data[1];
+			size_t length = ((size_t)(data[2] << 8 | data[3]) + 1) * 4;
+			if ((data[0] >> 6) != 2 || length > size)
+				return;
+
+			if (type == 200 || type == 201) {
+				// SR carries 20 bytes of sender info before its report blocks
+				size_t offset = type == 200 ? 28 : 8;
+				for (uint8_t i = 0; i < count && offset + 24 <= length; i++, offset += 24)
+					report_block(data + offset);
+			} else if (type == 206 && count == 15 && length >= 20 && memcmp(data + 12, "REMB", 4) == 0) {
+				uint8_t exponent = data[17] >> 2;
+				uint64_t mantissa = (uint64_t)(data[17] & 0x03) << 16 | (uint64_t)data[18] << 8 |
+						    data[19];
+				uint64_t bitrate = exponent < 46 ? mantissa << exponent : UINT32_MAX;
+				std::lock_guard<std::mutex> lock(feedback->mutex);
+				feedback->remb_bitrate = bitrate > UINT32_MAX ? UINT32_MAX : (uint32_t)bitrate;
+			}
+
+			data += length;
+			size -= length;
+		}
+	}
+
+	void report_block(const uint8_t *block)
+	{
+		if (read_be32(block) != ssrc)
+			return;
+
+		uint32_t lsr = read_be32(block + 16);
+		uint32_t dlsr = read_be32(block + 20);
+
+		std::lock_guard<std::mutex> lock(feedback->mutex);
+		feedback->loss_fraction = block[4] / 256.0;
+		feedback->reports++;
+		if (lsr != 0) {
+			uint32_t rtt = ntp_middle_now() - lsr - dlsr; // 1/65536 s
+			if (rtt < 10 * 65536)
+				feedback->rtt_ms = (int32_t)((uint64_t)rtt * 1000 / 65536);
+		}
+	}
+};
+
+// First IPv4 candidate of the given type in our offer, falling back to any candidate of that type
+static std::string candidate_address(const std::string &sdp, const char *type)
+{
+	std::string typ = std::string(" typ ") + type;
+	std::string fallback;
+	size_t pos = 0;
+	while ((pos = sdp.find("a=candidate:", pos)) != std::string::npos) {
+		size_t end = sdp.find_first_of("\r\n", pos);
+		std::string line = sdp.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+		pos = end == std::string::npos ? sdp.size() : end;
+
+		size_t typ_pos = line.find(typ);
+		if (typ_pos == std::string::npos ||
+		    (typ_pos + typ.size() < line.size() && line[typ_pos + typ.size()] != ' '))
+			continue;
+
+		// candidate:<foundation> <component> <transport> <priority> <address> <port> typ <type>
+		size_t field = 0;
+		for (int i = 0; i < 4 && field != std::string::npos; i++)
+			field = line.find(' ', field + 1);
+		if (field == std::string::npos)
+			continue;
+		size_t address_end = line.find(' ', field + 1);
+		if (address_end == std::string::npos)
+			continue;
+
+		std::string address = line.substr(field + 1, address_end - field - 1);
+		if (address.find(':') == std::string::npos)
+			return address;
+		if (fallback.empty())
+			fallback = address;
+	}
+	return fallback;
+}
+
 struct http_response {
 	std::string data;
 	std::string location;
@@ -86,6 +239,94 @@ static size_t header_callback(char *buffer, size_t size, size_t nitems, void *us
 	return realsize;
 }
 
+static bool profile_from_fmtp(const std::vector<std::string> &fmtps, daydream_h264_profile *profile)
+{
+	for (const std::string &fmtp : fmtps) {
+		size_t pos = fmtp.find("profile-level-id=");
+		if (pos == std::string::npos || fmtp.size() < pos + 17 + 2)
+			continue;
+
+		int profile_idc = (int)strtol(fmtp.substr(pos + 17, 2).c_str(), nullptr, 16);
+		switch (profile_idc) {
+		case 0x64:
+			*profile = DAYDREAM_H264_HIGH;
+			return true;
+		case 0x4d:
+			*profile = DAYDREAM_H264_MAIN;
+			return true;
+		case 0x42:
+			*profile = DAYDREAM_H264_BASELINE;
+			return true;
+		default:
+			return false;
+		}
+	}
+	return false;
+}
+
+static bool offered(daydream_whip *whip, daydream_video_codec codec)
+{
+	return std::find(whip->codecs.begin(), whip->codecs.end(), codec) != whip->codecs.end();
+}
+
+// The answer lists accepted payload types in preference order; send with the first one we offered
+static void apply_answer_codec(daydream_whip *whip, rtc::Description &answer)
+{
+	for (int i = 0; i < answer.mediaCount(); i++) {
+		auto entry = answer.media(i);
+		auto *media = std::get_if<rtc::Description::Media *>(&entry);
+		if (!media || !*media || (*media)->type() != "video")
+			continue;
+
+		for (int payload_type : (*media)->payloadTypes()) {
+			const auto *rtp_map = (*media)->rtpMap(payload_type);
+			daydream_video_codec codec;
+			if (!rtp_map || !daydream_rtp_codec_from_format(rtp_map->format, &codec))
+				continue;
+			if (!offered(whip, codec))
+				continue;
+
+			if (codec == DAYDREAM_CODEC_H264) {
+				const h264_offer *offer = nullptr;
+				for (const h264_offer &candidate : h264_offers) {
+					if (candidate.payload_type == payload_type)
+						offer = &candidate;
+				}
+
+				// Trust the answer's own fmtp over our payload type mapping when it has one
+				daydream_h264_profile profile = offer ? offer->profile : DAYDREAM_H264_BASELINE;
+				if (!profile_from_fmtp(rtp_map->fmtps, &profile) && !offer)
+					continue;
+				whip->h264_profile = profile;
+			}
+
+			whip->codec = codec;
+			whip->rtpConfig->payloadType = static_cast<uint8_t>(payload_type);
+			if (codec == DAYDREAM_CODEC_H264)
+				blog(LOG_INFO, "[Daydream WHIP] Negotiated H.264 %s (payload type %d)",
+				     daydream_h264_profile_name(whip->h264_profile), payload_type);
+			else
+				blog(LOG_INFO, "[Daydream WHIP] Negotiated %s (payload type %d)",
+				     daydream_video_codec_name(codec), payload_type);
+			return;
+		}
+	}
+
+	blog(LOG_WARNING, "[Daydream WHIP] Answer did not select an offered codec, using H.264 baseline");
+}
+
+// The packetizer depends on the codec the answer picked, so the chain is only built once it is known
+static void attach_media_handlers(daydream_whip *whip)
+{
+	whip->track->setMediaHandler(daydream_rtp_packetizer(whip->codec, whip->rtpConfig, whip->width, whip->height));
+	whip->marker = std::make_shared<DaydreamFrameMarker>();
+	whip->track->chainMediaHandler(whip->marker);
+
+	// Sender reports give the gateway's receiver reports an LSR to answer, which is where the RTT comes from
+	whip->track->chainMediaHandler(std::make_shared<rtc::RtcpSrReporter>(whip->rtpConfig));
+	whip->track->chainMediaHandler(std::make_shared<FeedbackHandler>(whip->ssrc, whip->feedback));
+}
+
 static bool send_whip_offer(daydream_whip *whip, const std::string &sdp_offer)
 {
 	CURL *curl = curl_easy_init();
@@ -142,7 +383,10 @@ static bool send_whip_offer(daydream_whip *whip, const std::string &sdp_offer)
 
 	if (!response->data.empty()) {
 		blog(LOG_INFO, "[Daydream WHIP] Setting remote description");
-		whip->pc->setRemoteDescription(rtc::Description(response->data, rtc::Description::Type::Answer));
+		rtc::Description answer(response->data, rtc::Description::Type::Answer);
+		apply_answer_codec(whip, answer);
+		attach_media_handlers(whip);
+		whip->pc->setRemoteDescription(answer);
 	}
 
 	delete response;
@@ -162,9 +406,15 @@ struct daydream_whip *daydream_whip_create(const struct daydream_whip_config *co
 	whip->fps = config->fps > 0 ? config->fps : 30;
 	whip->on_state = config->on_state;
 	whip->userdata = config->userdata;
+	whip->stun_server = config->stun_server ? config->stun_server : "";
 	whip->connected = false;
 	whip->gathering_done = false;
 	whip->ssrc = 12345678;
+	whip->codecs.assign(config->codecs, config->codecs + config->codec_count);
+	if (whip->codecs.empty())
+		whip->codecs.push_back(DAYDREAM_CODEC_H264);
+	whip->codec = DAYDREAM_CODEC_H264;
+	whip->h264_profile = DAYDREAM_H264_BASELINE;
 
 	return whip;
 }
@@ -185,9 +435,11 @@ bool daydream_whip_connect(struct daydream_whip *whip)
 
 	blog(LOG_INFO, "[Daydream WHIP] Connecting to %s", whip->whip_url.c_str());
 
-	rtc::Configuration config;
-	config.disableAutoNegotiation = true; // Manual negotiation for faster setup
-
+	// A STUN server only adds a server-reflexive candidate for the bitrate history; the gateway's
+	// candidates still decide the path
+	rtc::Configuration config = daydream_rtc_config();
+	if (!whip->stun_server.empty())
+		config.iceServers.emplace_back(whip->stun_server);
 	whip->pc = std::make_shared<rtc::PeerConnection>(config);
 
 	whip->pc->onStateChange([whip](rtc::PeerConnection::State state) {
@@ -247,8 +499,20 @@ bool daydream_whip_connect(struct daydream_whip *whip)
 	});
 
 	rtc::Description::Video videoMedia("video", rtc::Description::Direction::SendOnly);
-	videoMedia.addH264Codec(96);
+	for (daydream_video_codec codec : whip->codecs) {
+		if (codec != DAYDREAM_CODEC_H264) {
+			daydream_rtp_add_codec(videoMedia, codec);
+			continue;
+		}
+		for (const h264_offer &offer : h264_offers) {
+			std::string fmtp = std::string("profile-level-id=") + offer.profile_level_id +
+					   ";packetization-mode=1;level-asymmetry-allowed=1";
+			videoMedia.addH264Codec(offer.payload_type, fmtp);
+		}
+	}
 	videoMedia.addSSRC(whip->ssrc, "daydream");
+	whip->codec = DAYDREAM_CODEC_H264;
+	whip->h264_profile = DAYDREAM_H264_BASELINE;
 
 	whip->track = whip->pc->addTrack(videoMedia);
 
@@ -258,13 +522,10 @@ bool daydream_whip_connect(struct daydream_whip *whip)
 	audioMedia.addSSRC(whip->ssrc + 1, "daydream-audio");
 	(void)whip->pc->addTrack(audioMedia);
 
-	whip->rtpConfig = std::make_shared<rtc::RtpPacketizationConfig>(whip->ssrc, "daydream", 96,
+	// Payload type is updated from the answer; the baseline entry is the one every H.264 receiver takes
+	whip->rtpConfig = std::make_shared<rtc::RtpPacketizationConfig>(whip->ssrc, "daydream", 98,
 									rtc::H264RtpPacketizer::defaultClockRate);
-
-	auto packetizer =
-		std::make_shared<rtc::H264RtpPacketizer>(rtc::NalUnit::Separator::StartSequence, whip->rtpConfig);
-
-	whip->track->setMediaHandler(packetizer);
+	whip->feedback = std::make_shared<send_feedback>();
 
 	whip->track->onOpen([whip]() { blog(LOG_INFO, "[Daydream WHIP] Video track opened"); });
 
@@ -275,7 +536,7 @@ bool daydream_whip_connect(struct daydream_whip *whip)
 	whip->gathering_done = false;
 	int timeout = 100;
 	while (!whip->gathering_done && timeout > 0) {
-		os_sleep_ms(100);
+		daydream_clock_sleep_ms(100);
 		timeout--;
 	}
 
@@ -293,6 +554,8 @@ bool daydream_whip_connect(struct daydream_whip *whip)
 	}
 
 	std::string sdp = std::string(*localDesc);
+	whip->local_address = candidate_address(sdp, "host");
+	whip->public_address = candidate_address(sdp, "srflx");
 	blog(LOG_INFO, "[Daydream WHIP] Local SDP created (%zu bytes):\n%s", sdp.size(), sdp.c_str());
 
 	if (!send_whip_offer(whip, sdp)) {
@@ -315,6 +578,8 @@ void daydream_whip_disconnect(struct daydream_whip *whip)
 
 	whip->track.reset();
 	whip->rtpConfig.reset();
+	whip->marker.reset();
+	whip->feedback.reset();
 	whip->connected = false;
 	whip->gathering_done = false;
 	whip->resource_url.clear();
@@ -329,8 +594,14 @@ bool daydream_whip_is_connected(struct daydream_whip *whip)
 	return whip->connected;
 }
 
-bool daydream_whip_send_frame(struct daydream_whip *whip, const uint8_t *h264_data, size_t size, uint32_t timestamp_ms,
+bool daydream_whip_send_frame(struct daydream_whip *whip, const uint8_t *data, size_t size, uint32_t timestamp_ms,
 			      bool is_keyframe)
+{
+	return daydream_whip_send_slice(whip, data, size, timestamp_ms, is_keyframe, true);
+}
+
+bool daydream_whip_send_slice(struct daydream_whip *whip, const uint8_t *data, size_t size, uint32_t timestamp_ms,
+			      bool is_keyframe, bool last_slice)
 {
 	UNUSED_PARAMETER(is_keyframe);
 
@@ -343,13 +614,14 @@ bool daydream_whip_send_frame(struct daydream_whip *whip, const uint8_t *h264_da
 		return false;
 	}
 
-	if (!h264_data || size == 0)
+	if (!data || size == 0)
 		return false;
 
 	try {
-		uint32_t rtp_timestamp = static_cast<uint32_t>((timestamp_ms * 90ULL) % UINT32_MAX);
-		whip->rtpConfig->timestamp = rtp_timestamp;
-		whip->track->send(reinterpret_cast<const std::byte *>(h264_data), size);
+		whip->rtpConfig->timestamp = daydream_whip_rtp_timestamp(timestamp_ms);
+		if (whip->marker)
+			whip->marker->end_of_frame = last_slice;
+		whip->track->send(reinterpret_cast<const std::byte *>(data), size);
 		return true;
 	} catch (const std::exception &e) {
 		blog(LOG_ERROR, "[Daydream WHIP] Failed to send frame: %s", e.what());
@@ -357,6 +629,13 @@ bool daydream_whip_send_frame(struct daydream_whip *whip, const uint8_t *h264_da
 	}
 }
 
+// Wraps modulo 2^32 as RTP requires (every ~13.3 hours at 90 kHz). 2^32 ms is a multiple of 2^32 ticks,
+// so timestamp_ms wrapping after ~49.7 days is seamless too.
+uint32_t daydream_whip_rtp_timestamp(uint32_t timestamp_ms)
+{
+	return static_cast<uint32_t>(timestamp_ms * 90ULL);
+}
+
 const char *daydream_whip_get_whep_url(struct daydream_whip *whip)
 {
 	if (!whip || whip->whep_url.empty())
@@ -364,11 +643,54 @@ const char *daydream_whip_get_whep_url(struct daydream_whip *whip)
 	return whip->whep_url.c_str();
 }
 
+enum daydream_video_codec daydream_whip_get_codec(struct daydream_whip *whip)
+{
+	return whip ? whip->codec : DAYDREAM_CODEC_H264;
+}
+
+enum daydream_h264_profile daydream_whip_get_h264_profile(struct daydream_whip *whip)
+{
+	return whip ? whip->h264_profile : DAYDREAM_H264_BASELINE;
+}
+
+const char *daydream_whip_get_local_address(struct daydream_whip *whip)
+{
+	if (!whip || whip->local_address.empty())
+		return nullptr;
+	return whip->local_address.c_str();
+}
+
+const char *daydream_whip_get_public_address(struct daydream_whip *whip)
+{
+	if (!whip || whip->public_address.empty())
+		return nullptr;
+	return whip->public_address.c_str();
+}
+
+bool daydream_whip_get_feedback(struct daydream_whip *whip, struct daydream_whip_feedback *feedback)
+{
+	if (!whip || !whip->feedback || !feedback)
+		return false;
+
+	std::lock_guard<std::mutex> lock(whip->feedback->mutex);
+	feedback->loss_fraction = whip->feedback->loss_fraction;
+	feedback->remb_bitrate = whip->feedback->remb_bitrate;
+	feedback->rtt_ms = whip->feedback->rtt_ms;
+	feedback->reports = whip->feedback->reports;
+	return true;
+}
+
 int32_t daydream_whip_get_rtt_ms(struct daydream_whip *whip)
 {
 	if (!whip || !whip->pc || !whip->connected)
 		return -1;
 
+	if (whip->feedback) {
+		std::lock_guard<std::mutex> lock(whip->feedback->mutex);
+		if (whip->feedback->rtt_ms >= 0)
+			return whip->feedback->rtt_ms;
+	}
+
 	try {
 		auto rtt = whip->pc->rtt();
 		if (rtt.has_value()) {
@@ -4,6 +4,8 @@
 #include <stdint.h>
 #include <stddef.h>
 
+#include "daydream-encoder.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -18,6 +20,15 @@ struct daydream_whip_config {
 	uint32_t width;
 	uint32_t height;
 	uint32_t fps;
+
+	// Codecs to offer, most preferred first; H.264 alone when empty
+	const enum daydream_video_codec *codecs;
+	size_t codec_count;
+
+	// Optional "stun:host:port". It only adds a server-reflexive candidate, whose address tells
+	// networks apart for the bitrate history; NULL or empty sends nothing to a third party.
+	const char *stun_server;
+
 	daydream_whip_state_callback on_state;
 	void *userdata;
 };
@@ -29,11 +40,43 @@ bool daydream_whip_connect(struct daydream_whip *whip);
 void daydream_whip_disconnect(struct daydream_whip *whip);
 bool daydream_whip_is_connected(struct daydream_whip *whip);
 
-bool daydream_whip_send_frame(struct daydream_whip *whip, const uint8_t *h264_data, size_t size, uint32_t timestamp_ms,
+// One access unit in the negotiated codec, as the encoder produced it
+bool daydream_whip_send_frame(struct daydream_whip *whip, const uint8_t *data, size_t size, uint32_t timestamp_ms,
 			      bool is_keyframe);
 
+// Part of an access unit, as the sliced encoder delivers it. Only the last slice ends the frame: the
+// RTP marker goes on its last packet alone.
+bool daydream_whip_send_slice(struct daydream_whip *whip, const uint8_t *data, size_t size, uint32_t timestamp_ms,
+			      bool is_keyframe, bool last_slice);
+
+// 90 kHz RTP timestamp that daydream_whip_send_frame puts on a frame sent at timestamp_ms
+uint32_t daydream_whip_rtp_timestamp(uint32_t timestamp_ms);
+
 const char *daydream_whip_get_whep_url(struct daydream_whip *whip);
 
+// Codec the gateway accepted in its SDP answer. H.264 if the answer did not pick one of the offered codecs.
+enum daydream_video_codec daydream_whip_get_codec(struct daydream_whip *whip);
+
+// H.264 profile the gateway accepted in its SDP answer. Baseline if the answer
+// did not pick one of the offered profiles.
+enum daydream_h264_profile daydream_whip_get_h264_profile(struct daydream_whip *whip);
+
+// Addresses of our first host and server-reflexive ICE candidates, used to tell networks apart.
+// NULL before connect, or when there was no such candidate (always for the public one without a
+// STUN server).
+const char *daydream_whip_get_local_address(struct daydream_whip *whip);
+const char *daydream_whip_get_public_address(struct daydream_whip *whip);
+
+// Latest RTCP feedback from the gateway on the video track
+struct daydream_whip_feedback {
+	double loss_fraction;  // Fraction lost in the latest receiver report, -1 before the first one
+	uint32_t remb_bitrate; // Latest REMB, 0 if the gateway sent none
+	int32_t rtt_ms;        // From sender/receiver report timing, -1 if unknown
+	uint64_t reports;      // Receiver reports seen so far; unchanged means no new loss sample
+};
+
+bool daydream_whip_get_feedback(struct daydream_whip *whip, struct daydream_whip_feedback *feedback);
+
 // Network statistics for adaptive bitrate
 // Returns RTT in milliseconds, or -1 if not available
 int32_t daydream_whip_get_rtt_ms(struct daydream_whip *whip);
@@ -18,22 +18,65 @@ with this program. If not, see <https://www.gnu.org/licenses/>
 
 #include <obs-module.h>
 #include <plugin-support.h>
+#include <util/threading.h>
 #include "daydream-filter.h"
 #include "daydream-api.h"
+#include "daydream-rtc.h"
+#include "daydream-encoder.h"
+#include "daydream-decoder.h"
 
 OBS_DECLARE_MODULE()
 OBS_MODULE_USE_DEFAULT_LOCALE(PLUGIN_NAME, "en-US")
 
+// Well under the pools' idle timeout, so an idle codec goes within seconds of expiring
+#define TRIM_INTERVAL_MS 10000
+
+static pthread_t trim_thread;
+static os_event_t *trim_stop_event;
+static bool trim_thread_started;
+
+// Lets go of encoders and decoders that have sat in the pools since the last stream stopped. Closing a
+// hardware context can block on the driver, so this stays off OBS's video and render threads.
+static void *trim_thread_func(void *data)
+{
+	UNUSED_PARAMETER(data);
+	os_set_thread_name("daydream-pool-trim");
+
+	while (os_event_timedwait(trim_stop_event, TRIM_INTERVAL_MS) != 0) {
+		daydream_encoder_pool_trim();
+		daydream_decoder_pool_trim();
+	}
+	return NULL;
+}
+
 bool obs_module_load(void)
 {
 	daydream_api_init();
+	daydream_rtc_init();
 	daydream_filter_register();
+	if (os_event_init(&trim_stop_event, OS_EVENT_TYPE_MANUAL) == 0 &&
+	    pthread_create(&trim_thread, NULL, trim_thread_func, NULL) == 0)
+		trim_thread_started = true;
+	else
+		obs_log(LOG_WARNING, "Failed to start the codec pool trim thread; idle codecs are kept until unload");
 	obs_log(LOG_INFO, "plugin loaded successfully (version %s)", PLUGIN_VERSION);
 	return true;
 }
 
 void obs_module_unload(void)
 {
+	if (trim_thread_started) {
+		os_event_signal(trim_stop_event);
+		pthread_join(trim_thread, NULL);
+		trim_thread_started = false;
+	}
+	if (trim_stop_event) {
+		os_event_destroy(trim_stop_event);
+		trim_stop_event = NULL;
+	}
+	daydream_encoder_pool_clear();
+	daydream_decoder_pool_clear();
+	daydream_rtc_cleanup();
 	daydream_api_cleanup();
 	obs_log(LOG_INFO, "plugin unloaded");
 }
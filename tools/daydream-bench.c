@@ -0,0 +1,846 @@
+// Rate-distortion and latency benchmark for encoder configurations. Reference
+// clips are run through daydream_encoder_encode -> daydream_decoder_decode for
+// every combination of the given codecs, presets, profiles, rate-control modes,
+// keyframe settings and bitrates, and per-run quality, size and timing are
+// written as CSV or JSON.
+//
+//   daydream-bench --input clip.mp4 --presets ultrafast,superfast --profiles baseline,high
+//                  --bitrates 300k,500k,1m --rc abr,cbr --format csv --output results.csv
+//   daydream-bench --video-codecs h264,vp9,av1 --rc crf --crf 20,30,40
+//
+// Quality is measured on luma only. The reference luma uses the same BT.601
+// limited-range conversion as the encoder's BGRA->YUV step, so colour
+// conversion does not count against the codec.
+
+#include "daydream-encoder.h"
+#include "daydream-decoder.h"
+#include "daydream-source.h"
+#include <util/base.h>
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Reported for frames that decode bit-exact, where PSNR is infinite
+#define PSNR_IDENTICAL 100.0
+
+#define SSIM_C1 (0.01 * 255 * 0.01 * 255)
+#define SSIM_C2 (0.03 * 255 * 0.03 * 255)
+
+enum bench_format {
+	BENCH_FORMAT_CSV,
+	BENCH_FORMAT_JSON,
+};
+
+struct bench_options {
+	const char **inputs; // Video files; a pattern is used when there are none
+	size_t num_inputs;
+	const char *pattern;
+	const char *codec_name;
+	const char *output;
+	uint32_t size;
+	uint32_t fps;
+	uint32_t frames;
+	enum bench_format format;
+	bool verbose;
+
+	// Matrix dimensions, comma-separated lists
+	const char *video_codecs;
+	const char *presets;
+	const char *profiles;
+	const char *rate_controls;
+	const char *bitrates;
+	const char *qualities;
+	const char *keyints;
+	const char *intra_refresh;
+};
+
+struct bench_clip {
+	char *name;
+	uint8_t **bgra; // Reference frames, size x size BGRA
+	uint8_t **luma; // Their luma planes, for scoring
+	uint32_t count;
+};
+
+struct bench_config {
+	enum daydream_video_codec codec;
+	const char *preset; // NULL = encoder default for the live path
+	enum daydream_h264_profile profile;
+	enum daydream_rate_control rate_control;
+	uint32_t bitrate;
+	uint32_t quality;
+	uint32_t keyint_ms;
+	bool intra_refresh;
+};
+
+struct bench_result {
+	const char *codec_name;
+	enum daydream_h264_profile profile; // As opened, after any fallback
+	uint32_t frames_in;
+	uint32_t frames_decoded;
+	uint32_t keyframes;
+	uint64_t total_bytes;
+	size_t peak_frame_bytes;
+	double psnr_mean;
+	double psnr_min;
+	double ssim_mean;
+	double encode_ms_mean;
+	double encode_ms_p95;
+	double decode_ms_mean;
+	double decode_ms_p95;
+};
+
+static void quiet_log_handler(int level, const char *format, va_list args, void *param)
+{
+	(void)param;
+	if (level > LOG_WARNING)
+		return;
+
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+}
+
+static const char *rate_control_name(enum daydream_rate_control rc)
+{
+	switch (rc) {
+	case DAYDREAM_RC_CBR:
+		return "cbr";
+	case DAYDREAM_RC_QUALITY:
+		return "crf";
+	default:
+		return "abr";
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+/* Metrics                                                                   */
+
+// Same fixed-point BT.601 limited-range luma as swscale's BGRA->YUV420P
+static inline uint8_t bgra_to_luma(const uint8_t *px)
+{
+	return (uint8_t)(((66 * px[2] + 129 * px[1] + 25 * px[0] + 128) >> 8) + 16);
+}
+
+static void extract_luma(const uint8_t *bgra, uint32_t linesize, uint32_t width, uint32_t height, uint8_t *luma)
+{
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t *row = bgra + (size_t)y * linesize;
+		for (uint32_t x = 0; x < width; x++)
+			luma[(size_t)y * width + x] = bgra_to_luma(row + x * 4);
+	}
+}
+
+static double luma_psnr(const uint8_t *ref, const uint8_t *test, uint32_t test_stride, uint32_t width,
+			uint32_t height)
+{
+	uint64_t sse = 0;
+	for (uint32_t y = 0; y < height; y++) {
+		const uint8_t *a = ref + (size_t)y * width;
+		const uint8_t *b = test + (size_t)y * test_stride;
+		for (uint32_t x = 0; x < width; x++) {
+			int d = (int)a[x] - (int)b[x];
+			sse += (uint64_t)(d * d);
+		}
+	}
+
+	if (sse == 0)
+		return PSNR_IDENTICAL;
+	double mse = (double)sse / ((double)width * height);
+	return 10.0 * log10(255.0 * 255.0 / mse);
+}
+
+// Mean SSIM over 8x8 windows on a 4-pixel grid
+static double luma_ssim(const uint8_t *ref, const uint8_t *test, uint32_t test_stride, uint32_t width,
+			uint32_t height)
+{
+	double total = 0.0;
+	uint32_t windows = 0;
+
+	for (uint32_t wy = 0; wy + 8 <= height; wy += 4) {
+		for (uint32_t wx = 0; wx + 8 <= width; wx += 4) {
+			uint32_t sum_a = 0, sum_b = 0;
+			uint64_t sum_aa = 0, sum_bb = 0, sum_ab = 0;
+
+			for (uint32_t y = 0; y < 8; y++) {
+				const uint8_t *a = ref + (size_t)(wy + y) * width + wx;
+				const uint8_t *b = test + (size_t)(wy + y) * test_stride + wx;
+				for (uint32_t x = 0; x < 8; x++) {
+					sum_a += a[x];
+					sum_b += b[x];
+					sum_aa += (uint32_t)a[x] * a[x];
+					sum_bb += (uint32_t)b[x] * b[x];
+					sum_ab += (uint32_t)a[x] * b[x];
+				}
+			}
+
+			double mean_a = sum_a / 64.0;
+			double mean_b = sum_b / 64.0;
+			double var_a = sum_aa / 64.0 - mean_a * mean_a;
+			double var_b = sum_bb / 64.0 - mean_b * mean_b;
+			double cov = sum_ab / 64.0 - mean_a * mean_b;
+
+			total += ((2.0 * mean_a * mean_b + SSIM_C1) * (2.0 * cov + SSIM_C2)) /
+				 ((mean_a * mean_a + mean_b * mean_b + SSIM_C1) * (var_a + var_b + SSIM_C2));
+			windows++;
+		}
+	}
+
+	return windows > 0 ? total / windows : 0.0;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+	double x = *(const double *)a;
+	double y = *(const double *)b;
+	return (x > y) - (x < y);
+}
+
+static void summarize_times(double *samples, uint32_t count, double *mean, double *p95)
+{
+	*mean = 0.0;
+	*p95 = 0.0;
+	if (count == 0)
+		return;
+
+	double total = 0.0;
+	for (uint32_t i = 0; i < count; i++)
+		total += samples[i];
+	qsort(samples, count, sizeof(double), compare_double);
+
+	*mean = total / count;
+	*p95 = samples[(count * 95) / 100];
+}
+
+/* ------------------------------------------------------------------------- */
+/* Runs                                                                      */
+
+static bool run_config(const struct bench_options *opts, const struct bench_clip *clip,
+		       const struct bench_config *cfg, struct bench_result *result)
+{
+	memset(result, 0, sizeof(*result));
+
+	struct daydream_encoder_config encoder_config = {
+		.width = opts->size,
+		.height = opts->size,
+		.fps = opts->fps,
+		.bitrate = cfg->bitrate,
+		.profile = cfg->profile,
+		.codec = cfg->codec,
+		.codec_name = opts->codec_name,
+		.preset = cfg->preset,
+		.rate_control = cfg->rate_control,
+		.quality = cfg->quality,
+		.keyint_ms = cfg->keyint_ms,
+		.intra_refresh = cfg->intra_refresh,
+	};
+	struct daydream_decoder_config decoder_config = {
+		.width = opts->size,
+		.height = opts->size,
+		.codec = cfg->codec,
+	};
+
+	struct daydream_encoder *encoder = daydream_encoder_create(&encoder_config);
+	struct daydream_decoder *decoder = daydream_decoder_create(&decoder_config);
+	if (!encoder || !decoder) {
+		daydream_encoder_destroy(encoder);
+		daydream_decoder_destroy(decoder);
+		return false;
+	}
+
+	result->codec_name = daydream_encoder_get_codec_name(encoder);
+	result->profile = daydream_encoder_get_profile(encoder);
+	result->psnr_min = PSNR_IDENTICAL;
+
+	double *encode_ms = bzalloc(clip->count * sizeof(double));
+	double *decode_ms = bzalloc(clip->count * sizeof(double));
+	uint32_t *pending = bzalloc(clip->count * sizeof(uint32_t)); // Reference index per packet sent to the decoder
+	uint8_t *decoded_luma = bzalloc((size_t)opts->size * opts->size);
+	uint32_t pending_head = 0, pending_tail = 0;
+	uint32_t encoded_frames = 0;
+	double psnr_total = 0.0, ssim_total = 0.0;
+
+	for (uint32_t i = 0; i < clip->count; i++) {
+		struct daydream_encoded_frame encoded;
+		uint64_t encode_start = os_gettime_ns();
+		bool ok = daydream_encoder_encode(encoder, clip->bgra[i], opts->size * 4, &encoded);
+		uint64_t encode_end = os_gettime_ns();
+		result->frames_in++;
+
+		if (!ok || encoded.size == 0)
+			continue;
+
+		encode_ms[encoded_frames++] = (double)(encode_end - encode_start) / 1000000.0;
+		result->total_bytes += encoded.size;
+		if (encoded.size > result->peak_frame_bytes)
+			result->peak_frame_bytes = encoded.size;
+		if (encoded.is_keyframe)
+			result->keyframes++;
+
+		// Encoders may buffer, so the packet is matched to its reference by output order rather than by i
+		pending[pending_tail++] = (uint32_t)(encoded.pts >= 0 && encoded.pts < clip->count ? encoded.pts : i);
+
+		struct daydream_decoded_frame decoded;
+		uint64_t decode_start = os_gettime_ns();
+		ok = daydream_decoder_decode(decoder, encoded.data, encoded.size, &decoded);
+		uint64_t decode_end = os_gettime_ns();
+
+		if (!ok || pending_head == pending_tail)
+			continue;
+
+		decode_ms[result->frames_decoded++] = (double)(decode_end - decode_start) / 1000000.0;
+		uint32_t ref = pending[pending_head++];
+
+		const uint8_t *test = decoded.y_data;
+		uint32_t test_stride = decoded.y_linesize;
+		if (!decoded.is_nv12) {
+			extract_luma(decoded.bgra_data, decoded.bgra_linesize, opts->size, opts->size, decoded_luma);
+			test = decoded_luma;
+			test_stride = opts->size;
+		}
+
+		double psnr = luma_psnr(clip->luma[ref], test, test_stride, opts->size, opts->size);
+		psnr_total += psnr;
+		if (psnr < result->psnr_min)
+			result->psnr_min = psnr;
+		ssim_total += luma_ssim(clip->luma[ref], test, test_stride, opts->size, opts->size);
+	}
+
+	if (result->frames_decoded > 0) {
+		result->psnr_mean = psnr_total / result->frames_decoded;
+		result->ssim_mean = ssim_total / result->frames_decoded;
+	} else {
+		result->psnr_min = 0.0;
+	}
+	summarize_times(encode_ms, encoded_frames, &result->encode_ms_mean, &result->encode_ms_p95);
+	summarize_times(decode_ms, result->frames_decoded, &result->decode_ms_mean, &result->decode_ms_p95);
+
+	bfree(encode_ms);
+	bfree(decode_ms);
+	bfree(pending);
+	bfree(decoded_luma);
+	daydream_decoder_destroy(decoder);
+	daydream_encoder_destroy(encoder);
+	return true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Output                                                                    */
+
+static void write_header(FILE *out, const struct bench_options *opts)
+{
+	if (opts->format == BENCH_FORMAT_JSON) {
+		fprintf(out, "[\n");
+		return;
+	}
+
+	fprintf(out, "clip,video_codec,codec,preset,profile,rc,bitrate,quality,keyint_ms,intra_refresh,frames,decoded,"
+		     "keyframes,kbps,bits_per_frame,peak_frame_bytes,psnr_y,psnr_y_min,ssim_y,encode_ms,encode_ms_p95,"
+		     "decode_ms,decode_ms_p95\n");
+}
+
+static void write_result(FILE *out, const struct bench_options *opts, const struct bench_clip *clip,
+			 const struct bench_config *cfg, const struct bench_result *r, bool first)
+{
+	double bits_per_frame = r->frames_in > 0 ? (double)r->total_bytes * 8.0 / r->frames_in : 0.0;
+	double kbps = bits_per_frame * opts->fps / 1000.0;
+	const char *preset = cfg->preset ? cfg->preset : "default";
+	const char *video_codec = daydream_video_codec_name(cfg->codec);
+	const char *profile = cfg->codec == DAYDREAM_CODEC_H264 ? daydream_h264_profile_name(r->profile) : "-";
+
+	if (opts->format == BENCH_FORMAT_JSON) {
+		fprintf(out,
+			"%s  {\"clip\": \"%s\", \"video_codec\": \"%s\", \"codec\": \"%s\", \"preset\": \"%s\", "
+			"\"profile\": \"%s\", \"rc\": \"%s\", \"bitrate\": %u, \"quality\": %u, \"keyint_ms\": %u, "
+			"\"intra_refresh\": %s, "
+			"\"frames\": %u, \"decoded\": %u, \"keyframes\": %u, \"kbps\": %.1f, \"bits_per_frame\": %.0f, "
+			"\"peak_frame_bytes\": %zu, \"psnr_y\": %.3f, \"psnr_y_min\": %.3f, \"ssim_y\": %.5f, "
+			"\"encode_ms\": %.3f, \"encode_ms_p95\": %.3f, \"decode_ms\": %.3f, \"decode_ms_p95\": %.3f}",
+			first ? "" : ",\n", clip->name, video_codec, r->codec_name, preset, profile,
+			rate_control_name(cfg->rate_control), cfg->bitrate, cfg->quality, cfg->keyint_ms,
+			cfg->intra_refresh ? "true" : "false", r->frames_in, r->frames_decoded, r->keyframes, kbps,
+			bits_per_frame, r->peak_frame_bytes, r->psnr_mean, r->psnr_min, r->ssim_mean, r->encode_ms_mean,
+			r->encode_ms_p95, r->decode_ms_mean, r->decode_ms_p95);
+		return;
+	}
+
+	fprintf(out, "%s,%s,%s,%s,%s,%s,%u,%u,%u,%d,%u,%u,%u,%.1f,%.0f,%zu,%.3f,%.3f,%.5f,%.3f,%.3f,%.3f,%.3f\n",
+		clip->name, video_codec, r->codec_name, preset, profile, rate_control_name(cfg->rate_control),
+		cfg->bitrate, cfg->quality, cfg->keyint_ms, cfg->intra_refresh ? 1 : 0, r->frames_in, r->frames_decoded,
+		r->keyframes, kbps, bits_per_frame, r->peak_frame_bytes, r->psnr_mean, r->psnr_min, r->ssim_mean,
+		r->encode_ms_mean, r->encode_ms_p95, r->decode_ms_mean, r->decode_ms_p95);
+}
+
+static void write_footer(FILE *out, const struct bench_options *opts)
+{
+	if (opts->format == BENCH_FORMAT_JSON)
+		fprintf(out, "\n]\n");
+}
+
+/* ------------------------------------------------------------------------- */
+/* Setup                                                                     */
+
+static void free_clip(struct bench_clip *clip)
+{
+	for (uint32_t i = 0; i < clip->count; i++) {
+		bfree(clip->bgra[i]);
+		bfree(clip->luma[i]);
+	}
+	bfree(clip->bgra);
+	bfree(clip->luma);
+	bfree(clip->name);
+}
+
+static bool load_clip(struct bench_clip *clip, const struct bench_options *opts, const char *path)
+{
+	memset(clip, 0, sizeof(*clip));
+	struct daydream_source *src = daydream_source_create(path, opts->pattern, opts->size, opts->size);
+	if (!src)
+		return false;
+
+	const char *name = path ? path : opts->pattern;
+	const char *slash = strrchr(name, '/');
+	clip->name = bstrdup(slash ? slash + 1 : name);
+	clip->bgra = bzalloc(opts->frames * sizeof(uint8_t *));
+	clip->luma = bzalloc(opts->frames * sizeof(uint8_t *));
+
+	// Decoded up front so every configuration sees identical input and file decoding is not timed
+	size_t frame_size = (size_t)opts->size * opts->size * 4;
+	while (clip->count < opts->frames) {
+		uint32_t linesize = 0;
+		const uint8_t *bgra = daydream_source_next(src, &linesize);
+		if (!bgra)
+			break;
+
+		uint8_t *copy = bmalloc(frame_size);
+		for (uint32_t y = 0; y < opts->size; y++)
+			memcpy(copy + (size_t)y * opts->size * 4, bgra + (size_t)y * linesize, (size_t)opts->size * 4);
+
+		clip->luma[clip->count] = bmalloc((size_t)opts->size * opts->size);
+		extract_luma(copy, opts->size * 4, opts->size, opts->size, clip->luma[clip->count]);
+		clip->bgra[clip->count++] = copy;
+	}
+
+	daydream_source_destroy(src);
+	if (clip->count == 0) {
+		fprintf(stderr, "No frames read from %s\n", clip->name);
+		free_clip(clip);
+		return false;
+	}
+	return true;
+}
+
+// Accepts plain bits per second or a k/m suffix: 500000, 500k, 1.5m
+static bool parse_bitrate(const char *value, uint32_t *out)
+{
+	char *end = NULL;
+	double v = strtod(value, &end);
+	if (end == value || v <= 0.0)
+		return false;
+	if (*end == 'k' || *end == 'K') {
+		v *= 1000.0;
+		end++;
+	} else if (*end == 'm' || *end == 'M') {
+		v *= 1000000.0;
+		end++;
+	}
+	if (*end)
+		return false;
+
+	*out = (uint32_t)v;
+	return true;
+}
+
+static bool parse_uint(const char *value, uint32_t *out)
+{
+	char *end = NULL;
+	unsigned long v = strtoul(value, &end, 10);
+	if (!*value || *end)
+		return false;
+	*out = (uint32_t)v;
+	return true;
+}
+
+static bool parse_profile(const char *value, enum daydream_h264_profile *out)
+{
+	if (strcmp(value, "baseline") == 0)
+		*out = DAYDREAM_H264_BASELINE;
+	else if (strcmp(value, "main") == 0)
+		*out = DAYDREAM_H264_MAIN;
+	else if (strcmp(value, "high") == 0)
+		*out = DAYDREAM_H264_HIGH;
+	else
+		return false;
+	return true;
+}
+
+static bool parse_rate_control(const char *value, enum daydream_rate_control *out)
+{
+	if (strcmp(value, "abr") == 0)
+		*out = DAYDREAM_RC_CAPPED_ABR;
+	else if (strcmp(value, "cbr") == 0)
+		*out = DAYDREAM_RC_CBR;
+	else if (strcmp(value, "crf") == 0)
+		*out = DAYDREAM_RC_QUALITY;
+	else
+		return false;
+	return true;
+}
+
+static bool parse_switch(const char *value, bool *out)
+{
+	if (strcmp(value, "on") == 0 || strcmp(value, "1") == 0)
+		*out = true;
+	else if (strcmp(value, "off") == 0 || strcmp(value, "0") == 0)
+		*out = false;
+	else
+		return false;
+	return true;
+}
+
+static size_t list_length(char **list)
+{
+	size_t n = 0;
+	while (list && list[n])
+		n++;
+	return n;
+}
+
+// Expands the dimension lists into every combination, codec outermost. Constant
+// quality sweeps the quality list in place of the bitrate list. Profiles are H.264
+// only, so other codecs run once, under the first profile.
+static struct bench_config *build_matrix(char **video_codecs, char **presets, char **profiles, char **rate_controls,
+					 char **bitrates, char **qualities, char **keyints, char **intra_refresh,
+					 size_t *count)
+{
+	size_t num_codecs = list_length(video_codecs);
+	size_t num_presets = list_length(presets);
+	size_t num_profiles = list_length(profiles);
+	size_t num_rcs = list_length(rate_controls);
+	size_t num_keyints = list_length(keyints);
+	size_t num_ir = list_length(intra_refresh);
+	size_t combos = num_codecs * num_presets * num_profiles * num_rcs * num_keyints * num_ir;
+	size_t max_points = list_length(bitrates) > list_length(qualities) ? list_length(bitrates)
+									   : list_length(qualities);
+
+	struct bench_config *configs = bzalloc(combos * max_points * sizeof(struct bench_config));
+	size_t n = 0;
+
+	for (size_t c = 0; c < combos; c++) {
+		size_t idx = c;
+		size_t ir = idx % num_ir;
+		idx /= num_ir;
+		size_t k = idx % num_keyints;
+		idx /= num_keyints;
+		size_t rc = idx % num_rcs;
+		idx /= num_rcs;
+		size_t pf = idx % num_profiles;
+		idx /= num_profiles;
+		size_t pr = idx % num_presets;
+		size_t vc = idx / num_presets;
+
+		struct bench_config cfg = {
+			.preset = strcmp(presets[pr], "default") == 0 ? NULL : presets[pr],
+		};
+		daydream_video_codec_parse(video_codecs[vc], &cfg.codec);
+		if (cfg.codec != DAYDREAM_CODEC_H264 && pf > 0)
+			continue;
+		parse_profile(profiles[pf], &cfg.profile);
+		parse_rate_control(rate_controls[rc], &cfg.rate_control);
+		parse_uint(keyints[k], &cfg.keyint_ms);
+		parse_switch(intra_refresh[ir], &cfg.intra_refresh);
+
+		bool by_quality = cfg.rate_control == DAYDREAM_RC_QUALITY;
+		char **points = by_quality ? qualities : bitrates;
+		for (size_t p = 0; points[p]; p++) {
+			if (by_quality)
+				parse_uint(points[p], &cfg.quality);
+			else
+				parse_bitrate(points[p], &cfg.bitrate);
+			configs[n++] = cfg;
+		}
+	}
+
+	*count = n;
+	return configs;
+}
+
+// Splits every dimension up front so bad values are reported before any encoding starts
+static bool validate_list(const char *option, char **list, bool (*check)(const char *))
+{
+	if (list_length(list) == 0) {
+		fprintf(stderr, "%s needs at least one value\n", option);
+		return false;
+	}
+	for (size_t i = 0; list[i]; i++) {
+		if (!check(list[i])) {
+			fprintf(stderr, "Invalid value for %s: %s\n", option, list[i]);
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool check_bitrate(const char *v)
+{
+	uint32_t x;
+	return parse_bitrate(v, &x);
+}
+
+static bool check_uint(const char *v)
+{
+	uint32_t x;
+	return parse_uint(v, &x);
+}
+
+static bool check_video_codec(const char *v)
+{
+	enum daydream_video_codec x;
+	return daydream_video_codec_parse(v, &x);
+}
+
+static bool check_profile(const char *v)
+{
+	enum daydream_h264_profile x;
+	return parse_profile(v, &x);
+}
+
+static bool check_rate_control(const char *v)
+{
+	enum daydream_rate_control x;
+	return parse_rate_control(v, &x);
+}
+
+static bool check_switch(const char *v)
+{
+	bool x;
+	return parse_switch(v, &x);
+}
+
+static bool check_any(const char *v)
+{
+	return *v != '\0';
+}
+
+static void print_usage(const char *argv0)
+{
+	printf("Usage: %s [options]\n"
+	       "\n"
+	       "Input:\n"
+	       "  --input FILE          Reference clip (repeatable); defaults to a pattern\n"
+	       "  --pattern NAME        bars (default), gradient, noise\n"
+	       "  --frames N            Frames per clip (default: 150)\n"
+	       "  --size N              Width and height (default: 512)\n"
+	       "  --fps N               Frame rate (default: 30)\n"
+	       "\n"
+	       "Matrix (comma-separated lists):\n"
+	       "  --video-codecs LIST   h264, vp8, vp9, av1 (default: h264)\n"
+	       "  --codec NAME          FFmpeg encoder, e.g. libx264 (default: best available)\n"
+	       "  --presets LIST        Encoder presets; \"default\" keeps the live-path setting (default: default)\n"
+	       "  --profiles LIST       baseline, main, high; H.264 only (default: baseline)\n"
+	       "  --rc LIST             abr, cbr, crf (default: abr)\n"
+	       "  --bitrates LIST       For abr/cbr, e.g. 300k,500k,1m (default: 500k)\n"
+	       "  --crf LIST            Quality values for crf (default: 23)\n"
+	       "  --keyint LIST         Keyframe interval in ms (default: 500)\n"
+	       "  --intra-refresh LIST  off, on (default: off)\n"
+	       "\n"
+	       "Output:\n"
+	       "  --format csv|json     (default: csv)\n"
+	       "  --output FILE         Write results to FILE instead of stdout\n"
+	       "  --verbose             Show encoder and decoder log output\n",
+	       argv0);
+}
+
+static bool parse_args(int argc, char **argv, struct bench_options *opts)
+{
+	opts->pattern = "bars";
+	opts->size = 512;
+	opts->fps = 30;
+	opts->frames = 150;
+	opts->format = BENCH_FORMAT_CSV;
+	opts->video_codecs = "h264";
+	opts->presets = "default";
+	opts->profiles = "baseline";
+	opts->rate_controls = "abr";
+	opts->bitrates = "500k";
+	opts->qualities = "23";
+	opts->keyints = "500";
+	opts->intra_refresh = "off";
+	opts->inputs = bzalloc(argc * sizeof(const char *));
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		bool ok = true;
+
+		if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+			print_usage(argv[0]);
+			exit(0);
+		} else if (strcmp(arg, "--verbose") == 0) {
+			opts->verbose = true;
+			continue;
+		}
+
+		if (!value) {
+			fprintf(stderr, "Missing value for %s\n", arg);
+			return false;
+		}
+
+		if (strcmp(arg, "--input") == 0)
+			opts->inputs[opts->num_inputs++] = value;
+		else if (strcmp(arg, "--pattern") == 0)
+			opts->pattern = value;
+		else if (strcmp(arg, "--codec") == 0)
+			opts->codec_name = value;
+		else if (strcmp(arg, "--output") == 0)
+			opts->output = value;
+		else if (strcmp(arg, "--frames") == 0)
+			ok = parse_uint(value, &opts->frames);
+		else if (strcmp(arg, "--size") == 0)
+			ok = parse_uint(value, &opts->size);
+		else if (strcmp(arg, "--fps") == 0)
+			ok = parse_uint(value, &opts->fps);
+		else if (strcmp(arg, "--video-codecs") == 0)
+			opts->video_codecs = value;
+		else if (strcmp(arg, "--presets") == 0)
+			opts->presets = value;
+		else if (strcmp(arg, "--profiles") == 0)
+			opts->profiles = value;
+		else if (strcmp(arg, "--rc") == 0)
+			opts->rate_controls = value;
+		else if (strcmp(arg, "--bitrates") == 0)
+			opts->bitrates = value;
+		else if (strcmp(arg, "--crf") == 0)
+			opts->qualities = value;
+		else if (strcmp(arg, "--keyint") == 0)
+			opts->keyints = value;
+		else if (strcmp(arg, "--intra-refresh") == 0)
+			opts->intra_refresh = value;
+		else if (strcmp(arg, "--format") == 0) {
+			if (strcmp(value, "csv") == 0)
+				opts->format = BENCH_FORMAT_CSV;
+			else if (strcmp(value, "json") == 0)
+				opts->format = BENCH_FORMAT_JSON;
+			else
+				ok = false;
+		} else {
+			fprintf(stderr, "Unknown option: %s\n", arg);
+			return false;
+		}
+
+		if (!ok) {
+			fprintf(stderr, "Invalid value for %s: %s\n", arg, value);
+			return false;
+		}
+		i++;
+	}
+
+	if (opts->size < 64 || opts->size % 2 != 0 || opts->fps == 0 || opts->frames == 0) {
+		fprintf(stderr, "Size must be an even number >= 64; fps and frames must be positive\n");
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	struct bench_options opts = {0};
+	if (!parse_args(argc, argv, &opts)) {
+		print_usage(argv[0]);
+		bfree(opts.inputs);
+		return 1;
+	}
+
+	if (!opts.verbose)
+		base_set_log_handler(quiet_log_handler, NULL);
+
+	char **video_codecs = strlist_split(opts.video_codecs, ',', false);
+	char **presets = strlist_split(opts.presets, ',', false);
+	char **profiles = strlist_split(opts.profiles, ',', false);
+	char **rate_controls = strlist_split(opts.rate_controls, ',', false);
+	char **bitrates = strlist_split(opts.bitrates, ',', false);
+	char **qualities = strlist_split(opts.qualities, ',', false);
+	char **keyints = strlist_split(opts.keyints, ',', false);
+	char **intra_refresh = strlist_split(opts.intra_refresh, ',', false);
+
+	int exit_code = 1;
+	size_t num_clips = opts.num_inputs > 0 ? opts.num_inputs : 1;
+	struct bench_clip *clips = bzalloc(num_clips * sizeof(struct bench_clip));
+	size_t loaded = 0;
+	FILE *out = stdout;
+
+	if (!validate_list("--video-codecs", video_codecs, check_video_codec) ||
+	    !validate_list("--presets", presets, check_any) || !validate_list("--profiles", profiles, check_profile) ||
+	    !validate_list("--rc", rate_controls, check_rate_control) ||
+	    !validate_list("--bitrates", bitrates, check_bitrate) || !validate_list("--crf", qualities, check_uint) ||
+	    !validate_list("--keyint", keyints, check_uint) ||
+	    !validate_list("--intra-refresh", intra_refresh, check_switch))
+		goto cleanup;
+
+	for (; loaded < num_clips; loaded++) {
+		const char *path = opts.num_inputs > 0 ? opts.inputs[loaded] : NULL;
+		if (!load_clip(&clips[loaded], &opts, path))
+			goto cleanup;
+	}
+
+	if (opts.output) {
+		out = fopen(opts.output, "w");
+		if (!out) {
+			fprintf(stderr, "Could not open %s for writing\n", opts.output);
+			out = stdout;
+			goto cleanup;
+		}
+	}
+
+	size_t num_configs = 0;
+	struct bench_config *configs = build_matrix(video_codecs, presets, profiles, rate_controls, bitrates, qualities,
+						    keyints, intra_refresh, &num_configs);
+	size_t failures = 0;
+	bool first = true;
+
+	write_header(out, &opts);
+	for (size_t c = 0; c < num_clips; c++) {
+		for (size_t i = 0; i < num_configs; i++) {
+			const struct bench_config *cfg = &configs[i];
+			struct bench_result result;
+
+			fprintf(stderr, "[%zu/%zu] %s\n", c * num_configs + i + 1, num_clips * num_configs,
+				clips[c].name);
+			if (!run_config(&opts, &clips[c], cfg, &result)) {
+				fprintf(stderr, "Encoder rejected %s preset %s, %s, %s, skipped\n",
+					daydream_video_codec_name(cfg->codec), cfg->preset ? cfg->preset : "default",
+					daydream_h264_profile_name(cfg->profile), rate_control_name(cfg->rate_control));
+				failures++;
+				continue;
+			}
+
+			write_result(out, &opts, &clips[c], cfg, &result, first);
+			first = false;
+			fflush(out);
+		}
+	}
+	write_footer(out, &opts);
+	fprintf(stderr, "%zu runs, %zu failed\n", num_clips * num_configs, failures);
+	exit_code = failures < num_clips * num_configs ? 0 : 1;
+	bfree(configs);
+
+cleanup:
+	if (out != stdout)
+		fclose(out);
+	for (size_t i = 0; i < loaded; i++)
+		free_clip(&clips[i]);
+	bfree(clips);
+	strlist_free(video_codecs);
+	strlist_free(presets);
+	strlist_free(profiles);
+	strlist_free(rate_controls);
+	strlist_free(bitrates);
+	strlist_free(qualities);
+	strlist_free(keyints);
+	strlist_free(intra_refresh);
+	bfree(opts.inputs);
+	return exit_code;
+}
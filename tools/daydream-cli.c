@@ -0,0 +1,1205 @@
+// Headless pipeline runner: streams a video file or a synthetic pattern through
+// a Daydream stream (or a local loopback) and writes the returned frames to a
+// file, reporting per-stage latency and throughput.
+//
+//   daydream-cli --pattern bars --frames 600 --output out.mkv
+//   daydream-cli --input clip.mp4 --prompt "oil painting" --max-rate --output styled.mp4
+//   daydream-cli --pattern noise --loopback --max-rate
+//   daydream-cli --pattern bars --loopback --video-codec vp9 --output vp9.mkv
+//   daydream-cli --pattern noise --loopback --soak 24
+//   daydream-cli --pattern noise --loopback --sim-clock --link-kbps 800 --frames 9000
+//   daydream-cli --probe 120,15,off,60
+
+#include "daydream-api.h"
+#include "daydream-encoder.h"
+#include "daydream-decoder.h"
+#include "daydream-whip.h"
+#include "daydream-whep.h"
+#include "daydream-recorder.h"
+#include "daydream-clock.h"
+#include "daydream-rate-control.h"
+#include "daydream-rtc.h"
+#include "daydream-rtp.h"
+#include "daydream-probe.h"
+#include "daydream-source.h"
+#include "daydream-endpoints.h"
+#include <util/base.h>
+#include <util/bmem.h>
+#include <util/dstr.h>
+#include <util/threading.h>
+#include <util/platform.h>
+
+#include <math.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Frames in flight between send and return; well above any observed round trip
+#define PENDING_RING_SIZE 512
+
+// Percentiles are computed over at most this many samples per stage
+#define STATS_MAX_SAMPLES 65536
+
+// Simulated link: queue depth before frames are dropped, and the smallest target change passed to the encoder
+#define LINK_BUFFER_MS 250
+#define LINK_MIN_CHANGE 0.05
+
+// Sent frames older than this without a return are counted as lost rather than queued
+#define IN_FLIGHT_MAX_AGE_NS (5 * 1000000000ULL)
+
+// Endpoints probed at once and the handshake timeout, as in the filter
+#define PROBE_MAX_ENDPOINTS 8
+#define PROBE_TIMEOUT_MS 1000
+
+struct cli_options {
+	const char *input;   // Video file, or NULL to use a pattern
+	const char *pattern; // "bars", "gradient" or "noise"
+	const char *output;  // Returned stream, written without re-encoding
+	const char *api_key;
+	const char *model;
+	const char *prompt;
+	const char *video_codec; // "auto" or the codec to offer first
+	uint32_t size;
+	uint32_t fps;
+	uint32_t bitrate;
+	uint32_t frames; // 0 = until the input ends
+	uint32_t drain_ms;
+	bool max_rate;
+	bool loopback;
+	bool sliced; // x264 slices sent as they finish (ENABLE_X264_DIRECT builds)
+	bool quiet;
+
+	// Loopback only. The simulated clock makes paced runs take as long as encoding and decoding do, with
+	// the same pacing code the filter uses. A link rate drops frames that exceed it and lets the plugin's
+	// rate controller adapt the encoder to it.
+	bool sim_clock;
+	uint32_t link_kbps; // 0 = unlimited
+
+	// Soak: run for this much stream time, sampling every soak_interval_min, and fail on growth from the
+	// first sample beyond the limits. Over loopback it runs at max rate, so a day of stream takes as long
+	// as encoding and decoding it does.
+	double soak_hours; // 0 = off
+	uint32_t soak_interval_min;
+	uint32_t soak_max_rss_mb;
+	uint32_t soak_max_allocs;
+	uint32_t soak_max_drift_ms;
+
+	// Probe: local HTTPS endpoints holding each handshake for these delays, the first standing in for the
+	// URL the API returns and the rest for alternative hosts. The run checks that the filter's selection
+	// picks the fastest and then exits.
+	uint32_t probe_delays_ms[PROBE_MAX_ENDPOINTS];
+	size_t probe_count; // 0 = off
+	uint32_t probe_timeout_ms;
+};
+
+struct stage_stats {
+	const char *name;
+	uint64_t count;
+	uint64_t total_ns;
+	uint64_t max_ns;
+	uint32_t *samples_us;
+	size_t num_samples;
+};
+
+struct soak_sample {
+	uint64_t stream_ms;
+	uint64_t rss_bytes;
+	long allocs;        // Live libobs allocations
+	uint32_t in_flight; // Sent, not yet returned, and not old enough to count as lost
+	uint64_t unmatched;
+	double latency_ms; // Mean end-to-end over the interval, negative if nothing returned
+	double latency_max_ms;
+};
+
+struct pending_frame {
+	uint32_t rtp_timestamp;
+	uint64_t capture_ns;
+	uint64_t sent_ns;
+	bool in_use;
+};
+
+struct cli_context {
+	struct cli_options opts;
+
+	struct daydream_encoder *encoder;
+	struct daydream_decoder *decoder;
+	struct daydream_recorder *recorder;
+	struct daydream_whip *whip;
+	struct daydream_whep *whep;
+	struct daydream_rtp_loopback *loopback;
+
+	pthread_t whep_thread;
+	bool whep_thread_started;
+
+	pthread_mutex_t mutex;
+	struct pending_frame pending[PENDING_RING_SIZE];
+	uint32_t pending_next; // Send sequence; slots are filled in send order
+	struct stage_stats read_stats;
+	struct stage_stats encode_stats;
+	struct stage_stats return_stats;
+	struct stage_stats decode_stats;
+	struct stage_stats total_stats;
+
+	uint64_t sent_frames;
+	uint64_t sent_bytes;
+	uint64_t received_frames;
+	uint64_t received_bytes;
+	uint64_t unmatched_frames;
+	uint64_t first_send_ns;
+	uint64_t last_send_ns;
+	uint64_t first_receive_ns;
+	uint64_t last_receive_ns;
+
+	// Frame being sent slice by slice, set before each encode
+	uint32_t slice_timestamp_ms;
+	uint64_t slice_capture_ns;
+	bool slice_first_sent;
+
+	// End-to-end latency since the last soak sample
+	uint64_t interval_latency_ns;
+	uint64_t interval_latency_max_ns;
+	uint64_t interval_returned;
+	struct soak_sample soak_first;
+	struct soak_sample soak_last;
+	uint64_t soak_samples;
+
+	struct daydream_sim_clock *sim_clock;
+
+	// Simulated link, fed back to the rate controller once a second of stream time
+	struct daydream_rate_controller *rate_ctl;
+	double link_bits; // Token bucket
+	uint64_t link_last_ns;
+	uint64_t link_window_start_ns;
+	uint32_t link_window_frames;
+	uint32_t link_window_lost;
+	uint64_t link_lost_frames;
+	uint32_t link_bitrate; // Current encoder target
+};
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int sig)
+{
+	(void)sig;
+	stop_requested = 1;
+}
+
+static void quiet_log_handler(int level, const char *format, va_list args, void *param)
+{
+	(void)param;
+	if (level > LOG_WARNING)
+		return;
+
+	vfprintf(stderr, format, args);
+	fputc('\n', stderr);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Statistics                                                                */
+
+static void stats_init(struct stage_stats *stats, const char *name)
+{
+	memset(stats, 0, sizeof(*stats));
+	stats->name = name;
+	stats->samples_us = bzalloc(STATS_MAX_SAMPLES * sizeof(uint32_t));
+}
+
+static void stats_free(struct stage_stats *stats)
+{
+	bfree(stats->samples_us);
+	stats->samples_us = NULL;
+}
+
+static void stats_add(struct stage_stats *stats, uint64_t ns)
+{
+	stats->count++;
+	stats->total_ns += ns;
+	if (ns > stats->max_ns)
+		stats->max_ns = ns;
+	if (stats->num_samples < STATS_MAX_SAMPLES)
+		stats->samples_us[stats->num_samples++] = (uint32_t)(ns / 1000);
+}
+
+static int compare_u32(const void *a, const void *b)
+{
+	uint32_t x = *(const uint32_t *)a;
+	uint32_t y = *(const uint32_t *)b;
+	return (x > y) - (x < y);
+}
+
+static void stats_print(struct stage_stats *stats)
+{
+	if (stats->count == 0) {
+		printf("  %-18s %8s\n", stats->name, "-");
+		return;
+	}
+
+	qsort(stats->samples_us, stats->num_samples, sizeof(uint32_t), compare_u32);
+	double p50 = stats->samples_us[stats->num_samples / 2] / 1000.0;
+	double p95 = stats->samples_us[(stats->num_samples * 95) / 100] / 1000.0;
+	double mean = (double)stats->total_ns / (double)stats->count / 1000000.0;
+
+	printf("  %-18s %8llu %9.2f %9.2f %9.2f %9.2f\n", stats->name, (unsigned long long)stats->count, mean, p50,
+	       p95, (double)stats->max_ns / 1000000.0);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Return path                                                               */
+
+static void remember_sent(struct cli_context *ctx, uint32_t rtp_timestamp, uint64_t capture_ns, uint64_t sent_ns)
+{
+	pthread_mutex_lock(&ctx->mutex);
+	// Keyed by send order: RTP timestamps step by 90000 / fps, which shares factors with the ring size and
+	// would leave most slots unused
+	struct pending_frame *slot = &ctx->pending[ctx->pending_next++ % PENDING_RING_SIZE];
+	slot->rtp_timestamp = rtp_timestamp;
+	slot->capture_ns = capture_ns;
+	slot->sent_ns = sent_ns;
+	slot->in_use = true;
+	pthread_mutex_unlock(&ctx->mutex);
+}
+
+// The decoder and recorder are set up before the WHEP answer arrives; switch both if it picked another codec
+static void match_whep_codec(struct cli_context *ctx)
+{
+	enum daydream_video_codec codec = daydream_whep_get_codec(ctx->whep);
+	if (codec == daydream_decoder_get_codec(ctx->decoder))
+		return;
+
+	fprintf(stderr, "Returned stream is %s, switching from %s\n", daydream_video_codec_name(codec),
+		daydream_video_codec_name(daydream_decoder_get_codec(ctx->decoder)));
+
+	struct daydream_decoder_config decoder_config = {
+		.width = ctx->opts.size,
+		.height = ctx->opts.size,
+		.codec = codec,
+	};
+	struct daydream_decoder *decoder = daydream_decoder_create(&decoder_config);
+	if (decoder) {
+		daydream_decoder_destroy(ctx->decoder);
+		ctx->decoder = decoder;
+	}
+
+	if (!ctx->recorder)
+		return;
+	struct daydream_recorder_config recorder_config = {
+		.path = ctx->opts.output,
+		.width = ctx->opts.size,
+		.height = ctx->opts.size,
+		.codec = codec,
+	};
+	pthread_mutex_lock(&ctx->mutex);
+	daydream_recorder_destroy(ctx->recorder);
+	ctx->recorder = daydream_recorder_create(&recorder_config);
+	pthread_mutex_unlock(&ctx->mutex);
+	if (!ctx->recorder)
+		fprintf(stderr, "Could not reopen %s for %s\n", ctx->opts.output, daydream_video_codec_name(codec));
+}
+
+// Handles one returned access unit: match it to the sent frame, record it and decode it.
+// Called from the WHEP track thread, or inline in loopback mode.
+static void on_returned_frame(const uint8_t *data, size_t size, uint32_t timestamp, bool is_keyframe, void *userdata)
+{
+	(void)is_keyframe;
+	struct cli_context *ctx = userdata;
+	uint64_t arrival_ns = daydream_clock_now_ns();
+
+	if (ctx->whep)
+		match_whep_codec(ctx);
+
+	pthread_mutex_lock(&ctx->mutex);
+
+	// Newest first: over loopback the frame just sent comes straight back
+	struct pending_frame *slot = NULL;
+	for (uint32_t n = 1; n <= PENDING_RING_SIZE && !slot; n++) {
+		struct pending_frame *candidate = &ctx->pending[(ctx->pending_next - n) % PENDING_RING_SIZE];
+		if (candidate->in_use && candidate->rtp_timestamp == timestamp)
+			slot = candidate;
+	}
+	bool matched = slot != NULL;
+	uint64_t capture_ns = matched ? slot->capture_ns : 0;
+	if (matched) {
+		stats_add(&ctx->return_stats, arrival_ns - slot->sent_ns);
+		slot->in_use = false;
+	} else {
+		ctx->unmatched_frames++;
+	}
+
+	if (ctx->received_frames == 0)
+		ctx->first_receive_ns = arrival_ns;
+	ctx->last_receive_ns = arrival_ns;
+	ctx->received_frames++;
+	ctx->received_bytes += size;
+
+	if (ctx->recorder)
+		daydream_recorder_write(ctx->recorder, data, size, timestamp);
+
+	pthread_mutex_unlock(&ctx->mutex);
+
+	// Decoding runs outside the lock so a slow decode does not stall the send loop
+	struct daydream_decoded_frame decoded;
+	uint64_t decode_start = daydream_clock_now_ns();
+	bool ok = daydream_decoder_decode(ctx->decoder, data, size, &decoded);
+	uint64_t decode_end = daydream_clock_now_ns();
+
+	pthread_mutex_lock(&ctx->mutex);
+	if (ok) {
+		stats_add(&ctx->decode_stats, decode_end - decode_start);
+		if (matched) {
+			uint64_t latency_ns = decode_end - capture_ns;
+			stats_add(&ctx->total_stats, latency_ns);
+			ctx->interval_latency_ns += latency_ns;
+			if (latency_ns > ctx->interval_latency_max_ns)
+				ctx->interval_latency_max_ns = latency_ns;
+			ctx->interval_returned++;
+		}
+	}
+	pthread_mutex_unlock(&ctx->mutex);
+}
+
+static void on_loopback_frame(const uint8_t *data, size_t size, uint32_t timestamp, void *userdata)
+{
+	on_returned_frame(data, size, timestamp, false, userdata);
+}
+
+static void on_connection_state(bool connected, const char *error, void *userdata)
+{
+	(void)userdata;
+	if (!connected && error)
+		fprintf(stderr, "Connection error: %s\n", error);
+}
+
+static void *whep_connect_thread(void *data)
+{
+	struct cli_context *ctx = data;
+
+	// The gateway only publishes output once input is flowing, so this retries while frames are sent
+	if (!daydream_whep_connect(ctx->whep))
+		fprintf(stderr, "WHEP connection failed; no frames will be returned\n");
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Session setup                                                             */
+
+static bool connect_stream(struct cli_context *ctx, const enum daydream_video_codec *codecs, size_t codec_count)
+{
+	const struct cli_options *opts = &ctx->opts;
+
+	struct daydream_stream_params params = {
+		.model_id = opts->model,
+		.negative_prompt = "blurry, low quality, flat, 2d",
+		.guidance = 1.0f,
+		.delta = 0.7f,
+		.num_inference_steps = 50,
+		.width = (int)opts->size,
+		.height = (int)opts->size,
+		.do_add_noise = true,
+		.prompt_interpolation_method = "slerp",
+		.normalize_prompt_weights = true,
+		.seed_interpolation_method = "slerp",
+		.normalize_seed_weights = true,
+	};
+	params.prompt_schedule.count = 1;
+	params.prompt_schedule.prompts[0] = opts->prompt;
+	params.prompt_schedule.weights[0] = 1.0f;
+	params.seed_schedule.count = 1;
+	params.seed_schedule.seeds[0] = 42;
+	params.seed_schedule.weights[0] = 1.0f;
+	params.step_schedule.count = 1;
+	params.step_schedule.steps[0] = 11;
+
+	struct daydream_stream_result result = daydream_api_create_stream(opts->api_key, &params);
+	if (!result.success) {
+		fprintf(stderr, "Failed to create stream: %s\n", result.error ? result.error : "unknown error");
+		daydream_api_free_result(&result);
+		return false;
+	}
+	printf("Stream %s created\n", result.stream_id);
+
+	struct daydream_whip_config whip_config = {
+		.whip_url = result.whip_url,
+		.api_key = opts->api_key,
+		.width = opts->size,
+		.height = opts->size,
+		.fps = opts->fps,
+		.codecs = codecs,
+		.codec_count = codec_count,
+		.on_state = on_connection_state,
+		.userdata = ctx,
+	};
+	ctx->whip = daydream_whip_create(&whip_config);
+	daydream_api_free_result(&result);
+
+	if (!ctx->whip || !daydream_whip_connect(ctx->whip)) {
+		fprintf(stderr, "WHIP connection failed\n");
+		return false;
+	}
+
+	const char *whep_url = daydream_whip_get_whep_url(ctx->whip);
+	if (!whep_url || !*whep_url) {
+		fprintf(stderr, "Gateway did not return a playback URL\n");
+		return false;
+	}
+
+	struct daydream_whep_config whep_config = {
+		.whep_url = whep_url,
+		.codecs = codecs,
+		.codec_count = codec_count,
+		.on_frame = on_returned_frame,
+		.on_state = on_connection_state,
+		.userdata = ctx,
+	};
+	ctx->whep = daydream_whep_create(&whep_config);
+	if (!ctx->whep)
+		return false;
+
+	ctx->whep_thread_started = pthread_create(&ctx->whep_thread, NULL, whep_connect_thread, ctx) == 0;
+	return ctx->whep_thread_started;
+}
+
+static void disconnect_stream(struct cli_context *ctx)
+{
+	if (ctx->whep)
+		daydream_whep_disconnect(ctx->whep);
+	if (ctx->whep_thread_started)
+		pthread_join(ctx->whep_thread, NULL);
+	daydream_whep_destroy(ctx->whep);
+	daydream_whip_destroy(ctx->whip);
+	ctx->whep = NULL;
+	ctx->whip = NULL;
+}
+
+// Sends each slice as soon as it is encoded; the frame is remembered at the first one, since over loopback it
+// comes back within the last slice's send
+static void on_encoded_slice(const uint8_t *data, size_t size, bool is_keyframe, bool last_slice, void *userdata)
+{
+	struct cli_context *ctx = userdata;
+	if (!ctx->slice_first_sent) {
+		ctx->slice_first_sent = true;
+		remember_sent(ctx, daydream_whip_rtp_timestamp(ctx->slice_timestamp_ms), ctx->slice_capture_ns,
+			      daydream_clock_now_ns());
+	}
+
+	if (ctx->whip)
+		daydream_whip_send_slice(ctx->whip, data, size, ctx->slice_timestamp_ms, is_keyframe, last_slice);
+	else
+		daydream_rtp_loopback_send_slice(ctx->loopback, data, size, ctx->slice_timestamp_ms, last_slice);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Simulated link                                                            */
+
+// Frames that do not fit the link's buffer are lost whole, as a bottleneck queue would drop their packets
+static bool link_admit(struct cli_context *ctx, size_t size, uint64_t now_ns)
+{
+	if (!ctx->rate_ctl)
+		return true;
+
+	double rate_bps = (double)ctx->opts.link_kbps * 1000.0;
+	double buffer_bits = rate_bps * LINK_BUFFER_MS / 1000.0;
+	if (ctx->link_last_ns == 0)
+		ctx->link_bits = buffer_bits;
+	else
+		ctx->link_bits += rate_bps * (double)(now_ns - ctx->link_last_ns) / 1e9;
+	if (ctx->link_bits > buffer_bits)
+		ctx->link_bits = buffer_bits;
+	ctx->link_last_ns = now_ns;
+
+	ctx->link_window_frames++;
+	double bits = (double)size * 8.0;
+	if (bits > ctx->link_bits) {
+		ctx->link_window_lost++;
+		ctx->link_lost_frames++;
+		return false;
+	}
+	ctx->link_bits -= bits;
+	return true;
+}
+
+// Stands in for the receiver reports: the lost fraction of the last second goes to the rate controller
+static void link_feedback(struct cli_context *ctx, uint64_t now_ns)
+{
+	if (!ctx->rate_ctl)
+		return;
+	if (ctx->link_window_start_ns == 0)
+		ctx->link_window_start_ns = now_ns;
+	if (now_ns - ctx->link_window_start_ns < 1000000000ULL)
+		return;
+
+	double loss = ctx->link_window_frames > 0 ? (double)ctx->link_window_lost / ctx->link_window_frames : -1.0;
+	uint32_t target = daydream_rate_controller_update(ctx->rate_ctl, loss, 0, now_ns);
+	ctx->link_window_start_ns = now_ns;
+	ctx->link_window_frames = 0;
+	ctx->link_window_lost = 0;
+
+	double current = ctx->link_bitrate > 0 ? (double)ctx->link_bitrate : 1.0;
+	if (fabs((double)target - current) / current < LINK_MIN_CHANGE)
+		return;
+	if (daydream_encoder_set_bitrate(ctx->encoder, target))
+		ctx->link_bitrate = target;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Soak                                                                      */
+
+static void soak_sample(struct cli_context *ctx, uint64_t frames)
+{
+	struct soak_sample sample = {
+		.stream_ms = frames * 1000 / ctx->opts.fps,
+		.rss_bytes = os_get_proc_resident_size(),
+		.allocs = bnum_allocs(),
+		.latency_ms = -1.0,
+		.latency_max_ms = -1.0,
+	};
+
+	uint64_t now = daydream_clock_now_ns();
+	pthread_mutex_lock(&ctx->mutex);
+	for (size_t i = 0; i < PENDING_RING_SIZE; i++) {
+		const struct pending_frame *slot = &ctx->pending[i];
+		if (slot->in_use && now - slot->sent_ns < IN_FLIGHT_MAX_AGE_NS)
+			sample.in_flight++;
+	}
+	sample.unmatched = ctx->unmatched_frames;
+	if (ctx->interval_returned > 0) {
+		sample.latency_ms = (double)ctx->interval_latency_ns / (double)ctx->interval_returned / 1000000.0;
+		sample.latency_max_ms = (double)ctx->interval_latency_max_ns / 1000000.0;
+	}
+	ctx->interval_latency_ns = 0;
+	ctx->interval_latency_max_ns = 0;
+	ctx->interval_returned = 0;
+	pthread_mutex_unlock(&ctx->mutex);
+
+	if (ctx->soak_samples == 0) {
+		printf("\n  %-8s %9s %10s %9s %9s %11s %11s\n", "stream", "rss (MB)", "allocs", "in flight",
+		       "unmatched", "e2e (ms)", "e2e max");
+		ctx->soak_first = sample;
+	}
+	ctx->soak_last = sample;
+	ctx->soak_samples++;
+
+	uint64_t minutes = sample.stream_ms / 60000;
+	printf("  %4llu:%02llu  %9.1f %10ld %9u %9llu %11.2f %11.2f\n", (unsigned long long)(minutes / 60),
+	       (unsigned long long)(minutes % 60), (double)sample.rss_bytes / (1024.0 * 1024.0), sample.allocs,
+	       sample.in_flight, (unsigned long long)sample.unmatched, sample.latency_ms, sample.latency_max_ms);
+	fflush(stdout);
+}
+
+// Compares the last sample with the first, which is taken once everything has been set up and warmed
+static bool soak_passed(struct cli_context *ctx)
+{
+	const struct cli_options *opts = &ctx->opts;
+	const struct soak_sample *first = &ctx->soak_first;
+	const struct soak_sample *last = &ctx->soak_last;
+	if (ctx->soak_samples < 2) {
+		printf("\n  soak      too short to judge (%llu samples)\n", (unsigned long long)ctx->soak_samples);
+		return true;
+	}
+
+	bool passed = true;
+	double rss_growth_mb = ((double)last->rss_bytes - (double)first->rss_bytes) / (1024.0 * 1024.0);
+	long alloc_growth = last->allocs - first->allocs;
+	printf("\n  soak      rss %+.1f MB, allocs %+ld, in flight %+d, latency %+.2f ms over %llu samples\n",
+	       rss_growth_mb, alloc_growth, (int)last->in_flight - (int)first->in_flight,
+	       last->latency_ms - first->latency_ms, (unsigned long long)ctx->soak_samples);
+
+	if (rss_growth_mb > (double)opts->soak_max_rss_mb) {
+		printf("  FAIL      resident memory grew by more than %u MB\n", opts->soak_max_rss_mb);
+		passed = false;
+	}
+	if (alloc_growth > (long)opts->soak_max_allocs) {
+		printf("  FAIL      live allocations grew by more than %u\n", opts->soak_max_allocs);
+		passed = false;
+	}
+	// More than a second of frames queued up that were not at the start
+	if (last->in_flight > first->in_flight + opts->fps) {
+		printf("  FAIL      frames in flight grew from %u to %u\n", first->in_flight, last->in_flight);
+		passed = false;
+	}
+	if (last->latency_ms < 0.0) {
+		printf("  FAIL      no frames returned in the last interval\n");
+		passed = false;
+	} else if (first->latency_ms >= 0.0 &&
+		   last->latency_ms - first->latency_ms > (double)opts->soak_max_drift_ms) {
+		printf("  FAIL      end-to-end latency drifted by more than %u ms\n", opts->soak_max_drift_ms);
+		passed = false;
+	}
+	// Every frame comes back over loopback, so any miss is broken timestamp arithmetic (e.g. at RTP wrap)
+	if (opts->loopback && last->unmatched > 0) {
+		printf("  FAIL      %llu returned frames did not match a sent timestamp\n",
+		       (unsigned long long)last->unmatched);
+		passed = false;
+	}
+	return passed;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Endpoint probe                                                            */
+
+#if defined(DAYDREAM_PROBE_STANDIN)
+// Exit status: 0 if the selection picked the endpoint with the shortest delay within the timeout (or the
+// first when none answered) and every endpoint answered or failed as its delay says, 2 otherwise
+static int run_probe(const struct cli_options *opts)
+{
+	struct daydream_endpoints *endpoints = daydream_endpoints_create(opts->probe_delays_ms, opts->probe_count);
+	if (!endpoints) {
+		fprintf(stderr, "Could not start the local endpoints\n");
+		return 1;
+	}
+	daydream_probe_set_ca_pem(daydream_endpoints_get_ca_pem(endpoints));
+
+	struct dstr url = {0};
+	struct dstr hosts = {0};
+	dstr_printf(&url, "%s/v1/streams/stand-in/whip", daydream_endpoints_get_origin(endpoints, 0));
+	for (size_t i = 1; i < opts->probe_count; i++)
+		dstr_catf(&hosts, "%s%s", hosts.len ? "," : "", daydream_endpoints_get_origin(endpoints, i));
+
+	char *urls[PROBE_MAX_ENDPOINTS] = {NULL};
+	int64_t rtt_us[PROBE_MAX_ENDPOINTS];
+	size_t count = 0;
+	int best = daydream_probe_select(url.array, hosts.array, opts->probe_timeout_ms, urls, rtt_us,
+					 PROBE_MAX_ENDPOINTS, &count);
+
+	int expected = 0;
+	bool passed = count == opts->probe_count;
+	for (size_t i = 0; i < count; i++) {
+		uint32_t delay_ms = opts->probe_delays_ms[i];
+		bool answers = delay_ms != DAYDREAM_ENDPOINT_CLOSED && delay_ms < opts->probe_timeout_ms;
+		if (answers && (opts->probe_delays_ms[expected] >= opts->probe_timeout_ms ||
+				delay_ms < opts->probe_delays_ms[expected]))
+			expected = (int)i;
+
+		// An answer can never come sooner than the endpoint's delay
+		bool ok = answers ? rtt_us[i] >= (int64_t)delay_ms * 1000 : rtt_us[i] < 0;
+		passed = passed && ok;
+
+		if (delay_ms == DAYDREAM_ENDPOINT_CLOSED)
+			printf("  %-48s closed   ", urls[i]);
+		else
+			printf("  %-48s %5u ms ", urls[i], delay_ms);
+		if (rtt_us[i] >= 0)
+			printf("%8.1f ms%s\n", (double)rtt_us[i] / 1000.0, ok ? "" : "  (unexpected)");
+		else
+			printf("%11s%s\n", "no answer", ok ? "" : "  (unexpected)");
+	}
+	passed = passed && best == expected;
+	printf("Selected %s, expected %s: %s\n", count > 0 ? urls[best] : "nothing",
+	       count > 0 ? urls[expected] : "nothing", passed ? "pass" : "FAIL");
+
+	for (size_t i = 0; i < count; i++)
+		bfree(urls[i]);
+	dstr_free(&url);
+	dstr_free(&hosts);
+	daydream_probe_set_ca_pem(NULL);
+	daydream_endpoints_destroy(endpoints);
+	return passed ? 0 : 2;
+}
+#endif
+
+/* ------------------------------------------------------------------------- */
+/* Main loop                                                                 */
+
+static void run_pipeline(struct cli_context *ctx, struct daydream_source *src)
+{
+	const struct cli_options *opts = &ctx->opts;
+	uint64_t frame_interval_ns = 1000000000ULL / opts->fps;
+	uint64_t soak_interval_frames = (uint64_t)opts->soak_interval_min * 60 * opts->fps;
+	uint64_t start_ns = daydream_clock_now_ns();
+
+	for (uint32_t i = 0; !stop_requested && (opts->frames == 0 || i < opts->frames); i++) {
+		if (!opts->max_rate)
+			daydream_clock_sleepto_ns(start_ns + i * frame_interval_ns);
+
+		uint64_t capture_ns = daydream_clock_now_ns();
+		uint32_t linesize = 0;
+		const uint8_t *bgra = daydream_source_next(src, &linesize);
+		if (!bgra)
+			break;
+		uint64_t read_end = daydream_clock_now_ns();
+
+		// Stream time follows the frame index so max-rate runs still carry evenly spaced timestamps
+		uint32_t timestamp_ms = (uint32_t)(((uint64_t)i * 1000) / opts->fps);
+		ctx->slice_timestamp_ms = timestamp_ms;
+		ctx->slice_capture_ns = capture_ns;
+		ctx->slice_first_sent = false;
+
+		struct daydream_encoded_frame encoded;
+		bool ok = daydream_encoder_encode(ctx->encoder, bgra, linesize, &encoded);
+		uint64_t encode_end = daydream_clock_now_ns();
+
+		pthread_mutex_lock(&ctx->mutex);
+		stats_add(&ctx->read_stats, read_end - capture_ns);
+		if (ok)
+			stats_add(&ctx->encode_stats, encode_end - read_end);
+		pthread_mutex_unlock(&ctx->mutex);
+
+		if (!ok || encoded.size == 0)
+			continue;
+
+		if (!encoded.sent_as_slices && link_admit(ctx, encoded.size, encode_end)) {
+			remember_sent(ctx, daydream_whip_rtp_timestamp(timestamp_ms), capture_ns, encode_end);
+			if (ctx->whip)
+				daydream_whip_send_frame(ctx->whip, encoded.data, encoded.size, timestamp_ms,
+							 encoded.is_keyframe);
+			else
+				daydream_rtp_loopback_send(ctx->loopback, encoded.data, encoded.size, timestamp_ms);
+		}
+
+		pthread_mutex_lock(&ctx->mutex);
+		if (ctx->sent_frames == 0)
+			ctx->first_send_ns = encode_end;
+		ctx->last_send_ns = encode_end;
+		ctx->sent_frames++;
+		ctx->sent_bytes += encoded.size;
+		pthread_mutex_unlock(&ctx->mutex);
+
+		link_feedback(ctx, encode_end);
+
+		if (opts->soak_hours > 0.0 && (i + 1) % soak_interval_frames == 0)
+			soak_sample(ctx, (uint64_t)i + 1);
+	}
+
+	if (!ctx->whip)
+		return;
+
+	// Let frames still in flight come back before tearing down
+	uint64_t drain_end = daydream_clock_now_ns() + (uint64_t)opts->drain_ms * 1000000ULL;
+	while (!stop_requested && daydream_clock_now_ns() < drain_end) {
+		pthread_mutex_lock(&ctx->mutex);
+		bool done = ctx->received_frames >= ctx->sent_frames;
+		pthread_mutex_unlock(&ctx->mutex);
+		if (done)
+			break;
+		daydream_clock_sleep_ms(50);
+	}
+}
+
+static double rate_per_sec(uint64_t count, uint64_t first_ns, uint64_t last_ns)
+{
+	if (count < 2 || last_ns <= first_ns)
+		return 0.0;
+	return (double)(count - 1) * 1e9 / (double)(last_ns - first_ns);
+}
+
+static void print_report(struct cli_context *ctx)
+{
+	printf("\n  %-18s %8s %9s %9s %9s %9s\n", "stage (ms)", "count", "mean", "p50", "p95", "max");
+	stats_print(&ctx->read_stats);
+	stats_print(&ctx->encode_stats);
+	stats_print(&ctx->return_stats);
+	stats_print(&ctx->decode_stats);
+	stats_print(&ctx->total_stats);
+
+	double send_secs = (double)(ctx->last_send_ns - ctx->first_send_ns) / 1e9;
+	double recv_secs = (double)(ctx->last_receive_ns - ctx->first_receive_ns) / 1e9;
+
+	printf("\n  sent      %llu frames, %.1f fps, %.0f kbps\n", (unsigned long long)ctx->sent_frames,
+	       rate_per_sec(ctx->sent_frames, ctx->first_send_ns, ctx->last_send_ns),
+	       send_secs > 0 ? (double)ctx->sent_bytes * 8.0 / send_secs / 1000.0 : 0.0);
+	printf("  received  %llu frames, %.1f fps, %.0f kbps\n", (unsigned long long)ctx->received_frames,
+	       rate_per_sec(ctx->received_frames, ctx->first_receive_ns, ctx->last_receive_ns),
+	       recv_secs > 0 ? (double)ctx->received_bytes * 8.0 / recv_secs / 1000.0 : 0.0);
+	if (ctx->unmatched_frames > 0)
+		printf("  unmatched %llu frames (timestamp not among recently sent frames)\n",
+		       (unsigned long long)ctx->unmatched_frames);
+	if (ctx->rate_ctl) {
+		uint32_t settled = daydream_rate_controller_get_settled(ctx->rate_ctl);
+		printf("  link      %u kbps, %llu frames lost, encoder at %u kbps", ctx->opts.link_kbps,
+		       (unsigned long long)ctx->link_lost_frames, ctx->link_bitrate / 1000);
+		if (settled > 0)
+			printf(", settled at %u kbps", settled / 1000);
+		printf("\n");
+	}
+}
+
+static void print_usage(const char *argv0)
+{
+	printf("Usage: %s [options]\n"
+	       "\n"
+	       "Input:\n"
+	       "  --input FILE        Video file to stream\n"
+	       "  --pattern NAME      Synthetic input: bars (default), gradient, noise\n"
+	       "  --frames N          Stop after N frames (default: whole file, 300 for patterns)\n"
+	       "\n"
+	       "Stream:\n"
+	       "  --api-key KEY       Daydream API key (default: $DAYDREAM_API_KEY)\n"
+	       "  --prompt TEXT       Prompt for the stream\n"
+	       "  --model ID          Model id (default: stabilityai/sdxl-turbo)\n"
+	       "  --loopback          Skip the network: the encoded stream is packetized, reassembled and\n"
+	       "                      decoded locally as if returned\n"
+	       "  --video-codec NAME  Codec to offer first: auto (default), h264, vp9, av1, vp8\n"
+	       "  --size N            Stream width and height (default: 512)\n"
+	       "  --fps N             Frame rate (default: 30)\n"
+	       "  --bitrate BPS       Encoder bitrate (default: 500000)\n"
+	       "  --max-rate          Send as fast as the encoder allows instead of in real time\n"
+	       "  --sliced            Send H.264 slices as x264 finishes them (ENABLE_X264_DIRECT builds)\n"
+	       "  --drain MS          Wait for in-flight frames after the input ends (default: 3000)\n"
+	       "\n"
+	       "Simulation (with --loopback):\n"
+	       "  --sim-clock         Pace on a simulated clock: stream time passes instantly, so stage times\n"
+	       "                      read as 0 and a long run takes as long as encoding and decoding it\n"
+	       "  --link-kbps N       Drop frames beyond an N kbps link and adapt the bitrate with the plugin's\n"
+	       "                      rate controller (not with --max-rate or --sliced)\n"
+	       "\n"
+	       "Soak:\n"
+	       "  --soak HOURS        Run for HOURS of stream time (at max rate over loopback), sampling memory,\n"
+	       "                      frames in flight and end-to-end latency; exit 2 on growth or drift\n"
+	       "  --soak-interval MIN Stream minutes between samples (default: 10)\n"
+	       "  --soak-max-rss MB   Resident memory growth that fails the soak (default: 64)\n"
+	       "  --soak-max-allocs N Live allocation growth that fails the soak (default: 1000)\n"
+	       "  --soak-max-drift MS End-to-end latency drift that fails the soak (default: 20)\n"
+	       "\n"
+	       "Endpoint probe (builds with OpenSSL):\n"
+	       "  --probe DELAYS      Probe local HTTPS endpoints that hold each TLS handshake for these\n"
+	       "                      comma-separated, distinct delays in ms ('off' for a closed port), the\n"
+	       "                      first as the API's URL and the rest as alternative hosts; exit 2 unless\n"
+	       "                      the filter's selection picks the fastest\n"
+	       "  --probe-timeout MS  Handshake timeout (default: 1000, as in the filter)\n"
+	       "\n"
+	       "Output:\n"
+	       "  --output FILE       Write returned frames (.mp4 or .mkv)\n"
+	       "  --quiet             Only log warnings and errors\n",
+	       argv0);
+}
+
+static bool parse_uint(const char *value, uint32_t *out)
+{
+	char *end = NULL;
+	unsigned long v = value ? strtoul(value, &end, 10) : 0;
+	if (!value || !*value || *end)
+		return false;
+	*out = (uint32_t)v;
+	return true;
+}
+
+static bool parse_double(const char *value, double *out)
+{
+	char *end = NULL;
+	double v = value ? strtod(value, &end) : 0.0;
+	if (!value || !*value || *end || !isfinite(v) || v < 0.0)
+		return false;
+	*out = v;
+	return true;
+}
+
+static bool parse_delays(const char *value, struct cli_options *opts)
+{
+	opts->probe_count = 0;
+	for (const char *item = value; item; item = strchr(item, ',') ? strchr(item, ',') + 1 : NULL) {
+		if (opts->probe_count == PROBE_MAX_ENDPOINTS)
+			return false;
+
+		char *end = NULL;
+		uint32_t *delay_ms = &opts->probe_delays_ms[opts->probe_count++];
+		if (strncmp(item, "off", 3) == 0 && (item[3] == ',' || !item[3])) {
+			*delay_ms = DAYDREAM_ENDPOINT_CLOSED;
+			continue;
+		}
+		unsigned long v = strtoul(item, &end, 10);
+		if (end == item || (*end != ',' && *end) || v >= DAYDREAM_ENDPOINT_CLOSED)
+			return false;
+		*delay_ms = (uint32_t)v;
+	}
+	return true;
+}
+
+static bool parse_args(int argc, char **argv, struct cli_options *opts)
+{
+	opts->pattern = "bars";
+	opts->model = "stabilityai/sdxl-turbo";
+	opts->prompt = "cute shiba inu, studio ghibli style, anime, soft lighting";
+	opts->api_key = getenv("DAYDREAM_API_KEY");
+	opts->video_codec = "auto";
+	opts->size = 512;
+	opts->fps = 30;
+	opts->bitrate = 500000;
+	opts->drain_ms = 3000;
+	opts->soak_interval_min = 10;
+	opts->soak_max_rss_mb = 64;
+	opts->soak_max_allocs = 1000;
+	opts->soak_max_drift_ms = 20;
+	opts->probe_timeout_ms = PROBE_TIMEOUT_MS;
+
+	bool frames_set = false;
+
+	for (int i = 1; i < argc; i++) {
+		const char *arg = argv[i];
+		const char *value = i + 1 < argc ? argv[i + 1] : NULL;
+		bool ok = true;
+
+		if (strcmp(arg, "--help") == 0 || strcmp(arg, "-h") == 0) {
+			print_usage(argv[0]);
+			exit(0);
+		} else if (strcmp(arg, "--max-rate") == 0) {
+			opts->max_rate = true;
+			continue;
+		} else if (strcmp(arg, "--loopback") == 0) {
+			opts->loopback = true;
+			continue;
+		} else if (strcmp(arg, "--sliced") == 0) {
+			opts->sliced = true;
+			continue;
+		} else if (strcmp(arg, "--quiet") == 0) {
+			opts->quiet = true;
+			continue;
+		} else if (strcmp(arg, "--sim-clock") == 0) {
+			opts->sim_clock = true;
+			continue;
+		}
+
+		if (!value) {
+			fprintf(stderr, "Missing value for %s\n", arg);
+			return false;
+		}
+
+		if (strcmp(arg, "--input") == 0)
+			opts->input = value;
+		else if (strcmp(arg, "--pattern") == 0)
+			opts->pattern = value;
+		else if (strcmp(arg, "--output") == 0)
+			opts->output = value;
+		else if (strcmp(arg, "--api-key") == 0)
+			opts->api_key = value;
+		else if (strcmp(arg, "--prompt") == 0)
+			opts->prompt = value;
+		else if (strcmp(arg, "--model") == 0)
+			opts->model = value;
+		else if (strcmp(arg, "--video-codec") == 0) {
+			enum daydream_video_codec codec;
+			ok = strcmp(value, "auto") == 0 || daydream_video_codec_parse(value, &codec);
+			opts->video_codec = value;
+		} else if (strcmp(arg, "--frames") == 0) {
+			ok = parse_uint(value, &opts->frames);
+			frames_set = true;
+		} else if (strcmp(arg, "--size") == 0)
+			ok = parse_uint(value, &opts->size);
+		else if (strcmp(arg, "--fps") == 0)
+			ok = parse_uint(value, &opts->fps);
+		else if (strcmp(arg, "--bitrate") == 0)
+			ok = parse_uint(value, &opts->bitrate);
+		else if (strcmp(arg, "--drain") == 0)
+			ok = parse_uint(value, &opts->drain_ms);
+		else if (strcmp(arg, "--link-kbps") == 0)
+			ok = parse_uint(value, &opts->link_kbps) && opts->link_kbps > 0;
+		else if (strcmp(arg, "--soak") == 0)
+			ok = parse_double(value, &opts->soak_hours);
+		else if (strcmp(arg, "--soak-interval") == 0)
+			ok = parse_uint(value, &opts->soak_interval_min) && opts->soak_interval_min > 0;
+		else if (strcmp(arg, "--soak-max-rss") == 0)
+			ok = parse_uint(value, &opts->soak_max_rss_mb);
+		else if (strcmp(arg, "--soak-max-allocs") == 0)
+			ok = parse_uint(value, &opts->soak_max_allocs);
+		else if (strcmp(arg, "--soak-max-drift") == 0)
+			ok = parse_uint(value, &opts->soak_max_drift_ms);
+		else if (strcmp(arg, "--probe") == 0)
+			ok = parse_delays(value, opts);
+		else if (strcmp(arg, "--probe-timeout") == 0)
+			ok = parse_uint(value, &opts->probe_timeout_ms) && opts->probe_timeout_ms > 0;
+		else {
+			fprintf(stderr, "Unknown option: %s\n", arg);
+			return false;
+		}
+
+		if (!ok) {
+			fprintf(stderr, "Invalid value for %s: %s\n", arg, value);
+			return false;
+		}
+		i++;
+	}
+
+	if (opts->probe_count > 0) {
+#if !defined(DAYDREAM_PROBE_STANDIN)
+		fprintf(stderr, "--probe needs a build with OpenSSL\n");
+		return false;
+#else
+		return true;
+#endif
+	}
+
+	if (!frames_set && !opts->input)
+		opts->frames = 300;
+#if !defined(DAYDREAM_X264_DIRECT)
+	if (opts->sliced) {
+		fprintf(stderr, "--sliced needs a build with ENABLE_X264_DIRECT\n");
+		return false;
+	}
+#endif
+	if (opts->soak_hours > 0.0) {
+		double frames = opts->soak_hours * 3600.0 * opts->fps;
+		opts->frames = frames < (double)UINT32_MAX ? (uint32_t)frames : UINT32_MAX;
+		if (opts->loopback && !opts->sim_clock)
+			opts->max_rate = true;
+	}
+	if ((opts->sim_clock || opts->link_kbps > 0) && !opts->loopback) {
+		fprintf(stderr, "--sim-clock and --link-kbps need --loopback\n");
+		return false;
+	}
+	if (opts->sim_clock && opts->max_rate) {
+		fprintf(stderr, "--sim-clock already runs as fast as the pipeline allows; drop --max-rate\n");
+		return false;
+	}
+	if (opts->link_kbps > 0 && (opts->max_rate || opts->sliced)) {
+		fprintf(stderr, "--link-kbps needs paced, whole-frame sending\n");
+		return false;
+	}
+
+	if (opts->size < 64 || opts->size % 2 != 0 || opts->fps == 0) {
+		fprintf(stderr, "Size must be an even number >= 64 and fps must be positive\n");
+		return false;
+	}
+	if (!opts->loopback && (!opts->api_key || !*opts->api_key)) {
+		fprintf(stderr, "An API key is required (--api-key or DAYDREAM_API_KEY), or use --loopback\n");
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char **argv)
+{
+	struct cli_context ctx = {0};
+	if (!parse_args(argc, argv, &ctx.opts)) {
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (ctx.opts.quiet)
+		base_set_log_handler(quiet_log_handler, NULL);
+
+#if defined(DAYDREAM_PROBE_STANDIN)
+	if (ctx.opts.probe_count > 0) {
+		daydream_api_init();
+		int probe_exit_code = run_probe(&ctx.opts);
+		daydream_api_cleanup();
+		return probe_exit_code;
+	}
+#endif
+
+	signal(SIGINT, handle_sigint);
+	pthread_mutex_init(&ctx.mutex, NULL);
+	// Sleeps jump straight to their deadline: loopback runs everything on this thread
+	if (ctx.opts.sim_clock) {
+		ctx.sim_clock = daydream_sim_clock_create(os_gettime_ns(), true);
+		daydream_clock_set_simulated(ctx.sim_clock);
+	}
+	stats_init(&ctx.read_stats, "read");
+	stats_init(&ctx.encode_stats, "encode");
+	stats_init(&ctx.return_stats, ctx.opts.loopback ? "return (loopback)" : "return (net+AI)");
+	stats_init(&ctx.decode_stats, "decode");
+	stats_init(&ctx.total_stats, "end-to-end");
+
+	int exit_code = 1;
+	struct daydream_source *src =
+		daydream_source_create(ctx.opts.input, ctx.opts.pattern, ctx.opts.size, ctx.opts.size);
+	enum daydream_video_codec codecs[DAYDREAM_CODEC_COUNT];
+	size_t codec_count = daydream_video_codec_offer(ctx.opts.video_codec, codecs);
+
+	daydream_api_init();
+	if (!ctx.opts.loopback)
+		daydream_rtc_init();
+
+	if (!src)
+		goto cleanup;
+
+	if (!ctx.opts.loopback && !connect_stream(&ctx, codecs, codec_count))
+		goto cleanup;
+
+	// Over loopback the first codec of the offer stands in for what a gateway would accept
+	enum daydream_video_codec codec = ctx.whip ? daydream_whip_get_codec(ctx.whip) : codecs[0];
+	struct daydream_encoder_config encoder_config = {
+		.width = ctx.opts.size,
+		.height = ctx.opts.size,
+		.fps = ctx.opts.fps,
+		.bitrate = ctx.opts.bitrate,
+		.profile = ctx.whip ? daydream_whip_get_h264_profile(ctx.whip) : DAYDREAM_H264_BASELINE,
+		.codec = codec,
+		.on_slice = ctx.opts.sliced ? on_encoded_slice : NULL,
+		.slice_userdata = &ctx,
+	};
+	struct daydream_decoder_config decoder_config = {
+		.width = ctx.opts.size,
+		.height = ctx.opts.size,
+		.codec = codec,
+	};
+	ctx.encoder = daydream_encoder_create(&encoder_config);
+	ctx.decoder = daydream_decoder_create(&decoder_config);
+	if (!ctx.encoder || !ctx.decoder) {
+		fprintf(stderr, "Failed to create the encoder or decoder\n");
+		goto cleanup;
+	}
+	if (ctx.opts.loopback) {
+		ctx.loopback = daydream_rtp_loopback_create(codec, ctx.opts.size, ctx.opts.size, on_loopback_frame,
+							    &ctx);
+		if (!ctx.loopback) {
+			fprintf(stderr, "Failed to create the %s loopback\n", daydream_video_codec_name(codec));
+			goto cleanup;
+		}
+	}
+	if (ctx.opts.link_kbps > 0) {
+		ctx.rate_ctl = daydream_rate_controller_create(ctx.opts.bitrate);
+		ctx.link_bitrate = ctx.opts.bitrate;
+	}
+
+	if (ctx.opts.output) {
+		struct daydream_recorder_config recorder_config = {
+			.path = ctx.opts.output,
+			.width = ctx.opts.size,
+			.height = ctx.opts.size,
+			.codec = codec,
+		};
+		ctx.recorder = daydream_recorder_create(&recorder_config);
+		if (!ctx.recorder) {
+			fprintf(stderr, "Could not open %s for writing\n", ctx.opts.output);
+			goto cleanup;
+		}
+	}
+
+	bool h264 = codec == DAYDREAM_CODEC_H264;
+	printf("Streaming %s at %ux%u, %u fps%s (%s%s%s)%s\n", ctx.opts.input ? ctx.opts.input : ctx.opts.pattern,
+	       ctx.opts.size, ctx.opts.size, ctx.opts.fps, ctx.opts.max_rate ? " max rate" : "",
+	       daydream_video_codec_name(codec), h264 ? " " : "",
+	       h264 ? daydream_h264_profile_name(daydream_encoder_get_profile(ctx.encoder)) : "",
+	       ctx.opts.loopback ? " over loopback" : "");
+	if (ctx.opts.sim_clock)
+		printf("Pacing on a simulated clock\n");
+	if (ctx.rate_ctl)
+		printf("Simulating a %u kbps link\n", ctx.opts.link_kbps);
+
+	if (ctx.opts.sliced && !daydream_encoder_is_sliced(ctx.encoder))
+		fprintf(stderr, "This encoder does not deliver slices; sending whole frames\n");
+
+	run_pipeline(&ctx, src);
+	exit_code = 0;
+
+cleanup:
+	// The return path must be down before the decoder and recorder it writes to go away
+	disconnect_stream(&ctx);
+
+	if (exit_code == 0) {
+		print_report(&ctx);
+		if (ctx.opts.soak_hours > 0.0 && !soak_passed(&ctx))
+			exit_code = 2;
+	}
+
+	daydream_rate_controller_destroy(ctx.rate_ctl);
+	daydream_rtp_loopback_destroy(ctx.loopback);
+	daydream_recorder_destroy(ctx.recorder);
+	daydream_decoder_destroy(ctx.decoder);
+	daydream_encoder_destroy(ctx.encoder);
+	daydream_source_destroy(src);
+	if (!ctx.opts.loopback)
+		daydream_rtc_cleanup();
+	daydream_api_cleanup();
+
+	stats_free(&ctx.read_stats);
+	stats_free(&ctx.encode_stats);
+	stats_free(&ctx.return_stats);
+	stats_free(&ctx.decode_stats);
+	stats_free(&ctx.total_stats);
+	if (ctx.sim_clock) {
+		daydream_clock_set_simulated(NULL);
+		daydream_sim_clock_destroy(ctx.sim_clock);
+	}
+	pthread_mutex_destroy(&ctx.mutex);
+	return exit_code;
+}
@@ -0,0 +1,235 @@
+#include "daydream-endpoints.h"
+#include <util/bmem.h>
+#include <util/threading.h>
+
+#include <openssl/evp.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <netinet/in.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// How often the listeners check for shutdown while no connection is waiting
+#define ENDPOINT_POLL_MS 100
+
+struct endpoint {
+	struct daydream_endpoints *owner;
+	uint32_t delay_ms;
+	int listen_fd;
+	char origin[32];
+
+	pthread_t thread;
+	bool thread_started;
+};
+
+struct daydream_endpoints {
+	struct endpoint *list;
+	size_t count;
+
+	EVP_PKEY *key;
+	X509 *cert;
+	SSL_CTX *ssl_ctx;
+	char *ca_pem;
+
+	os_event_t *stop_event;
+};
+
+static EVP_PKEY *generate_key(void)
+{
+	EVP_PKEY *key = NULL;
+	EVP_PKEY_CTX *key_ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+	if (key_ctx && EVP_PKEY_keygen_init(key_ctx) > 0 &&
+	    EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_ctx, NID_X9_62_prime256v1) > 0)
+		EVP_PKEY_keygen(key_ctx, &key);
+	EVP_PKEY_CTX_free(key_ctx);
+	return key;
+}
+
+// Valid for 127.0.0.1 for an hour, which outlasts any probe run
+static X509 *generate_cert(EVP_PKEY *key)
+{
+	X509 *cert = X509_new();
+	if (!cert)
+		return NULL;
+
+	X509_set_version(cert, 2);
+	ASN1_INTEGER_set(X509_get_serialNumber(cert), 1);
+	X509_gmtime_adj(X509_getm_notBefore(cert), -60);
+	X509_gmtime_adj(X509_getm_notAfter(cert), 3600);
+	X509_set_pubkey(cert, key);
+
+	X509_NAME *name = X509_get_subject_name(cert);
+	X509_NAME_add_entry_by_txt(name, "CN", MBSTRING_ASC, (const unsigned char *)"127.0.0.1", -1, -1, 0);
+	X509_set_issuer_name(cert, name);
+
+	X509V3_CTX v3_ctx;
+	X509V3_set_ctx_nodb(&v3_ctx);
+	X509V3_set_ctx(&v3_ctx, cert, cert, NULL, NULL, 0);
+	X509_EXTENSION *alt_name = X509V3_EXT_conf_nid(NULL, &v3_ctx, NID_subject_alt_name, "IP:127.0.0.1");
+	X509_EXTENSION *constraints = X509V3_EXT_conf_nid(NULL, &v3_ctx, NID_basic_constraints, "critical,CA:TRUE");
+	bool ok = alt_name && constraints && X509_add_ext(cert, alt_name, -1) && X509_add_ext(cert, constraints, -1) &&
+		  X509_sign(cert, key, EVP_sha256()) > 0;
+	X509_EXTENSION_free(alt_name);
+	X509_EXTENSION_free(constraints);
+
+	if (!ok) {
+		X509_free(cert);
+		return NULL;
+	}
+	return cert;
+}
+
+static char *cert_to_pem(X509 *cert)
+{
+	BIO *bio = BIO_new(BIO_s_mem());
+	char *pem = NULL;
+	if (bio && PEM_write_bio_X509(bio, cert)) {
+		char *data = NULL;
+		long len = BIO_get_mem_data(bio, &data);
+		pem = bstrdup_n(data, (size_t)len);
+	}
+	BIO_free(bio);
+	return pem;
+}
+
+// Binds an ephemeral port on 127.0.0.1. A closed endpoint gives the port back at once, so connecting to
+// it is refused.
+static bool open_endpoint(struct endpoint *endpoint)
+{
+	endpoint->listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (endpoint->listen_fd < 0)
+		return false;
+
+	struct sockaddr_in addr = {0};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	socklen_t addr_len = sizeof(addr);
+	if (bind(endpoint->listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    getsockname(endpoint->listen_fd, (struct sockaddr *)&addr, &addr_len) != 0)
+		return false;
+
+	snprintf(endpoint->origin, sizeof(endpoint->origin), "https://127.0.0.1:%u", ntohs(addr.sin_port));
+
+	if (endpoint->delay_ms == DAYDREAM_ENDPOINT_CLOSED) {
+		close(endpoint->listen_fd);
+		endpoint->listen_fd = -1;
+		return true;
+	}
+	return listen(endpoint->listen_fd, 16) == 0;
+}
+
+static void *endpoint_thread_func(void *data)
+{
+	struct endpoint *endpoint = data;
+	struct daydream_endpoints *owner = endpoint->owner;
+
+	while (os_event_try(owner->stop_event) == EAGAIN) {
+		fd_set readable;
+		FD_ZERO(&readable);
+		FD_SET(endpoint->listen_fd, &readable);
+		struct timeval timeout = {0, ENDPOINT_POLL_MS * 1000};
+		if (select(endpoint->listen_fd + 1, &readable, NULL, NULL, &timeout) <= 0)
+			continue;
+
+		int client = accept(endpoint->listen_fd, NULL, NULL);
+		if (client < 0)
+			continue;
+
+		// The TCP handshake is done by the kernel, so the delay goes in front of the TLS one
+		if (os_event_timedwait(owner->stop_event, endpoint->delay_ms) != 0) {
+			SSL *ssl = SSL_new(owner->ssl_ctx);
+			if (ssl && SSL_set_fd(ssl, client) && SSL_accept(ssl) == 1)
+				SSL_shutdown(ssl);
+			SSL_free(ssl);
+		}
+		close(client);
+	}
+	return NULL;
+}
+
+struct daydream_endpoints *daydream_endpoints_create(const uint32_t *delays_ms, size_t count)
+{
+	if (!delays_ms || count == 0)
+		return NULL;
+
+	// A probe that gives up mid-handshake would otherwise end the process on the next write
+	signal(SIGPIPE, SIG_IGN);
+
+	struct daydream_endpoints *endpoints = bzalloc(sizeof(struct daydream_endpoints));
+	endpoints->list = bzalloc(count * sizeof(struct endpoint));
+	endpoints->count = count;
+	for (size_t i = 0; i < count; i++)
+		endpoints->list[i].listen_fd = -1;
+
+	bool ok = os_event_init(&endpoints->stop_event, OS_EVENT_TYPE_MANUAL) == 0;
+	if (ok) {
+		endpoints->key = generate_key();
+		endpoints->cert = endpoints->key ? generate_cert(endpoints->key) : NULL;
+		endpoints->ca_pem = endpoints->cert ? cert_to_pem(endpoints->cert) : NULL;
+		endpoints->ssl_ctx = endpoints->ca_pem ? SSL_CTX_new(TLS_server_method()) : NULL;
+		ok = endpoints->ssl_ctx && SSL_CTX_use_certificate(endpoints->ssl_ctx, endpoints->cert) == 1 &&
+		     SSL_CTX_use_PrivateKey(endpoints->ssl_ctx, endpoints->key) == 1;
+	}
+
+	for (size_t i = 0; ok && i < count; i++) {
+		struct endpoint *endpoint = &endpoints->list[i];
+		endpoint->owner = endpoints;
+		endpoint->delay_ms = delays_ms[i];
+		ok = open_endpoint(endpoint);
+		if (ok && endpoint->listen_fd >= 0) {
+			ok = pthread_create(&endpoint->thread, NULL, endpoint_thread_func, endpoint) == 0;
+			endpoint->thread_started = ok;
+		}
+	}
+
+	if (!ok) {
+		daydream_endpoints_destroy(endpoints);
+		return NULL;
+	}
+	return endpoints;
+}
+
+void daydream_endpoints_destroy(struct daydream_endpoints *endpoints)
+{
+	if (!endpoints)
+		return;
+
+	if (endpoints->stop_event)
+		os_event_signal(endpoints->stop_event);
+	for (size_t i = 0; i < endpoints->count; i++) {
+		struct endpoint *endpoint = &endpoints->list[i];
+		if (endpoint->thread_started)
+			pthread_join(endpoint->thread, NULL);
+		if (endpoint->listen_fd >= 0)
+			close(endpoint->listen_fd);
+	}
+
+	if (endpoints->stop_event)
+		os_event_destroy(endpoints->stop_event);
+	SSL_CTX_free(endpoints->ssl_ctx);
+	X509_free(endpoints->cert);
+	EVP_PKEY_free(endpoints->key);
+	bfree(endpoints->ca_pem);
+	bfree(endpoints->list);
+	bfree(endpoints);
+}
+
+const char *daydream_endpoints_get_origin(struct daydream_endpoints *endpoints, size_t index)
+{
+	if (!endpoints || index >= endpoints->count)
+		return NULL;
+	return endpoints->list[index].origin;
+}
+
+const char *daydream_endpoints_get_ca_pem(struct daydream_endpoints *endpoints)
+{
+	return endpoints ? endpoints->ca_pem : NULL;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Local HTTPS endpoints for exercising the gateway probe without a network.
+// Each listens on 127.0.0.1 with a shared self-signed certificate and holds
+// every connection for a fixed delay before the TLS handshake, as a distant or
+// loaded gateway would.
+struct daydream_endpoints;
+
+// Delay that leaves a closed port instead, so connections are refused
+#define DAYDREAM_ENDPOINT_CLOSED UINT32_MAX
+
+// One endpoint per entry in delays_ms
+struct daydream_endpoints *daydream_endpoints_create(const uint32_t *delays_ms, size_t count);
+void daydream_endpoints_destroy(struct daydream_endpoints *endpoints);
+
+// "https://127.0.0.1:port" of an endpoint
+const char *daydream_endpoints_get_origin(struct daydream_endpoints *endpoints, size_t index);
+
+// Certificate the endpoints present, in PEM, for daydream_probe_set_ca_pem
+const char *daydream_endpoints_get_ca_pem(struct daydream_endpoints *endpoints);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,200 @@
+#include "daydream-source.h"
+#include <util/bmem.h>
+#include <libavformat/avformat.h>
+#include <libavcodec/avcodec.h>
+#include <libswscale/swscale.h>
+
+#include <stdio.h>
+#include <string.h>
+
+struct daydream_source {
+	uint32_t width;
+	uint32_t height;
+	uint8_t *bgra;
+	uint32_t linesize;
+
+	const char *pattern;
+	uint32_t index;
+	uint32_t noise_state;
+
+	AVFormatContext *fmt;
+	AVCodecContext *codec;
+	struct SwsContext *sws;
+	AVPacket *packet;
+	AVFrame *frame;
+	int stream_index;
+	bool draining;
+};
+
+static bool source_open_file(struct daydream_source *src, const char *path)
+{
+	if (avformat_open_input(&src->fmt, path, NULL, NULL) < 0) {
+		fprintf(stderr, "Could not open %s\n", path);
+		return false;
+	}
+	if (avformat_find_stream_info(src->fmt, NULL) < 0) {
+		fprintf(stderr, "Could not read stream info from %s\n", path);
+		return false;
+	}
+
+	const AVCodec *decoder = NULL;
+	src->stream_index = av_find_best_stream(src->fmt, AVMEDIA_TYPE_VIDEO, -1, -1, &decoder, 0);
+	if (src->stream_index < 0 || !decoder) {
+		fprintf(stderr, "No decodable video stream in %s\n", path);
+		return false;
+	}
+
+	src->codec = avcodec_alloc_context3(decoder);
+	if (!src->codec ||
+	    avcodec_parameters_to_context(src->codec, src->fmt->streams[src->stream_index]->codecpar) < 0 ||
+	    avcodec_open2(src->codec, decoder, NULL) < 0) {
+		fprintf(stderr, "Could not open the video decoder for %s\n", path);
+		return false;
+	}
+
+	src->packet = av_packet_alloc();
+	src->frame = av_frame_alloc();
+	return src->packet && src->frame;
+}
+
+// Pulls the next decoded picture and scales it to the stream size
+static bool source_read_file(struct daydream_source *src)
+{
+	for (;;) {
+		int ret = avcodec_receive_frame(src->codec, src->frame);
+		if (ret == 0)
+			break;
+		if (ret != AVERROR(EAGAIN))
+			return false;
+
+		if (src->draining)
+			return false;
+
+		ret = av_read_frame(src->fmt, src->packet);
+		if (ret < 0) {
+			src->draining = true;
+			avcodec_send_packet(src->codec, NULL);
+			continue;
+		}
+
+		if (src->packet->stream_index == src->stream_index)
+			avcodec_send_packet(src->codec, src->packet);
+		av_packet_unref(src->packet);
+	}
+
+	src->sws = sws_getCachedContext(src->sws, src->frame->width, src->frame->height, src->frame->format,
+					(int)src->width, (int)src->height, AV_PIX_FMT_BGRA, SWS_BILINEAR, NULL, NULL,
+					NULL);
+	if (!src->sws) {
+		av_frame_unref(src->frame);
+		return false;
+	}
+
+	uint8_t *dst[1] = {src->bgra};
+	int dst_linesize[1] = {(int)src->linesize};
+	sws_scale(src->sws, (const uint8_t *const *)src->frame->data, src->frame->linesize, 0, src->frame->height,
+		  dst, dst_linesize);
+	av_frame_unref(src->frame);
+	return true;
+}
+
+static void source_draw_pattern(struct daydream_source *src)
+{
+	static const uint8_t bars[8][3] = {
+		{192, 192, 192}, {0, 192, 192}, {192, 192, 0}, {0, 192, 0},
+		{192, 0, 192},   {0, 0, 192},   {192, 0, 0},   {0, 0, 0},
+	};
+
+	uint32_t w = src->width;
+	uint32_t h = src->height;
+	uint32_t t = src->index;
+
+	// A box moving across the frame gives the encoder and the model some motion to work with
+	uint32_t box = h / 8;
+	uint32_t box_x = (t * 4) % (w - box);
+	uint32_t box_y = h / 2 - box / 2;
+
+	for (uint32_t y = 0; y < h; y++) {
+		uint8_t *row = src->bgra + (size_t)y * src->linesize;
+		for (uint32_t x = 0; x < w; x++) {
+			uint8_t *px = row + x * 4;
+
+			if (strcmp(src->pattern, "noise") == 0) {
+				src->noise_state ^= src->noise_state << 13;
+				src->noise_state ^= src->noise_state >> 17;
+				src->noise_state ^= src->noise_state << 5;
+				px[0] = (uint8_t)src->noise_state;
+				px[1] = (uint8_t)(src->noise_state >> 8);
+				px[2] = (uint8_t)(src->noise_state >> 16);
+			} else if (strcmp(src->pattern, "gradient") == 0) {
+				px[0] = (uint8_t)(x + t);
+				px[1] = (uint8_t)(y + t / 2);
+				px[2] = (uint8_t)((x + y) / 2 - t);
+			} else {
+				const uint8_t *c = bars[(x * 8) / w];
+				px[0] = c[0];
+				px[1] = c[1];
+				px[2] = c[2];
+			}
+
+			if (x >= box_x && x < box_x + box && y >= box_y && y < box_y + box)
+				px[0] = px[1] = px[2] = 255;
+			px[3] = 255;
+		}
+	}
+}
+
+struct daydream_source *daydream_source_create(const char *path, const char *pattern, uint32_t width, uint32_t height)
+{
+	if (!path && (!pattern || (strcmp(pattern, "bars") != 0 && strcmp(pattern, "gradient") != 0 &&
+				   strcmp(pattern, "noise") != 0))) {
+		fprintf(stderr, "Unknown pattern: %s\n", pattern ? pattern : "(none)");
+		return NULL;
+	}
+
+	struct daydream_source *src = bzalloc(sizeof(struct daydream_source));
+	src->width = width;
+	src->height = height;
+	src->linesize = width * 4;
+	src->bgra = bzalloc((size_t)src->linesize * height);
+	src->pattern = pattern;
+	src->noise_state = 0x12345678;
+	src->stream_index = -1;
+
+	if (path && !source_open_file(src, path)) {
+		daydream_source_destroy(src);
+		return NULL;
+	}
+	return src;
+}
+
+void daydream_source_destroy(struct daydream_source *src)
+{
+	if (!src)
+		return;
+
+	if (src->sws)
+		sws_freeContext(src->sws);
+	av_frame_free(&src->frame);
+	av_packet_free(&src->packet);
+	avcodec_free_context(&src->codec);
+	if (src->fmt)
+		avformat_close_input(&src->fmt);
+	bfree(src->bgra);
+	bfree(src);
+}
+
+const uint8_t *daydream_source_next(struct daydream_source *src, uint32_t *linesize)
+{
+	if (src->fmt) {
+		if (!source_read_file(src))
+			return NULL;
+	} else {
+		source_draw_pattern(src);
+	}
+
+	src->index++;
+	if (linesize)
+		*linesize = src->linesize;
+	return src->bgra;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Input frames for the command-line tools: a video file decoded and scaled with
+// FFmpeg, or a synthetic pattern ("bars", "gradient" or "noise", each with a
+// moving box so there is motion to encode).
+struct daydream_source;
+
+// path may be NULL to draw pattern instead
+struct daydream_source *daydream_source_create(const char *path, const char *pattern, uint32_t width, uint32_t height);
+void daydream_source_destroy(struct daydream_source *src);
+
+// Next BGRA frame at the requested size, or NULL at the end of the file. Valid until the next call.
+const uint8_t *daydream_source_next(struct daydream_source *src, uint32_t *linesize);
+
+#ifdef __cplusplus
+}
+#endif